@@ -16,6 +16,7 @@
 #ifndef _USUL_ALGORITHMS_SPHERE_SUB_DIVISION_H_
 #define _USUL_ALGORITHMS_SPHERE_SUB_DIVISION_H_
 
+#include <array>
 #include <cmath>
 #include <functional>
 #include <stdexcept>
@@ -34,6 +35,102 @@ namespace Sphere {
 
 namespace Details
 {
+  // The corners of the twenty faces of the icosahedron that is sub-divided.
+  template < class Real > struct Faces
+  {
+    typedef std::array < std::array < Real, 9 >, 20 > Table;
+
+    static const Table &get()
+    {
+      // Declare these constants used in the subdivision algorithm.
+      static const Real X ( static_cast < Real > ( 0.525731112119133606 ) );
+      static const Real Z ( static_cast < Real > ( 0.8506508083528655993 ) );
+      static const Real O ( static_cast < Real > ( 0 ) );
+
+      static const Table table =
+      { {
+        { { -X,  O,  Z,  X,  O,  Z,  O,  Z,  X } },
+        { { -X,  O,  Z,  O,  Z,  X, -Z,  X,  O } },
+        { { -Z,  X,  O,  O,  Z,  X,  O,  Z, -X } },
+        { {  O,  Z,  X,  Z,  X,  O,  O,  Z, -X } },
+        { {  O,  Z,  X,  X,  O,  Z,  Z,  X,  O } },
+        { {  Z,  X,  O,  X,  O,  Z,  Z, -X,  O } },
+        { {  Z,  X,  O,  Z, -X,  O,  X,  O, -Z } },
+        { {  O,  Z, -X,  Z,  X,  O,  X,  O, -Z } },
+        { {  O,  Z, -X,  X,  O, -Z, -X,  O, -Z } },
+        { { -X,  O, -Z,  X,  O, -Z,  O, -Z, -X } },
+        { {  O, -Z, -X,  X,  O, -Z,  Z, -X,  O } },
+        { {  O, -Z, -X,  Z, -X,  O,  O, -Z,  X } },
+        { {  O, -Z, -X,  O, -Z,  X, -Z, -X,  O } },
+        { { -Z, -X,  O,  O, -Z,  X, -X,  O,  Z } },
+        { { -X,  O,  Z,  O, -Z,  X,  X,  O,  Z } },
+        { {  O, -Z,  X,  Z, -X,  O,  X,  O,  Z } },
+        { { -Z,  X,  O, -Z, -X,  O, -X,  O,  Z } },
+        { { -Z,  X,  O, -X,  O, -Z, -Z, -X,  O } },
+        { { -Z,  X,  O,  O,  Z, -X, -X,  O, -Z } },
+        { {  O, -Z, -X, -Z, -X,  O, -X,  O, -Z } }
+      } };
+
+      return table;
+    }
+  };
+
+  // Make the three points between the corners of the triangle, on the sphere.
+  template < class Real >
+  inline void split (
+    Real x1, Real y1, Real z1,
+    Real x2, Real y2, Real z2,
+    Real x3, Real y3, Real z3,
+    Real &x12, Real &y12, Real &z12,
+    Real &x23, Real &y23, Real &z23,
+    Real &x31, Real &y31, Real &z31 )
+  {
+    // Make three new points.
+    x12 = x1 + x2;
+    y12 = y1 + y2;
+    z12 = z1 + z2;
+    x23 = x2 + x3;
+    y23 = y2 + y3;
+    z23 = z2 + z3;
+    x31 = x3 + x1;
+    y31 = y3 + y1;
+    z31 = z3 + z1;
+
+    // Adjust the first point.
+    const Real one ( static_cast < Real > ( 1 ) );
+    Real d ( std::sqrt ( x12 * x12 + y12 * y12 + z12 * z12 ) );
+    if ( 0 == d )
+    {
+      throw std::runtime_error ( "Error 1622864301, divide by zero" );
+    }
+    Real invd = one / d;
+    x12 *= invd;
+    y12 *= invd;
+    z12 *= invd;
+
+    // Adjust the second point.
+    d = std::sqrt ( x23 * x23 + y23 * y23 + z23 * z23 );
+    if ( 0 == d )
+    {
+      throw std::runtime_error ( "Error 3368459612, divide by zero" );
+    }
+    invd = one / d;
+    x23 *= invd;
+    y23 *= invd;
+    z23 *= invd;
+
+    // Adjust the third point.
+    d = std::sqrt ( x31 * x31 + y31 * y31 + z31 * z31 );
+    if ( 0 == d )
+    {
+      throw std::runtime_error ( "Error 2610396704, divide by zero" );
+    }
+    invd = one / d;
+    x31 *= invd;
+    y31 *= invd;
+    z31 *= invd;
+  }
+
   template < class Real, class Callback >
   inline void subdivide (
     Real x1, Real y1, Real z1,
@@ -58,50 +155,8 @@ namespace Details
     // Otherwise...
     else
     {
-      // Make three new points.
-      Real x12 = x1 + x2;
-      Real y12 = y1 + y2;
-      Real z12 = z1 + z2;
-      Real x23 = x2 + x3;
-      Real y23 = y2 + y3;
-      Real z23 = z2 + z3;
-      Real x31 = x3 + x1;
-      Real y31 = y3 + y1;
-      Real z31 = z3 + z1;
-
-      // Adjust the first point.
-      const Real one ( static_cast < Real > ( 1 ) );
-      Real d ( std::sqrt ( x12 * x12 + y12 * y12 + z12 * z12 ) );
-      if ( 0 == d )
-      {
-        throw std::runtime_error ( "Error 1622864301, divide by zero" );
-      }
-      Real invd = one / d;
-      x12 *= invd;
-      y12 *= invd;
-      z12 *= invd;
-
-      // Adjust the second point.
-      d = std::sqrt ( x23 * x23 + y23 * y23 + z23 * z23 );
-      if ( 0 == d )
-      {
-        throw std::runtime_error ( "Error 3368459612, divide by zero" );
-      }
-      invd = one / d;
-      x23 *= invd;
-      y23 *= invd;
-      z23 *= invd;
-
-      // Adjust the third point.
-      d = std::sqrt ( x31 * x31 + y31 * y31 + z31 * z31 );
-      if ( 0 == d )
-      {
-        throw std::runtime_error ( "Error 2610396704, divide by zero" );
-      }
-      invd = one / d;
-      x31 *= invd;
-      y31 *= invd;
-      z31 *= invd;
+      Real x12, y12, z12, x23, y23, z23, x31, y31, z31;
+      Details::split < Real > ( x1, y1, z1, x2, y2, z2, x3, y3, z3, x12, y12, z12, x23, y23, z23, x31, y31, z31 );
 
       // Divide again.
       --depth;
@@ -135,34 +190,16 @@ inline void generate (
     return;
   }
 
-  // Declare these constants used in the subdivision algorithm.
-  const Real X ( static_cast < Real > ( 0.525731112119133606 ) );
-  const Real Z ( static_cast < Real > ( 0.8506508083528655993 ) );
-
   // We need to count the points as we go.
   unsigned int numPoints = 0;
 
-  // Call the function to subdivide.
-  Details::subdivide < Real > ( -X,  0,  Z,  X,  0,  Z,  0,  Z,  X, numPoints, n, fun );
-  Details::subdivide < Real > ( -X,  0,  Z,  0,  Z,  X, -Z,  X,  0, numPoints, n, fun );
-  Details::subdivide < Real > ( -Z,  X,  0,  0,  Z,  X,  0,  Z, -X, numPoints, n, fun );
-  Details::subdivide < Real > (  0,  Z,  X,  Z,  X,  0,  0,  Z, -X, numPoints, n, fun );
-  Details::subdivide < Real > (  0,  Z,  X,  X,  0,  Z,  Z,  X,  0, numPoints, n, fun );
-  Details::subdivide < Real > (  Z,  X,  0,  X,  0,  Z,  Z, -X,  0, numPoints, n, fun );
-  Details::subdivide < Real > (  Z,  X,  0,  Z, -X,  0,  X,  0, -Z, numPoints, n, fun );
-  Details::subdivide < Real > (  0,  Z, -X,  Z,  X,  0,  X,  0, -Z, numPoints, n, fun );
-  Details::subdivide < Real > (  0,  Z, -X,  X,  0, -Z, -X,  0, -Z, numPoints, n, fun );
-  Details::subdivide < Real > ( -X,  0, -Z,  X,  0, -Z,  0, -Z, -X, numPoints, n, fun );
-  Details::subdivide < Real > (  0, -Z, -X,  X,  0, -Z,  Z, -X,  0, numPoints, n, fun );
-  Details::subdivide < Real > (  0, -Z, -X,  Z, -X,  0,  0, -Z,  X, numPoints, n, fun );
-  Details::subdivide < Real > (  0, -Z, -X,  0, -Z,  X, -Z, -X,  0, numPoints, n, fun );
-  Details::subdivide < Real > ( -Z, -X,  0,  0, -Z,  X, -X,  0,  Z, numPoints, n, fun );
-  Details::subdivide < Real > ( -X,  0,  Z,  0, -Z,  X,  X,  0,  Z, numPoints, n, fun );
-  Details::subdivide < Real > (  0, -Z,  X,  Z, -X,  0,  X,  0,  Z, numPoints, n, fun );
-  Details::subdivide < Real > ( -Z,  X,  0, -Z, -X,  0, -X,  0,  Z, numPoints, n, fun );
-  Details::subdivide < Real > ( -Z,  X,  0, -X,  0, -Z, -Z, -X,  0, numPoints, n, fun );
-  Details::subdivide < Real > ( -Z,  X,  0,  0,  Z, -X, -X,  0, -Z, numPoints, n, fun );
-  Details::subdivide < Real > (  0, -Z, -X, -Z, -X,  0, -X,  0, -Z, numPoints, n, fun );
+  // Call the function to subdivide each face.
+  const typename Details::Faces < Real >::Table &faces = Details::Faces < Real >::get();
+  for ( auto i = faces.begin(); i != faces.end(); ++i )
+  {
+    const std::array < Real, 9 > &c = *i;
+    Details::subdivide < Real > ( c[0], c[1], c[2], c[3], c[4], c[5], c[6], c[7], c[8], numPoints, n, fun );
+  }
 }
 
 
@@ -0,0 +1,176 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Copyright (c) 2020, Perry L Miller IV
+//  All rights reserved.
+//  MIT License: https://opensource.org/licenses/mit-license.html
+//
+///////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Sphere sub-division algorithm that runs on the job manager. It's not in
+//  Usul/Algorithms/Sphere.h so that the serial version does not depend on
+//  the jobs.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef _USUL_ALGORITHMS_SPHERE_SUB_DIVISION_JOBS_H_
+#define _USUL_ALGORITHMS_SPHERE_SUB_DIVISION_JOBS_H_
+
+#include "Usul/Algorithms/Sphere.h"
+#include "Usul/Jobs/Future.h"
+#include "Usul/Tools/ScopedCall.h"
+
+#include <algorithm>
+#include <array>
+#include <functional>
+#include <vector>
+
+
+namespace Usul {
+namespace Algorithms {
+namespace Sphere {
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Sub-divide a sphere with jobs.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+namespace Details
+{
+  // Same as the serial version but the first few levels are jobs. The
+  // first index is where the serial version would be, so both make the
+  // same triangles.
+  template < class Real, class Callback >
+  inline void subdivide (
+    Usul::Jobs::Manager *manager,
+    Real x1, Real y1, Real z1,
+    Real x2, Real y2, Real z2,
+    Real x3, Real y3, Real z3,
+    unsigned int first,
+    unsigned int depth,
+    unsigned int levels,
+    Callback fun )
+  {
+    // If there are no more levels of jobs then do the rest here.
+    if ( ( 0 == levels ) || ( 0 == depth ) )
+    {
+      Details::subdivide < Real > ( x1, y1, z1, x2, y2, z2, x3, y3, z3, first, depth, fun );
+      return;
+    }
+
+    Real x12, y12, z12, x23, y23, z23, x31, y31, z31;
+    Details::split < Real > ( x1, y1, z1, x2, y2, z2, x3, y3, z3, x12, y12, z12, x23, y23, z23, x31, y31, z31 );
+
+    // Each of the four makes this many points.
+    --depth;
+    --levels;
+    const unsigned int size = ( 3u << ( 2 * depth ) );
+
+    // Make jobs for three of them.
+    typedef Usul::Jobs::Future < void > Future;
+    const Future f1 = manager->submit ( [=] () { Details::subdivide < Real > ( manager,  x1,  y1,  z1, x12, y12, z12, x31, y31, z31, first,            depth, levels, fun ); } );
+    const Future f2 = manager->submit ( [=] () { Details::subdivide < Real > ( manager,  x2,  y2,  z2, x23, y23, z23, x12, y12, z12, first + size,     depth, levels, fun ); } );
+    const Future f3 = manager->submit ( [=] () { Details::subdivide < Real > ( manager,  x3,  y3,  z3, x31, y31, z31, x23, y23, z23, first + 2 * size, depth, levels, fun ); } );
+
+    // Do the last one here. The jobs use the callback, so we wait for them
+    // even if this throws. When this is a pool thread it runs queued jobs
+    // while it waits.
+    {
+      USUL_SCOPED_CALL ( ( [ &f1, &f2, &f3 ] ()
+      {
+        f1.wait();
+        f2.wait();
+        f3.wait();
+      } ) );
+      Details::subdivide < Real > ( manager, x12, y12, z12, x23, y23, z23, x31, y31, z31, first + 3 * size, depth, levels, fun );
+    }
+
+    // Throw the first error, if there is one.
+    f1.get();
+    f2.get();
+    f3.get();
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Make the same triangles as generate() in Usul/Algorithms/Sphere.h, but
+//  the faces are split into jobs that the manager runs. The triangles are
+//  not made in order and the callback is called from more than one thread
+//  at once, so it has to be thread-safe. Returns when all of them are made.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+template < class Real >
+inline void generate (
+  Usul::Jobs::Manager &manager,
+  unsigned int n,
+  std::function < void (
+    Real, Real, Real, Real, Real, Real, Real, Real, Real,
+    unsigned int, unsigned int, unsigned int ) > fun
+  )
+{
+  typedef std::function < void (
+    Real, Real, Real, Real, Real, Real, Real, Real, Real,
+    unsigned int, unsigned int, unsigned int ) > Callback;
+  typedef Usul::Jobs::Future < void > Future;
+
+  // Handle invalid callback.
+  if ( !fun )
+  {
+    return;
+  }
+
+  // The faces of the serial version, in the same order.
+  const typename Details::Faces < Real >::Table &faces = Details::Faces < Real >::get();
+
+  // Each face makes this many points.
+  const unsigned int size = ( 3u << ( 2 * n ) );
+
+  // Split the faces a few more times when they are big, so that there are
+  // enough jobs, but leave at least 256 triangles in each one.
+  const unsigned int levels = ( ( n > 4 ) ? std::min ( 3u, n - 4 ) : 0 );
+
+  // Make a job for each face.
+  Usul::Jobs::Manager *m = &manager;
+  std::vector < Future > futures;
+  futures.reserve ( faces.size() );
+  {
+    USUL_SCOPED_CALL ( ( [ &futures ] ()
+    {
+      for ( auto i = futures.begin(); i != futures.end(); ++i )
+      {
+        i->wait();
+      }
+    } ) );
+
+    for ( unsigned int i = 0; i < faces.size(); ++i )
+    {
+      const std::array < Real, 9 > &c = faces[i];
+      const Real x1 = c[0], y1 = c[1], z1 = c[2], x2 = c[3], y2 = c[4], z2 = c[5], x3 = c[6], y3 = c[7], z3 = c[8];
+      const unsigned int first = i * size;
+      futures.push_back ( manager.submit ( [=] ()
+      {
+        Details::subdivide < Real, Callback > ( m, x1, y1, z1, x2, y2, z2, x3, y3, z3, first, n, levels, fun );
+      } ) );
+    }
+  }
+
+  // Throw the first error, if there is one.
+  for ( auto i = futures.begin(); i != futures.end(); ++i )
+  {
+    i->get();
+  }
+}
+
+
+} // namespace Sphere
+} // namespace Algorithms
+} // namespace Usul
+
+
+#endif // _USUL_ALGORITHMS_SPHERE_SUB_DIVISION_JOBS_H_
@@ -55,4 +55,15 @@
 #endif
 
 
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Does the compiler support coroutines?
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#if ( USUL_CPP_STANDARD >= 20 ) && defined ( __cpp_impl_coroutine )
+  #define USUL_HAS_COROUTINES
+#endif
+
+
 #endif // _USUL_COMPILE_TIME_DEFINITIONS_H_
@@ -0,0 +1,290 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Copyright (c) 2020, Perry L Miller IV
+//  All rights reserved.
+//  MIT License: https://opensource.org/licenses/mit-license.html
+//
+///////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Allocator for jobs.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "Usul/Jobs/Allocator.h"
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+
+namespace Usul {
+namespace Jobs {
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  The free lists. There is one for each multiple of the size step. Each
+//  thread has its own lists, so most allocations do not lock anything. A
+//  thread with too many free blocks of a size moves some to the shared
+//  lists, and a thread without any takes some from them. This is how blocks
+//  that one thread frees get back to the thread that allocates the jobs.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+namespace { namespace Details
+{
+  const std::size_t SIZE_STEP = 64;
+  const std::size_t NUM_LISTS = MemoryPool::MAX_BLOCK_SIZE / SIZE_STEP;
+
+  // How many blocks of each size a thread keeps, and how many it moves at once.
+  const std::size_t MAX_THREAD_BLOCKS = 64;
+  const std::size_t NUM_BLOCKS_TO_MOVE = MAX_THREAD_BLOCKS / 2;
+
+  struct FreeBlock
+  {
+    FreeBlock *next;
+  };
+
+  struct FreeList
+  {
+    FreeList() : head ( nullptr ), size ( 0 ) {}
+
+    FreeBlock *pop()
+    {
+      FreeBlock *block = head;
+      if ( nullptr != block )
+      {
+        head = block->next;
+        --size;
+      }
+      return block;
+    }
+
+    void push ( FreeBlock *block )
+    {
+      block->next = head;
+      head = block;
+      ++size;
+    }
+
+    // Move up to this many blocks to the other list.
+    void move ( FreeList &to, std::size_t num )
+    {
+      for ( std::size_t i = 0; ( ( i < num ) && ( nullptr != head ) ); ++i )
+      {
+        to.push ( this->pop() );
+      }
+    }
+
+    FreeBlock *head;
+    std::size_t size;
+  };
+
+  struct ThreadLists;
+
+  struct SharedLists
+  {
+    SharedLists() : mutex(), lists(), threads() {}
+
+    // The blocks stay allocated until the program ends.
+    std::mutex mutex;
+    FreeList lists[NUM_LISTS];
+
+    // The threads' lists, so that their blocks can be counted.
+    std::vector < ThreadLists * > threads;
+  };
+
+  inline SharedLists &getSharedLists()
+  {
+    static SharedLists *lists = new SharedLists; // Never deleted, so it can be used at exit.
+    return *lists;
+  }
+
+  // Set when the thread's lists are gone, so that blocks freed after that
+  // go straight to the shared lists.
+  thread_local bool threadListsGone = false;
+
+  struct ThreadLists
+  {
+    ThreadLists() : lists(), numBlocks ( 0 )
+    {
+      SharedLists &shared = getSharedLists();
+      std::lock_guard < std::mutex > guard ( shared.mutex );
+      shared.threads.push_back ( this );
+    }
+
+    // Give the blocks to the other threads when this one ends.
+    ~ThreadLists()
+    {
+      threadListsGone = true;
+
+      SharedLists &shared = getSharedLists();
+      std::lock_guard < std::mutex > guard ( shared.mutex );
+      for ( std::size_t i = 0; i < NUM_LISTS; ++i )
+      {
+        lists[i].move ( shared.lists[i], lists[i].size );
+      }
+      shared.threads.erase ( std::find ( shared.threads.begin(), shared.threads.end(), this ) );
+    }
+
+    // Only this thread changes the lists. The number is atomic so that
+    // other threads can read it, but it does not need a locked increment.
+    void countBlocks()
+    {
+      std::size_t num = 0;
+      for ( std::size_t i = 0; i < NUM_LISTS; ++i )
+      {
+        num += lists[i].size;
+      }
+      numBlocks.store ( num, std::memory_order_relaxed );
+    }
+
+    FreeList lists[NUM_LISTS];
+    std::atomic < std::size_t > numBlocks;
+  };
+
+  inline ThreadLists *getThreadLists()
+  {
+    if ( true == threadListsGone )
+    {
+      return nullptr;
+    }
+    static thread_local ThreadLists lists;
+    return &lists;
+  }
+
+  inline std::size_t getListIndex ( std::size_t size )
+  {
+    return ( ( size + SIZE_STEP - 1 ) / SIZE_STEP ) - 1;
+  }
+} }
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Get memory.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void *MemoryPool::allocate ( std::size_t size )
+{
+  if ( ( 0 == size ) || ( size > MAX_BLOCK_SIZE ) )
+  {
+    return ::operator new ( size );
+  }
+
+  const std::size_t index = Details::getListIndex ( size );
+  Details::ThreadLists *mine = Details::getThreadLists();
+
+  // Use one of this thread's blocks if we can.
+  if ( nullptr != mine )
+  {
+    Details::FreeList &list = mine->lists[index];
+    if ( nullptr == list.head )
+    {
+      Details::SharedLists &shared = Details::getSharedLists();
+      std::lock_guard < std::mutex > guard ( shared.mutex );
+      shared.lists[index].move ( list, Details::NUM_BLOCKS_TO_MOVE );
+    }
+
+    Details::FreeBlock *block = list.pop();
+    mine->countBlocks();
+    if ( nullptr != block )
+    {
+      return block;
+    }
+  }
+
+  // Otherwise, this thread is ending, so use the shared list.
+  else
+  {
+    Details::SharedLists &shared = Details::getSharedLists();
+    std::lock_guard < std::mutex > guard ( shared.mutex );
+    Details::FreeBlock *block = shared.lists[index].pop();
+    if ( nullptr != block )
+    {
+      return block;
+    }
+  }
+
+  // If we get to here then the lists are empty.
+  return ::operator new ( ( index + 1 ) * Details::SIZE_STEP );
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Give back memory.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void MemoryPool::deallocate ( void *p, std::size_t size )
+{
+  if ( nullptr == p )
+  {
+    return;
+  }
+
+  if ( ( 0 == size ) || ( size > MAX_BLOCK_SIZE ) )
+  {
+    ::operator delete ( p );
+    return;
+  }
+
+  const std::size_t index = Details::getListIndex ( size );
+  Details::FreeBlock *block = static_cast < Details::FreeBlock * > ( p );
+  Details::ThreadLists *mine = Details::getThreadLists();
+
+  // Put it on this thread's list, and move some to the shared list if
+  // there are too many.
+  if ( nullptr != mine )
+  {
+    Details::FreeList &list = mine->lists[index];
+    list.push ( block );
+    if ( list.size > Details::MAX_THREAD_BLOCKS )
+    {
+      Details::SharedLists &shared = Details::getSharedLists();
+      std::lock_guard < std::mutex > guard ( shared.mutex );
+      list.move ( shared.lists[index], Details::NUM_BLOCKS_TO_MOVE );
+    }
+    mine->countBlocks();
+    return;
+  }
+
+  // Otherwise, this thread is ending, so use the shared list.
+  Details::SharedLists &shared = Details::getSharedLists();
+  std::lock_guard < std::mutex > guard ( shared.mutex );
+  shared.lists[index].push ( block );
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Return the number of blocks on the free lists, including those of all
+//  the threads. The threads can change theirs while we count.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+std::size_t MemoryPool::getNumFreeBlocks()
+{
+  Details::SharedLists &shared = Details::getSharedLists();
+  std::lock_guard < std::mutex > guard ( shared.mutex );
+
+  std::size_t num = 0;
+  for ( std::size_t i = 0; i < Details::NUM_LISTS; ++i )
+  {
+    num += shared.lists[i].size;
+  }
+  for ( auto i = shared.threads.begin(); i != shared.threads.end(); ++i )
+  {
+    num += (*i)->numBlocks.load ( std::memory_order_relaxed );
+  }
+  return num;
+}
+
+
+} // namespace Jobs
+} // namespace Usul
@@ -0,0 +1,117 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Copyright (c) 2020, Perry L Miller IV
+//  All rights reserved.
+//  MIT License: https://opensource.org/licenses/mit-license.html
+//
+///////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Allocator for jobs. The memory comes from free lists of fixed size
+//  blocks, so once the lists have enough blocks a new job does not use the
+//  heap. Blocks go back on the lists when they are freed. They are not
+//  given back to the system. Each thread has its own lists, so allocating
+//  and freeing do not lock anything most of the time. A thread keeps some
+//  of the blocks it frees before it shares them, so while the lists fill,
+//  the thread that makes the jobs still uses the heap now and then.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef _USUL_JOBS_ALLOCATOR_CLASS_H_
+#define _USUL_JOBS_ALLOCATOR_CLASS_H_
+
+#include "Usul/Define.h"
+#include "Usul/Export.h"
+
+#include <cstddef>
+#include <new>
+
+
+namespace Usul {
+namespace Jobs {
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  The free lists shared by all the allocators.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+struct USUL_EXPORT MemoryPool
+{
+  // Sizes bigger than this use the heap.
+  static constexpr std::size_t MAX_BLOCK_SIZE = 1024;
+
+  // Get and give back memory. The size has to be the same for both.
+  static void *allocate ( std::size_t size );
+  static void deallocate ( void *, std::size_t size );
+
+  // Return the number of blocks on the free lists.
+  static std::size_t getNumFreeBlocks();
+};
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Allocator that uses the pool. Use it with std::allocate_shared to put the
+//  job and its reference count in one pooled block.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+template < class T > class Allocator
+{
+public:
+
+  typedef T value_type;
+
+  Allocator() noexcept
+  {
+  }
+  template < class U > Allocator ( const Allocator < U > & ) noexcept
+  {
+  }
+
+  // The blocks have the alignment of operator new. A type that needs more
+  // uses the aligned operator new instead of the pool.
+  T *allocate ( std::size_t n )
+  {
+#if ( USUL_CPP_STANDARD >= 17 )
+    if ( alignof ( T ) > __STDCPP_DEFAULT_NEW_ALIGNMENT__ )
+    {
+      return static_cast < T * > ( ::operator new ( n * sizeof ( T ), std::align_val_t ( alignof ( T ) ) ) );
+    }
+#else
+    static_assert ( alignof ( T ) <= alignof ( std::max_align_t ), "Over-aligned types need C++17" );
+#endif
+    return static_cast < T * > ( MemoryPool::allocate ( n * sizeof ( T ) ) );
+  }
+
+  void deallocate ( T *p, std::size_t n ) noexcept
+  {
+#if ( USUL_CPP_STANDARD >= 17 )
+    if ( alignof ( T ) > __STDCPP_DEFAULT_NEW_ALIGNMENT__ )
+    {
+      ::operator delete ( p, std::align_val_t ( alignof ( T ) ) );
+      return;
+    }
+#endif
+    MemoryPool::deallocate ( p, n * sizeof ( T ) );
+  }
+
+  template < class U > bool operator == ( const Allocator < U > & ) const noexcept
+  {
+    return true;
+  }
+  template < class U > bool operator != ( const Allocator < U > & ) const noexcept
+  {
+    return false;
+  }
+};
+
+
+} // namespace Jobs
+} // namespace Usul
+
+
+#endif // _USUL_JOBS_ALLOCATOR_CLASS_H_
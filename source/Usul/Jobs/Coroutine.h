@@ -0,0 +1,353 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Copyright (c) 2020, Perry L Miller IV
+//  All rights reserved.
+//  MIT License: https://opensource.org/licenses/mit-license.html
+//
+///////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Coroutines that run on the job manager. Requires C++20.
+//
+//  A function that returns a Future and takes the manager as its first
+//  argument can be a coroutine:
+//
+//    Future < int > count ( Manager &manager, std::string file )
+//    {
+//      co_await manager.schedule(); // Now on a thread in the pool.
+//      const std::string text = co_await readFile ( manager, file );
+//      co_return countWords ( text );
+//    }
+//
+//  It runs in the calling thread until the first co_await. A co_await on a
+//  future frees the thread until the future's job is done, and then a job
+//  resumes the coroutine. If the job that resumes it is cleared from the
+//  queue then the co_await throws in the thread that cleared it.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef _USUL_JOBS_COROUTINE_H_
+#define _USUL_JOBS_COROUTINE_H_
+
+#include "Usul/Define.h"
+
+#ifdef USUL_HAS_COROUTINES
+
+#include "Usul/Jobs/Allocator.h"
+#include "Usul/Jobs/Future.h"
+
+#include <atomic>
+#include <coroutine>
+#include <exception>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+
+
+namespace Usul {
+namespace Jobs {
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  A job that resumes a coroutine.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+class ResumeJob : public Job
+{
+public:
+
+  typedef Job BaseClass;
+  typedef std::shared_ptr < ResumeJob > Ptr;
+
+  explicit ResumeJob ( std::coroutine_handle<> handle ) :
+    BaseClass ( [ this ] ( Job::Ptr ) { this->_resume ( false ); } ),
+    _handle ( handle ),
+    _resumed ( false ),
+    _cleared ( false )
+  {
+    // If the job is done without running then resume it anyway, so that
+    // the coroutine does not wait forever.
+    this->whenDone ( [ this ] () { this->_resume ( true ); } );
+  }
+
+  // Make the job.
+  static Ptr create ( std::coroutine_handle<> handle )
+  {
+    return std::allocate_shared < ResumeJob > ( Allocator < ResumeJob > (), handle );
+  }
+
+  // Throw if the job was done without running.
+  void throwIfCleared() const
+  {
+    if ( true == _cleared )
+    {
+      throw std::runtime_error ( "Coroutine was resumed by a job that did not run" );
+    }
+  }
+
+private:
+
+  void _resume ( bool cleared )
+  {
+    if ( false == _resumed.exchange ( true ) )
+    {
+      _cleared = cleared;
+      _handle.resume();
+    }
+  }
+
+  std::coroutine_handle<> _handle;
+  std::atomic < bool > _resumed;
+  std::atomic < bool > _cleared;
+};
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Awaitable that moves the coroutine to a thread in the pool.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+class ScheduleAwaiter
+{
+public:
+
+  explicit ScheduleAwaiter ( Manager &manager ) : _manager ( manager ), _job()
+  {
+  }
+
+  bool await_ready() const noexcept
+  {
+    return false;
+  }
+
+  void await_suspend ( std::coroutine_handle<> handle )
+  {
+    // The coroutine may be resumed before addJob() returns, so do not use
+    // the members after that.
+    _job = ResumeJob::create ( handle );
+    _manager.addJob ( _job );
+  }
+
+  void await_resume() const
+  {
+    _job->throwIfCleared();
+  }
+
+private:
+
+  Manager &_manager;
+  ResumeJob::Ptr _job;
+};
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Awaitable that resumes the coroutine when the future's job is done.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+template < class R > class FutureAwaiter
+{
+public:
+
+  typedef Future < R > FutureType;
+
+  explicit FutureAwaiter ( const FutureType &future ) : _future ( future ), _job()
+  {
+    if ( false == _future.valid() )
+    {
+      throw std::runtime_error ( "Future does not have a job" );
+    }
+  }
+
+  bool await_ready() const
+  {
+    return _future.isReady();
+  }
+
+  void await_suspend ( std::coroutine_handle<> handle )
+  {
+    // The job that resumes the coroutine waits for the future's job. No
+    // thread waits in the mean time.
+    _job = ResumeJob::create ( handle );
+    _future.getManager()->addJob ( _job, Manager::Jobs ( 1, _future.getJob() ) );
+  }
+
+  typename FutureType::GetType await_resume() const
+  {
+    if ( nullptr != _job.get() )
+    {
+      _job->throwIfCleared();
+    }
+    return _future.get();
+  }
+
+private:
+
+  FutureType _future;
+  ResumeJob::Ptr _job;
+};
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Wait for a future in a coroutine.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+template < class R > inline FutureAwaiter < R > operator co_await ( const Future < R > &future )
+{
+  return FutureAwaiter < R > ( future );
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Move the coroutine to a thread in the pool.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+inline ScheduleAwaiter Manager::schedule()
+{
+  return ScheduleAwaiter ( *this );
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  The job for a coroutine. It's not added to the manager. It's done when
+//  the coroutine returns.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+template < class R > class CoroutineJob : public ResultJob < R >
+{
+public:
+
+  typedef ResultJob < R > BaseClass;
+  typedef std::shared_ptr < CoroutineJob > Ptr;
+
+  CoroutineJob() : BaseClass ( Job::Callback() )
+  {
+  }
+
+  // Keep the value, or the exception, from the function.
+  template < class F > void call ( F &&f )
+  {
+    this->_call ( f );
+  }
+};
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  The promise of a coroutine that returns a future.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+template < class R > class FuturePromiseBase
+{
+public:
+
+  typedef CoroutineJob < R > JobType;
+
+  // The first argument of the coroutine is the manager. If the coroutine
+  // is a member function or a lambda then it's the second.
+  template < class ... Args > explicit FuturePromiseBase ( Manager &manager, Args && ... ) :
+    _manager ( manager ),
+    _job ( std::allocate_shared < JobType > ( Allocator < JobType > () ) )
+  {
+  }
+  template < class T, class ... Args > FuturePromiseBase ( T &&, Manager &manager, Args && ... ) :
+    _manager ( manager ),
+    _job ( std::allocate_shared < JobType > ( Allocator < JobType > () ) )
+  {
+  }
+
+  // The job is done after the coroutine's locals are gone.
+  ~FuturePromiseBase()
+  {
+    _job->done();
+  }
+
+  Future < R > get_return_object()
+  {
+    return Future < R > ( _manager, _job );
+  }
+
+  std::suspend_never initial_suspend() const noexcept
+  {
+    return std::suspend_never();
+  }
+
+  std::suspend_never final_suspend() const noexcept
+  {
+    return std::suspend_never();
+  }
+
+  void unhandled_exception()
+  {
+    std::exception_ptr error = std::current_exception();
+    _job->call ( [ error ] () -> R { std::rethrow_exception ( error ); } );
+  }
+
+protected:
+
+  Manager &_manager;
+  typename JobType::Ptr _job;
+};
+
+template < class R > class FuturePromise : public FuturePromiseBase < R >
+{
+public:
+
+  using FuturePromiseBase < R >::FuturePromiseBase;
+
+  template < class V > void return_value ( V &&value )
+  {
+    this->_job->call ( [ &value ] () -> R { return std::forward < V > ( value ); } );
+  }
+};
+
+template <> class FuturePromise < void > : public FuturePromiseBase < void >
+{
+public:
+
+  using FuturePromiseBase < void >::FuturePromiseBase;
+
+  void return_void()
+  {
+    this->_job->call ( [] () {} );
+  }
+};
+
+
+} // namespace Jobs
+} // namespace Usul
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Tell the compiler which promise goes with a coroutine that returns a
+//  future.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+namespace std
+{
+  template < class R, class ... Args >
+  struct coroutine_traits < Usul::Jobs::Future < R >, Args ... >
+  {
+    typedef Usul::Jobs::FuturePromise < R > promise_type;
+  };
+}
+
+
+#endif // USUL_HAS_COROUTINES
+
+
+#endif // _USUL_JOBS_COROUTINE_H_
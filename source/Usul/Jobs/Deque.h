@@ -0,0 +1,246 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Copyright (c) 2020, Perry L Miller IV
+//  All rights reserved.
+//  MIT License: https://opensource.org/licenses/mit-license.html
+//
+///////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Work-stealing deque of pointers. The owning thread pushes and pops at the
+//  bottom, and any other thread can steal from the top.
+//
+//  This is the Chase-Lev deque with the memory orders from:
+//  https://fzn.fr/readings/ppopp13.pdf
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef _USUL_JOBS_WORK_STEALING_DEQUE_CLASS_H_
+#define _USUL_JOBS_WORK_STEALING_DEQUE_CLASS_H_
+
+#include "Usul/Tools/NoCopying.h"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+
+namespace Usul {
+namespace Jobs {
+
+
+template < class T >
+class Deque : public Usul::Tools::NoCopying
+{
+public:
+
+  typedef std::int64_t Index;
+  typedef std::atomic < Index > AtomicIndex;
+  typedef std::atomic < T * > AtomicPointer;
+
+  /////////////////////////////////////////////////////////////////////////////
+  //
+  //  Constructor. The capacity should be a power of two.
+  //
+  /////////////////////////////////////////////////////////////////////////////
+
+  explicit Deque ( Index capacity = 256 ) :
+    _top ( 0 ),
+    _bottom ( 0 ),
+    _array ( nullptr ),
+    _arrays()
+  {
+    if ( ( capacity < 1 ) || ( 0 != ( capacity & ( capacity - 1 ) ) ) )
+    {
+      throw std::invalid_argument ( "Deque capacity must be a power of two" );
+    }
+
+    _arrays.push_back ( ArrayPtr ( new Array ( capacity ) ) );
+    _array.store ( _arrays.back().get(), std::memory_order_relaxed );
+  }
+
+  /////////////////////////////////////////////////////////////////////////////
+  //
+  //  Push the item onto the bottom. Only call this from the owning thread.
+  //
+  /////////////////////////////////////////////////////////////////////////////
+
+  void push ( T *item )
+  {
+    const Index b = _bottom.load ( std::memory_order_relaxed );
+    const Index t = _top.load ( std::memory_order_acquire );
+    Array *a = _array.load ( std::memory_order_relaxed );
+
+    // Grow the array if it's full. The old one stays around because
+    // another thread may be stealing from it.
+    if ( ( b - t ) > ( a->capacity() - 1 ) )
+    {
+      _arrays.push_back ( ArrayPtr ( a->grow ( b, t ) ) );
+      a = _arrays.back().get();
+      _array.store ( a, std::memory_order_release );
+    }
+
+    a->put ( b, item );
+    std::atomic_thread_fence ( std::memory_order_release );
+    _bottom.store ( b + 1, std::memory_order_relaxed );
+  }
+
+  /////////////////////////////////////////////////////////////////////////////
+  //
+  //  Pop the item from the bottom, or return null if the deque is empty.
+  //  Only call this from the owning thread.
+  //
+  /////////////////////////////////////////////////////////////////////////////
+
+  T *pop()
+  {
+    const Index b = _bottom.load ( std::memory_order_relaxed ) - 1;
+    Array *a = _array.load ( std::memory_order_relaxed );
+    _bottom.store ( b, std::memory_order_relaxed );
+    std::atomic_thread_fence ( std::memory_order_seq_cst );
+    Index t = _top.load ( std::memory_order_relaxed );
+
+    // Handle an empty deque.
+    if ( t > b )
+    {
+      _bottom.store ( b + 1, std::memory_order_relaxed );
+      return nullptr;
+    }
+
+    T *item = a->get ( b );
+
+    // If this is the last item then we race with the thieves for it.
+    if ( t == b )
+    {
+      if ( false == _top.compare_exchange_strong ( t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed ) )
+      {
+        item = nullptr;
+      }
+      _bottom.store ( b + 1, std::memory_order_relaxed );
+    }
+
+    return item;
+  }
+
+  /////////////////////////////////////////////////////////////////////////////
+  //
+  //  Steal the item from the top. Returns null if the deque is empty or if
+  //  another thread got the item first. Any thread can call this.
+  //
+  /////////////////////////////////////////////////////////////////////////////
+
+  T *steal()
+  {
+    Index t = _top.load ( std::memory_order_acquire );
+    std::atomic_thread_fence ( std::memory_order_seq_cst );
+    const Index b = _bottom.load ( std::memory_order_acquire );
+
+    // Handle an empty deque.
+    if ( t >= b )
+    {
+      return nullptr;
+    }
+
+    Array *a = _array.load ( std::memory_order_acquire );
+    T *item = a->get ( t );
+
+    // Another thread may have taken it.
+    if ( false == _top.compare_exchange_strong ( t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed ) )
+    {
+      return nullptr;
+    }
+
+    return item;
+  }
+
+  /////////////////////////////////////////////////////////////////////////////
+  //
+  //  Return the number of items. It may have changed before it's returned.
+  //
+  /////////////////////////////////////////////////////////////////////////////
+
+  Index size() const
+  {
+    const Index b = _bottom.load ( std::memory_order_relaxed );
+    const Index t = _top.load ( std::memory_order_relaxed );
+    return ( ( b > t ) ? ( b - t ) : 0 );
+  }
+
+  bool empty() const
+  {
+    return ( 0 == this->size() );
+  }
+
+private:
+
+  /////////////////////////////////////////////////////////////////////////////
+  //
+  //  Circular array of atomic pointers.
+  //
+  /////////////////////////////////////////////////////////////////////////////
+
+  class Array : public Usul::Tools::NoCopying
+  {
+  public:
+
+    explicit Array ( Index capacity ) :
+      _capacity ( capacity ),
+      _items ( new AtomicPointer[static_cast < std::size_t > ( capacity )] )
+    {
+    }
+
+    Index capacity() const
+    {
+      return _capacity;
+    }
+
+    T *get ( Index i ) const
+    {
+      return _items[this->_index ( i )].load ( std::memory_order_relaxed );
+    }
+
+    void put ( Index i, T *item )
+    {
+      _items[this->_index ( i )].store ( item, std::memory_order_relaxed );
+    }
+
+    Array *grow ( Index bottom, Index top ) const
+    {
+      Array *a = new Array ( 2 * _capacity );
+      for ( Index i = top; i < bottom; ++i )
+      {
+        a->put ( i, this->get ( i ) );
+      }
+      return a;
+    }
+
+  private:
+
+    std::size_t _index ( Index i ) const
+    {
+      return static_cast < std::size_t > ( i & ( _capacity - 1 ) );
+    }
+
+    const Index _capacity;
+    std::unique_ptr < AtomicPointer[] > _items;
+  };
+
+  typedef std::unique_ptr < Array > ArrayPtr;
+  typedef std::vector < ArrayPtr > Arrays;
+  typedef std::atomic < Array * > AtomicArray;
+
+  AtomicIndex _top;
+  AtomicIndex _bottom;
+  AtomicArray _array;
+  Arrays _arrays;
+};
+
+
+} // namespace Jobs
+} // namespace Usul
+
+
+#endif // _USUL_JOBS_WORK_STEALING_DEQUE_CLASS_H_
@@ -0,0 +1,327 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Copyright (c) 2020, Perry L Miller IV
+//  All rights reserved.
+//  MIT License: https://opensource.org/licenses/mit-license.html
+//
+///////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Jobs that return a value, and the future that gets it.
+//
+//  The value or exception is stored in the job, and the function is stored
+//  in the job too, so there is one pooled block for the whole thing.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef _USUL_JOBS_FUTURE_CLASS_H_
+#define _USUL_JOBS_FUTURE_CLASS_H_
+
+#include "Usul/Jobs/Allocator.h"
+#include "Usul/Jobs/Manager.h"
+
+#include <exception>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+
+namespace Usul {
+namespace Jobs {
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  A job that holds the value returned by its function.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+template < class R > class ResultJob : public Job
+{
+public:
+
+  typedef Job BaseClass;
+  typedef R ResultType;
+  typedef const R &GetType;
+
+  ~ResultJob()
+  {
+    if ( true == _hasValue )
+    {
+      this->_value().~R();
+    }
+  }
+
+  // Wait for the job and return the value. If the function threw then the
+  // exception is thrown here. If the job never ran then it throws.
+  GetType get() const
+  {
+    this->wait();
+
+    if ( _error )
+    {
+      std::rethrow_exception ( _error );
+    }
+
+    if ( false == _hasValue )
+    {
+      throw std::runtime_error ( "Job finished without returning a value" );
+    }
+
+    return this->_value();
+  }
+
+protected:
+
+  explicit ResultJob ( Callback cb ) : BaseClass ( cb ),
+    _storage(),
+    _hasValue ( false ),
+    _error()
+  {
+  }
+
+  // Call the function and keep what it returns or throws.
+  template < class F > void _call ( F &f )
+  {
+    try
+    {
+      new ( &_storage ) R ( f() );
+      _hasValue = true;
+    }
+    catch ( ... )
+    {
+      _error = std::current_exception();
+    }
+  }
+
+private:
+
+  const R &_value() const
+  {
+    return *reinterpret_cast < const R * > ( &_storage );
+  }
+  R &_value()
+  {
+    return *reinterpret_cast < R * > ( &_storage );
+  }
+
+  typename std::aligned_storage < sizeof ( R ), alignof ( R ) >::type _storage;
+  bool _hasValue;
+  std::exception_ptr _error;
+};
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  A job that does not return a value but may throw.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+template <> class ResultJob < void > : public Job
+{
+public:
+
+  typedef Job BaseClass;
+  typedef void ResultType;
+  typedef void GetType;
+
+  // Wait for the job. If the function threw then the exception is thrown
+  // here. If the job never ran then it throws.
+  void get() const
+  {
+    this->wait();
+
+    if ( _error )
+    {
+      std::rethrow_exception ( _error );
+    }
+
+    if ( false == _ran )
+    {
+      throw std::runtime_error ( "Job finished without running" );
+    }
+  }
+
+protected:
+
+  explicit ResultJob ( Callback cb ) : BaseClass ( cb ),
+    _ran ( false ),
+    _error()
+  {
+  }
+
+  // Call the function and keep what it throws.
+  template < class F > void _call ( F &f )
+  {
+    try
+    {
+      f();
+      _ran = true;
+    }
+    catch ( ... )
+    {
+      _error = std::current_exception();
+    }
+  }
+
+private:
+
+  bool _ran;
+  std::exception_ptr _error;
+};
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  A job that holds its function.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+template < class R, class F > class TaskJob : public ResultJob < R >
+{
+public:
+
+  typedef ResultJob < R > BaseClass;
+
+  // The callback only holds a pointer so it does not allocate.
+  template < class G > explicit TaskJob ( G &&fun ) :
+    BaseClass ( [ this ] ( Job::Ptr ) { this->_call ( _fun ); } ),
+    _fun ( std::forward < G > ( fun ) )
+  {
+  }
+
+private:
+
+  F _fun;
+};
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  The future value of a job. Copies share the same job.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+template < class R > class Future
+{
+public:
+
+  typedef ResultJob < R > JobType;
+  typedef std::shared_ptr < JobType > JobPtr;
+  typedef typename JobType::GetType GetType;
+
+  Future() : _manager ( nullptr ), _job()
+  {
+  }
+  Future ( Manager &manager, JobPtr job ) : _manager ( &manager ), _job ( job )
+  {
+  }
+
+  // Get the job.
+  JobPtr getJob() const
+  {
+    return _job;
+  }
+
+  // Get the manager that runs the job. It's null if there is no job.
+  Manager *getManager() const
+  {
+    return _manager;
+  }
+
+  // Wait for the job and return its value, or throw its exception.
+  GetType get() const
+  {
+    return this->_getJobOrThrow().get();
+  }
+
+  // Is the job done?
+  bool isReady() const
+  {
+    return this->_getJobOrThrow().isDone();
+  }
+
+  // Does this future have a job?
+  bool valid() const
+  {
+    return ( nullptr != _job.get() );
+  }
+
+  // Wait for the job to be done. The timed version returns false if the
+  // job is not done before the given number of milliseconds.
+  void wait() const
+  {
+    this->_getJobOrThrow().wait();
+  }
+  bool waitFor ( unsigned int milliseconds ) const
+  {
+    return this->_getJobOrThrow().waitFor ( milliseconds );
+  }
+
+  // Add a job that calls the function with this future when this job is
+  // done. No thread waits in the mean time.
+  template < class F >
+  auto then ( F &&fun ) const -> Future < typename std::decay < decltype ( fun ( std::declval < const Future & > () ) ) >::type >
+  {
+    typedef typename std::decay < decltype ( fun ( std::declval < const Future & > () ) ) >::type NextType;
+    typedef typename std::decay < F > ::type FunctionType;
+
+    this->_getJobOrThrow();
+
+    Future self ( *this );
+    auto call = [ self, f = FunctionType ( std::forward < F > ( fun ) ) ] () mutable { return f ( self ); };
+
+    typedef TaskJob < NextType, decltype ( call ) > TaskType;
+    std::shared_ptr < TaskType > next = std::allocate_shared < TaskType > ( Allocator < TaskType > (), std::move ( call ) );
+
+    _manager->addJob ( next, Manager::Jobs ( 1, _job ) );
+
+    return Future < NextType > ( *_manager, next );
+  }
+
+private:
+
+  const JobType &_getJobOrThrow() const
+  {
+    if ( ( nullptr == _job.get() ) || ( nullptr == _manager ) )
+    {
+      throw std::runtime_error ( "Future does not have a job" );
+    }
+    return *_job;
+  }
+
+  Manager *_manager;
+  JobPtr _job;
+};
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Add a job that calls the function and return the future value.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+template < class F >
+inline auto Manager::submit ( F &&fun ) -> Future < typename std::decay < decltype ( fun() ) >::type >
+{
+  typedef typename std::decay < decltype ( fun() ) >::type ResultType;
+  typedef TaskJob < ResultType, typename std::decay < F >::type > TaskType;
+
+  std::shared_ptr < TaskType > job = std::allocate_shared < TaskType > ( Allocator < TaskType > (), std::forward < F > ( fun ) );
+  this->addJob ( job );
+  return Future < ResultType > ( *this, job );
+}
+
+
+} // namespace Jobs
+} // namespace Usul
+
+
+// The awaitable that Manager::schedule() returns needs the future.
+#include "Usul/Jobs/Coroutine.h"
+
+
+#endif // _USUL_JOBS_FUTURE_CLASS_H_
@@ -0,0 +1,268 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Copyright (c) 2020, Perry L Miller IV
+//  All rights reserved.
+//  MIT License: https://opensource.org/licenses/mit-license.html
+//
+///////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Group of jobs.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "Usul/Jobs/Group.h"
+#include "Usul/Jobs/Manager.h"
+
+#include <chrono>
+
+
+namespace Usul {
+namespace Jobs {
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Helper functions for the packed state.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+namespace { namespace Details
+{
+  inline Group::Generation getGeneration ( std::uint64_t state )
+  {
+    return static_cast < Group::Generation > ( state >> 32 );
+  }
+  inline std::uint32_t getNumQueued ( std::uint64_t state )
+  {
+    return static_cast < std::uint32_t > ( state & 0xFFFFFFFFu );
+  }
+  inline std::uint64_t makeState ( Group::Generation generation, std::uint32_t numQueued )
+  {
+    return ( ( static_cast < std::uint64_t > ( generation ) << 32 ) | numQueued );
+  }
+} }
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Constructor
+//
+///////////////////////////////////////////////////////////////////////////////
+
+Group::Group() :
+  _state ( 0 ),
+  _numRunning ( 0 ),
+  _cancelledBefore ( 0 ),
+  _mutex(),
+  _doneCondition()
+{
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Cancel the jobs in the group.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void Group::cancel()
+{
+  // Clear the queued jobs first so that none of them start after the
+  // running ones are told to stop.
+  this->clear();
+
+  // The jobs from before the current generation are cancelled.
+  _cancelledBefore = Details::getGeneration ( _state );
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Clear the queued jobs in the group.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void Group::clear()
+{
+  std::uint64_t state = _state;
+  while ( false == _state.compare_exchange_weak ( state, Details::makeState ( Details::getGeneration ( state ) + 1, 0 ) ) )
+  {
+  }
+
+  this->_notifyIfDone();
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Get the number of jobs.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+unsigned int Group::getNumJobs() const
+{
+  return ( this->getNumJobsQueued() + this->getNumJobsRunning() );
+}
+unsigned int Group::getNumJobsQueued() const
+{
+  return Details::getNumQueued ( _state );
+}
+unsigned int Group::getNumJobsRunning() const
+{
+  return _numRunning;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Wait for the jobs in the group to be done.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void Group::wait() const
+{
+  typedef Manager::Clock Clock;
+
+  // A thread in the pool runs the jobs that this one may be waiting for.
+  if ( true == Manager::isPoolThread() )
+  {
+    Manager::helpWhileWaiting ( [ this ] () { return this->_isDone(); }, [ this ] ( Clock::duration d ) { this->_waitFor ( d ); } );
+    return;
+  }
+
+  std::unique_lock < std::mutex > lock ( _mutex );
+  _doneCondition.wait ( lock, [ this ] () { return this->_isDone(); } );
+}
+bool Group::waitFor ( unsigned int milliseconds ) const
+{
+  typedef Manager::Clock Clock;
+
+  const std::chrono::milliseconds duration ( milliseconds );
+
+  // A thread in the pool runs the jobs that this one may be waiting for.
+  if ( true == Manager::isPoolThread() )
+  {
+    return Manager::helpWhileWaiting ( [ this ] () { return this->_isDone(); }, [ this ] ( Clock::duration d ) { this->_waitFor ( d ); }, Clock::now() + duration );
+  }
+
+  return this->_waitFor ( duration );
+}
+bool Group::_waitFor ( std::chrono::steady_clock::duration duration ) const
+{
+  std::unique_lock < std::mutex > lock ( _mutex );
+  return _doneCondition.wait_for ( lock, duration, [ this ] () { return this->_isDone(); } );
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Called when a job joins the group. Returns the job's generation.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+Group::Generation Group::_jobAdded()
+{
+  return Details::getGeneration ( _state.fetch_add ( 1 ) );
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Called when a job is about to run. Returns false if the job was cleared.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+bool Group::_jobStarted ( Generation generation )
+{
+  // Count it as running first so that the group never looks done.
+  ++_numRunning;
+
+  std::uint64_t state = _state;
+  while ( generation == Details::getGeneration ( state ) )
+  {
+    if ( true == _state.compare_exchange_weak ( state, state - 1 ) )
+    {
+      return true;
+    }
+  }
+
+  // If we get to here then the job was cleared.
+  --_numRunning;
+  this->_notifyIfDone();
+  return false;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Called when a job is done, whether it ran or not.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void Group::_jobFinished ( Generation generation, bool started )
+{
+  if ( true == started )
+  {
+    --_numRunning;
+  }
+  else
+  {
+    // A cleared job was already taken out of the count.
+    std::uint64_t state = _state;
+    while ( generation == Details::getGeneration ( state ) )
+    {
+      if ( true == _state.compare_exchange_weak ( state, state - 1 ) )
+      {
+        break;
+      }
+    }
+  }
+
+  this->_notifyIfDone();
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Is the job with the given generation cancelled?
+//
+///////////////////////////////////////////////////////////////////////////////
+
+bool Group::_isCancelled ( Generation generation ) const
+{
+  return ( generation < _cancelledBefore );
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Are all the jobs done?
+//
+///////////////////////////////////////////////////////////////////////////////
+
+bool Group::_isDone() const
+{
+  return ( ( 0 == Details::getNumQueued ( _state ) ) && ( 0 == _numRunning ) );
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Wake the threads that are waiting if all the jobs are done.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void Group::_notifyIfDone()
+{
+  if ( true == this->_isDone() )
+  {
+    std::lock_guard < std::mutex > guard ( _mutex );
+    _doneCondition.notify_all();
+  }
+}
+
+
+} // namespace Jobs
+} // namespace Usul
@@ -0,0 +1,103 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Copyright (c) 2020, Perry L Miller IV
+//  All rights reserved.
+//  MIT License: https://opensource.org/licenses/mit-license.html
+//
+///////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Group of jobs that can be waited for, cancelled, and cleared without
+//  changing the other jobs in the manager.
+//
+//  Every operation is O(1). Clearing the group does not look for its jobs
+//  in the queue. Instead, the group starts a new generation, and the jobs
+//  from an older generation are skipped when they come out of the queue.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef _USUL_JOBS_GROUP_CLASS_H_
+#define _USUL_JOBS_GROUP_CLASS_H_
+
+#include "Usul/Export.h"
+#include "Usul/Config.h" // Ignore the 4251 warning.
+#include "Usul/Tools/NoCopying.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+
+
+namespace Usul {
+namespace Jobs {
+
+
+class Job;
+
+
+class USUL_EXPORT Group : public Usul::Tools::NoCopying
+{
+public:
+
+  typedef std::shared_ptr < Group > Ptr;
+  typedef std::uint32_t Generation;
+  typedef std::atomic < std::uint64_t > AtomicState;
+  typedef std::atomic < std::uint32_t > AtomicCount;
+  typedef std::atomic < Generation > AtomicGeneration;
+
+  Group();
+
+  // Cancel the jobs in the group. The queued ones will not run, and the
+  // running ones are told to stop, which is a hint. Jobs added to the
+  // group after this are not cancelled.
+  void cancel();
+
+  // Clear the queued jobs in the group. They will not run, and are marked
+  // done when they come out of the manager's queue. Running jobs are not
+  // changed. Jobs added to the group after this are not cleared.
+  void clear();
+
+  // Get the number of jobs in the group that are queued, or waiting for
+  // other jobs, and that are running.
+  unsigned int getNumJobs() const;
+  unsigned int getNumJobsQueued() const;
+  unsigned int getNumJobsRunning() const;
+
+  // Wait for the jobs in the group to be done. Cleared jobs do not count.
+  // The timed version returns false if they are not done before the given
+  // number of milliseconds. A thread in the manager's pool runs queued jobs
+  // while it waits.
+  void wait() const;
+  bool waitFor ( unsigned int milliseconds ) const;
+
+private:
+
+  friend class Job;
+
+  Generation _jobAdded();
+  bool _jobStarted ( Generation );
+  void _jobFinished ( Generation, bool started );
+  bool _isCancelled ( Generation ) const;
+
+  bool _isDone() const;
+  bool _waitFor ( std::chrono::steady_clock::duration ) const;
+  void _notifyIfDone();
+
+  // The generation is in the high bits and the number queued is in the low.
+  AtomicState _state;
+  AtomicCount _numRunning;
+  AtomicGeneration _cancelledBefore;
+  mutable std::mutex _mutex;
+  mutable std::condition_variable _doneCondition;
+};
+
+
+} // namespace Jobs
+} // namespace Usul
+
+
+#endif // _USUL_JOBS_GROUP_CLASS_H_
@@ -0,0 +1,248 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Copyright (c) 2020, Perry L Miller IV
+//  All rights reserved.
+//  MIT License: https://opensource.org/licenses/mit-license.html
+//
+///////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Histograms of durations. Values below 16 have their own buckets. Above
+//  that, each power of two is split into 16 buckets of the same width, so
+//  every 64-bit value has a bucket and the error is less than 1/16. The
+//  atomic one can be added to by any number of threads without a lock, and
+//  a copy of it is a plain one.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef _USUL_JOBS_HISTOGRAM_CLASS_H_
+#define _USUL_JOBS_HISTOGRAM_CLASS_H_
+
+#include "Usul/Tools/NoCopying.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <limits>
+
+
+namespace Usul {
+namespace Jobs {
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Histogram with plain values.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+class Histogram
+{
+public:
+
+  typedef std::uint64_t Value;
+
+  // Each power of two from 16 up has this many buckets.
+  enum { SUB_BUCKET_BITS = 4, NUM_SUB_BUCKETS = 1 << SUB_BUCKET_BITS };
+  enum { NUM_BUCKETS = NUM_SUB_BUCKETS + ( 64 - SUB_BUCKET_BITS ) * NUM_SUB_BUCKETS };
+
+  Histogram() : _buckets(), _count ( 0 ), _sum ( 0 ), _min ( 0 ), _max ( 0 )
+  {
+    std::fill ( _buckets, _buckets + NUM_BUCKETS, 0 );
+  }
+
+  // Add the value.
+  void add ( Value value )
+  {
+    ++_buckets[Histogram::getBucket ( value )];
+    _min = ( ( 0 == _count ) ? value : std::min ( _min, value ) );
+    _max = std::max ( _max, value );
+    _sum += value;
+    ++_count;
+  }
+
+  // Add the values of the other one.
+  void add ( const Histogram &h )
+  {
+    if ( 0 == h._count )
+    {
+      return;
+    }
+    for ( unsigned int i = 0; i < NUM_BUCKETS; ++i )
+    {
+      _buckets[i] += h._buckets[i];
+    }
+    _min = ( ( 0 == _count ) ? h._min : std::min ( _min, h._min ) );
+    _max = std::max ( _max, h._max );
+    _sum += h._sum;
+    _count += h._count;
+  }
+
+  // Return the bucket that the value goes in.
+  static unsigned int getBucket ( Value value )
+  {
+    if ( value < NUM_SUB_BUCKETS )
+    {
+      return static_cast < unsigned int > ( value );
+    }
+
+    // The power of two, and which part of it the value is in.
+    unsigned int power = 0;
+    for ( Value v = value; v > 1; v >>= 1 )
+    {
+      ++power;
+    }
+    const unsigned int shift = power - SUB_BUCKET_BITS;
+    const unsigned int sub = static_cast < unsigned int > ( ( value >> shift ) & ( NUM_SUB_BUCKETS - 1 ) );
+    return ( NUM_SUB_BUCKETS + shift * NUM_SUB_BUCKETS + sub );
+  }
+
+  // Return the number of values in the bucket, and the largest value that
+  // can go in it.
+  Value getBucketCount ( unsigned int bucket ) const
+  {
+    return ( ( bucket < NUM_BUCKETS ) ? _buckets[bucket] : 0 );
+  }
+  static Value getBucketLimit ( unsigned int bucket )
+  {
+    if ( bucket < NUM_SUB_BUCKETS )
+    {
+      return bucket;
+    }
+    if ( bucket >= NUM_BUCKETS - 1 )
+    {
+      return std::numeric_limits < Value >::max();
+    }
+    const unsigned int shift = ( bucket - NUM_SUB_BUCKETS ) / NUM_SUB_BUCKETS;
+    const Value sub = ( bucket - NUM_SUB_BUCKETS ) % NUM_SUB_BUCKETS;
+    return ( ( ( NUM_SUB_BUCKETS + sub + 1 ) << shift ) - 1 );
+  }
+
+  // Return the number of values, and their sum, smallest, largest, and mean.
+  // The last three are zero when there are no values.
+  Value  getCount() const { return _count; }
+  Value  getSum()   const { return _sum; }
+  Value  getMin()   const { return _min; }
+  Value  getMax()   const { return _max; }
+  double getMean()  const { return ( ( 0 == _count ) ? 0.0 : ( static_cast < double > ( _sum ) / static_cast < double > ( _count ) ) ); }
+
+  // Return the value that the given fraction of the values are at or below,
+  // like 0.99 for the 99th percentile. It's the limit of the bucket, so it
+  // may be up to 1/16 too big, but it's never more than the largest value.
+  Value getPercentile ( double fraction ) const
+  {
+    if ( 0 == _count )
+    {
+      return 0;
+    }
+
+    const double wanted = std::max ( 0.0, std::min ( 1.0, fraction ) ) * static_cast < double > ( _count );
+    Value count = 0;
+    for ( unsigned int i = 0; i < NUM_BUCKETS; ++i )
+    {
+      count += _buckets[i];
+      if ( ( count > 0 ) && ( static_cast < double > ( count ) >= wanted ) )
+      {
+        return std::max ( _min, std::min ( _max, Histogram::getBucketLimit ( i ) ) );
+      }
+    }
+    return _max;
+  }
+
+private:
+
+  friend class AtomicHistogram;
+
+  Value _buckets[NUM_BUCKETS];
+  Value _count;
+  Value _sum;
+  Value _min;
+  Value _max;
+};
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Histogram that many threads can add to without a lock. The values are
+//  added one at a time, so a copy made while they are being added may be
+//  off by the values that are part way in.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+class AtomicHistogram : public Usul::Tools::NoCopying
+{
+public:
+
+  typedef Histogram::Value Value;
+  typedef std::atomic < Value > AtomicValue;
+
+  enum { NUM_BUCKETS = Histogram::NUM_BUCKETS };
+
+  AtomicHistogram() : _buckets(), _count ( 0 ), _sum ( 0 ), _min ( std::numeric_limits < Value >::max() ), _max ( 0 )
+  {
+    for ( unsigned int i = 0; i < NUM_BUCKETS; ++i )
+    {
+      _buckets[i] = 0;
+    }
+  }
+
+  // Add the value.
+  void add ( Value value )
+  {
+    _buckets[Histogram::getBucket ( value )].fetch_add ( 1, std::memory_order_relaxed );
+    _sum.fetch_add ( value, std::memory_order_relaxed );
+
+    Value current = _min.load ( std::memory_order_relaxed );
+    while ( ( value < current ) && ( false == _min.compare_exchange_weak ( current, value, std::memory_order_relaxed ) ) ) {}
+
+    current = _max.load ( std::memory_order_relaxed );
+    while ( ( value > current ) && ( false == _max.compare_exchange_weak ( current, value, std::memory_order_relaxed ) ) ) {}
+
+    // Last, so that a copy with this count has the rest.
+    _count.fetch_add ( 1, std::memory_order_release );
+  }
+
+  // Remove all the values.
+  void clear()
+  {
+    _count.store ( 0, std::memory_order_relaxed );
+    for ( unsigned int i = 0; i < NUM_BUCKETS; ++i )
+    {
+      _buckets[i].store ( 0, std::memory_order_relaxed );
+    }
+    _sum.store ( 0, std::memory_order_relaxed );
+    _min.store ( std::numeric_limits < Value >::max(), std::memory_order_relaxed );
+    _max.store ( 0, std::memory_order_relaxed );
+  }
+
+  // Return a copy.
+  Histogram get() const
+  {
+    Histogram h;
+    h._count = _count.load ( std::memory_order_acquire );
+    for ( unsigned int i = 0; i < NUM_BUCKETS; ++i )
+    {
+      h._buckets[i] = _buckets[i].load ( std::memory_order_relaxed );
+    }
+    h._sum = _sum.load ( std::memory_order_relaxed );
+    h._max = _max.load ( std::memory_order_relaxed );
+    h._min = ( ( 0 == h._count ) ? 0 : std::min ( h._max, _min.load ( std::memory_order_relaxed ) ) );
+    return h;
+  }
+
+private:
+
+  AtomicValue _buckets[NUM_BUCKETS];
+  AtomicValue _count;
+  AtomicValue _sum;
+  AtomicValue _min;
+  AtomicValue _max;
+};
+
+
+} // namespace Jobs
+} // namespace Usul
+
+
+#endif // _USUL_JOBS_HISTOGRAM_CLASS_H_
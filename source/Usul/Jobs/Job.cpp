@@ -14,7 +14,17 @@
 ///////////////////////////////////////////////////////////////////////////////
 
 #include "Usul/Jobs/Job.h"
+#include "Usul/Jobs/Manager.h"
+#include "Usul/Jobs/Queue.h"
 #include "Usul/Tools/Counter.h"
+#include "Usul/Tools/NoThrow.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <stdexcept>
+#include <utility>
 
 
 namespace Usul {
@@ -33,6 +43,47 @@ namespace { namespace Details
 } }
 
 
+///////////////////////////////////////////////////////////////////////////////
+//
+//  The jobs do not have a mutex. A thread that waits for a job uses one of
+//  these instead, picked by the job's address. Jobs that share one only
+//  cause extra wake ups.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+namespace { namespace Details
+{
+  struct WaitSlot
+  {
+    std::mutex mutex;
+    std::condition_variable condition;
+  };
+
+  inline WaitSlot &getWaitSlot ( const void *address )
+  {
+    static WaitSlot slots[64];
+    const std::uintptr_t i = reinterpret_cast < std::uintptr_t > ( address );
+    return slots[( i >> 6 ) % 64];
+  }
+} }
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  The end of the list of done callbacks once the job is done.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+namespace { namespace Details
+{
+  inline void *getClosedList()
+  {
+    static char closed = 0;
+    return &closed;
+  }
+} }
+
+
 ///////////////////////////////////////////////////////////////////////////////
 //
 //  Constructors
@@ -40,13 +91,22 @@ namespace { namespace Details
 ///////////////////////////////////////////////////////////////////////////////
 
 Job::Job ( const std::string &name, double priority, Callback cb ) :
-  _mutex(),
   _id ( Details::getNextJobID() ),
   _name ( name ),
   _priority ( priority ),
+  _deadline ( TimePoint::max().time_since_epoch().count() ),
   _callback ( cb ),
-  _cancelled ( false ),
-  _done ( false )
+  _state ( 0 ),
+  _doneCallbacks ( nullptr ),
+  _keepAlive(),
+  _queue ( nullptr ),
+  _queueIndex ( 0 ),
+  _numPredecessors ( 0 ),
+  _group(),
+  _groupGeneration ( 0 ),
+  _lane ( 0 ),
+  _addedTime(),
+  _queuedTime()
 {
 }
 Job::Job ( const std::string &name, Callback cb ) : Job ( name, 0, cb )
@@ -57,6 +117,25 @@ Job::Job ( Callback cb ) : Job ( std::string(), 0, cb )
 }
 
 
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Destructor
+//
+///////////////////////////////////////////////////////////////////////////////
+
+Job::~Job()
+{
+  // Delete the callbacks of a job that was never done.
+  DoneNode *node = _doneCallbacks.load ( std::memory_order_acquire );
+  while ( ( nullptr != node ) && ( Details::getClosedList() != static_cast < void * > ( node ) ) )
+  {
+    DoneNode *next = node->next;
+    delete node;
+    node = next;
+  }
+}
+
+
 ///////////////////////////////////////////////////////////////////////////////
 //
 //  Get/set the flag that says we are cancelled.
@@ -66,13 +145,15 @@ Job::Job ( Callback cb ) : Job ( std::string(), 0, cb )
 
 void Job::cancel()
 {
-  Guard guard ( _mutex );
-  _cancelled = true;
+  _state.fetch_or ( STATE_CANCELLED, std::memory_order_release );
 }
 bool Job::isCancelled() const
 {
-  Guard guard ( _mutex );
-  return _cancelled;
+  if ( 0 != ( _state.load ( std::memory_order_acquire ) & STATE_CANCELLED ) )
+  {
+    return true;
+  }
+  return ( ( nullptr != _group.get() ) && ( true == _group->_isCancelled ( _groupGeneration ) ) );
 }
 
 
@@ -84,13 +165,224 @@ bool Job::isCancelled() const
 
 void Job::done()
 {
-  Guard guard ( _mutex );
-  _done = true;
+  const unsigned int state = _state.fetch_or ( STATE_DONE, std::memory_order_acq_rel );
+
+  // Handle being called again.
+  if ( 0 != ( state & STATE_DONE ) )
+  {
+    return;
+  }
+
+  // Wake the threads waiting for this job. Locking makes sure that a
+  // waiter that saw the old state is waiting before we notify.
+  if ( 0 != ( state & STATE_WAITING ) )
+  {
+    Details::WaitSlot &slot = Details::getWaitSlot ( this );
+    std::lock_guard < std::mutex > guard ( slot.mutex );
+    slot.condition.notify_all();
+  }
+
+  // Take the callbacks, and close the list so that whenDone() calls the
+  // ones that come later.
+  DoneNode *node = _doneCallbacks.exchange ( static_cast < DoneNode * > ( Details::getClosedList() ), std::memory_order_acq_rel );
+
+  // They were pushed onto the front, so reverse them.
+  DoneNode *callbacks = nullptr;
+  while ( nullptr != node )
+  {
+    DoneNode *next = node->next;
+    node->next = callbacks;
+    callbacks = node;
+    node = next;
+  }
+
+  // Call them in the order they were added.
+  while ( nullptr != callbacks )
+  {
+    std::unique_ptr < DoneNode > current ( callbacks );
+    callbacks = current->next;
+    USUL_TOOLS_NO_THROW ( 1700412650, current->fun );
+  }
+
+  // Tell the group last so that waiting for it means the callbacks ran.
+  if ( nullptr != _group.get() )
+  {
+    _group->_jobFinished ( _groupGeneration, ( 0 != ( state & STATE_RUNNING ) ) );
+  }
 }
 bool Job::isDone() const
 {
-  Guard guard ( _mutex );
-  return _done;
+  return ( 0 != ( _state.load ( std::memory_order_acquire ) & STATE_DONE ) );
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Has the job started running?
+//
+///////////////////////////////////////////////////////////////////////////////
+
+bool Job::hasStarted() const
+{
+  return ( 0 != ( _state.load ( std::memory_order_acquire ) & STATE_RUNNING ) );
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Wait for the job to be done.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void Job::wait() const
+{
+  // Handle the job being done without locking.
+  if ( true == this->isDone() )
+  {
+    return;
+  }
+
+  // A thread in the pool runs the jobs that this one may be waiting for.
+  if ( true == Manager::isPoolThread() )
+  {
+    Manager::helpWhileWaiting ( [ this ] () { return this->isDone(); }, [ this ] ( Clock::duration d ) { this->_waitFor ( d ); }, TimePoint::max(), this );
+    return;
+  }
+
+  Details::WaitSlot &slot = Details::getWaitSlot ( this );
+  std::unique_lock < std::mutex > lock ( slot.mutex );
+  slot.condition.wait ( lock, [ this ] ()
+  {
+    return ( 0 != ( _state.fetch_or ( STATE_WAITING, std::memory_order_acq_rel ) & STATE_DONE ) );
+  } );
+}
+bool Job::waitFor ( unsigned int milliseconds ) const
+{
+  if ( true == this->isDone() )
+  {
+    return true;
+  }
+
+  const std::chrono::milliseconds duration ( milliseconds );
+
+  // A thread in the pool runs the jobs that this one may be waiting for.
+  if ( true == Manager::isPoolThread() )
+  {
+    return Manager::helpWhileWaiting ( [ this ] () { return this->isDone(); }, [ this ] ( Clock::duration d ) { this->_waitFor ( d ); }, Clock::now() + duration, this );
+  }
+
+  return this->_waitFor ( duration );
+}
+bool Job::_waitFor ( Clock::duration duration ) const
+{
+  Details::WaitSlot &slot = Details::getWaitSlot ( this );
+  std::unique_lock < std::mutex > lock ( slot.mutex );
+  return slot.condition.wait_for ( lock, duration, [ this ] ()
+  {
+    return ( 0 != ( _state.fetch_or ( STATE_WAITING, std::memory_order_acq_rel ) & STATE_DONE ) );
+  } );
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Call the function when the job is done.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void Job::whenDone ( DoneCallback fun )
+{
+  if ( !fun )
+  {
+    return;
+  }
+
+  std::unique_ptr < DoneNode > node ( new DoneNode );
+  node->fun = std::move ( fun );
+  node->next = _doneCallbacks.load ( std::memory_order_acquire );
+
+  // Push it onto the front unless the job is done.
+  while ( Details::getClosedList() != static_cast < void * > ( node->next ) )
+  {
+    if ( true == _doneCallbacks.compare_exchange_weak ( node->next, node.get(), std::memory_order_acq_rel, std::memory_order_acquire ) )
+    {
+      node.release();
+      return;
+    }
+  }
+
+  // If we get to here then the job is already done.
+  USUL_TOOLS_NO_THROW ( 1700412651, node->fun );
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Get/set the group.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+Job::GroupPtr Job::getGroup() const
+{
+  return _group;
+}
+void Job::setGroup ( GroupPtr group )
+{
+  if ( nullptr == group.get() )
+  {
+    throw std::invalid_argument ( "Null group given to job" );
+  }
+
+  const unsigned int state = _state.fetch_or ( STATE_GROUPED, std::memory_order_acq_rel );
+
+  if ( 0 != ( state & STATE_GROUPED ) )
+  {
+    throw std::runtime_error ( "Job is already in a group" );
+  }
+
+  if ( 0 != ( state & STATE_DONE ) )
+  {
+    _state.fetch_and ( ~static_cast < unsigned int > ( STATE_GROUPED ), std::memory_order_release );
+    throw std::runtime_error ( "Job is already done" );
+  }
+
+  _group = group;
+  _groupGeneration = group->_jobAdded();
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Get/set the lane.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+unsigned int Job::getLane() const
+{
+  return _lane;
+}
+void Job::setLane ( unsigned int lane )
+{
+  _lane = lane;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Called by the manager just before the job runs. Returns false if the
+//  job's group cleared it.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+bool Job::_start()
+{
+  if ( ( nullptr != _group.get() ) && ( false == _group->_jobStarted ( _groupGeneration ) ) )
+  {
+    return false;
+  }
+
+  _state.fetch_or ( STATE_RUNNING, std::memory_order_acq_rel );
+  return true;
 }
 
 
@@ -107,6 +399,44 @@ double Job::getPriority() const
 void Job::setPriority ( double priority )
 {
   _priority = priority; // This is atomic.
+
+  // Do not lock the mutex here because the queue may need it.
+  Queue *queue = _queue; // This is atomic.
+  if ( nullptr != queue )
+  {
+    queue->update ( *this );
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Get/set the deadline.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+Job::TimePoint Job::getDeadline() const
+{
+  return TimePoint ( Clock::duration ( _deadline.load() ) );
+}
+bool Job::hasDeadline() const
+{
+  return ( TimePoint::max() != this->getDeadline() );
+}
+void Job::setDeadline ( TimePoint deadline )
+{
+  _deadline = deadline.time_since_epoch().count(); // This is atomic.
+
+  // Do not lock the mutex here because the queue may need it.
+  Queue *queue = _queue; // This is atomic.
+  if ( nullptr != queue )
+  {
+    queue->update ( *this );
+  }
+}
+void Job::clearDeadline()
+{
+  this->setDeadline ( TimePoint::max() );
 }
 
 
@@ -116,10 +446,9 @@ void Job::setPriority ( double priority )
 //
 ///////////////////////////////////////////////////////////////////////////////
 
-Job::Callback Job::getCallback()
+const Job::Callback &Job::getCallback() const
 {
-  Guard guard ( _mutex );
-  return _callback;
+  return _callback; // It does not change.
 }
 
 
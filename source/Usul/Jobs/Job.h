@@ -18,11 +18,12 @@
 
 #include "Usul/Export.h"
 #include "Usul/Config.h" // Ignore the 4251 warning.
+#include "Usul/Jobs/Group.h"
 
 #include <atomic>
+#include <chrono>
 #include <functional>
 #include <memory>
-#include <mutex>
 #include <string>
 
 
@@ -30,23 +31,30 @@ namespace Usul {
 namespace Jobs {
 
 
+class Queue;
+
+
 class USUL_EXPORT Job
 {
 public:
 
-  typedef std::recursive_mutex Mutex;
-  typedef std::lock_guard < Mutex > Guard;
   typedef std::shared_ptr < Job > Ptr;
   typedef std::function < void ( Ptr ) > Callback;
   typedef std::atomic < double > AtomicDouble;
+  typedef std::atomic < unsigned int > AtomicState;
+  typedef std::function < void () > DoneCallback;
+  typedef Group::Ptr GroupPtr;
+  typedef std::chrono::steady_clock Clock;
+  typedef Clock::time_point TimePoint;
 
-  // Constructors
+  // Constructors and destructor.
   Job ( const std::string &name, double priority, Callback );
   Job ( const std::string &name, Callback );
   explicit Job ( Callback cb = Callback() );
+  ~Job();
 
-  // Get/set the flag that says we are cancelled.
-  // This is a hint; the job can ignore it.
+  // Get/set the flag that says we are cancelled. The job is also cancelled
+  // when its group is. This is a hint; the job can ignore it.
   void cancel();
   bool isCancelled() const;
 
@@ -54,28 +62,97 @@ public:
   void done();
   bool isDone() const;
 
+  // Has the job started running? It stays true after the job is done.
+  bool hasStarted() const;
+
+  // Wait for the job to be done. The timed version returns false if the
+  // job is not done before the given number of milliseconds. A thread in
+  // the manager's pool runs queued jobs while it waits.
+  void wait() const;
+  bool waitFor ( unsigned int milliseconds ) const;
+
+  // Call the function when the job is done, in the thread that marks it
+  // done. If the job is already done then it's called now. The function
+  // should be quick and should not throw.
+  void whenDone ( DoneCallback );
+
+  // Get/set the group. Set it before adding the job to the manager.
+  // Throws if the job is already in a group.
+  GroupPtr getGroup() const;
+  void     setGroup ( GroupPtr );
+
   // Get the id.
   unsigned long getID() const { return _id; } // No need to guard.
 
   // Get the name.
   std::string getName() const { return _name; } // No need to guard.
 
-  // Get/set the priority.
+  // Get/set the priority. If the job is queued then it moves to where the
+  // new priority says it should be.
   double getPriority() const;
   void   setPriority ( double );
 
-  // Get the callback.
-  Callback getCallback();
+  // Get/set the time that the job should start by. The queue uses it when
+  // its policy is Queue::POLICY_DEADLINE. If the job is queued then it
+  // moves to where the new deadline says it should be. Jobs without one
+  // come after all the jobs with one.
+  TimePoint getDeadline() const;
+  bool      hasDeadline() const;
+  void      setDeadline ( TimePoint );
+  void      clearDeadline();
+
+  // Get/set the manager's lane that the job runs in. Zero is the default
+  // lane. Set it before adding the job. See Manager::addLane().
+  unsigned int getLane() const;
+  void         setLane ( unsigned int );
+
+  // Get the callback. It does not change, so it's not copied.
+  const Callback &getCallback() const;
 
 private:
 
-  mutable Mutex _mutex;
+  friend class Manager;
+  friend class Queue;
+
+  // The bits of the state.
+  enum State
+  {
+    STATE_CANCELLED = 0x01,
+    STATE_RUNNING   = 0x02,
+    STATE_DONE      = 0x04,
+    STATE_WAITING   = 0x08, // A thread may be waiting for it to be done.
+    STATE_GROUPED   = 0x10,
+    STATE_SUBMITTED = 0x20  // In the ring or a deque, on the way to running.
+  };
+
+  // The functions to call when the job is done, in a list that's pushed
+  // onto without a lock.
+  struct DoneNode
+  {
+    DoneCallback fun;
+    DoneNode *next;
+  };
+  typedef std::atomic < DoneNode * > AtomicDoneNode;
+
+  bool _start();
+  bool _waitFor ( Clock::duration ) const;
+
   const unsigned long _id;
   const std::string _name;
   AtomicDouble _priority;
-  Callback _callback;
-  bool _cancelled;
-  bool _done;
+  std::atomic < Clock::rep > _deadline; // The maximum means there is none.
+  const Callback _callback;
+  mutable AtomicState _state; // Waiting sets a bit, so it changes in const functions.
+  AtomicDoneNode _doneCallbacks;
+  Ptr _keepAlive; // Used by the manager when the job is in a deque.
+  std::atomic < Queue * > _queue; // The queue the job is in, if any.
+  std::size_t _queueIndex; // Where the job is in the queue. Guarded by the queue.
+  std::atomic < unsigned int > _numPredecessors; // Jobs to wait for before it's queued.
+  GroupPtr _group; // Set before the job is added, then it does not change.
+  Group::Generation _groupGeneration;
+  unsigned int _lane; // Set before the job is added, then it does not change.
+  TimePoint _addedTime; // When the manager got it, if it's recording times.
+  TimePoint _queuedTime; // When it was ready to run, if it's recording times.
 };
 
 
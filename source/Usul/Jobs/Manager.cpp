@@ -14,13 +14,18 @@
 ///////////////////////////////////////////////////////////////////////////////
 
 #include "Usul/Jobs/Manager.h"
+#include "Usul/Jobs/Allocator.h"
 #include "Usul/Errors/Check.h"
+#include "Usul/System/Processors.h"
 #include "Usul/Tools/NoThrow.h"
 #include "Usul/Tools/ScopedCall.h"
 
 #include <algorithm>
 #include <chrono>
+#include <cmath>
 #include <functional>
+#include <iterator>
+#include <memory>
 #include <sstream>
 #include <stdexcept>
 
@@ -52,8 +57,9 @@ namespace { namespace Details
     // Keep one available for the worker as well as any user-interface thread.
     const unsigned int keep = 2u;
 
-    // This is how many threads the hardware can run at the same time.
-    const unsigned int has = std::thread::hardware_concurrency();
+    // This is how many threads we can run at the same time. In a container
+    // it's less than the hardware has.
+    const unsigned int has = Usul::System::Processors::getNumAvailable();
 
     // If we can, return the difference, otherwise return the bare minimum.
     return ( ( has > keep ) ? ( has - keep ) : 1u );
@@ -61,6 +67,83 @@ namespace { namespace Details
 } }
 
 
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Return the processors that the thread in the pool should run on. The
+//  threads are spread over the processors, or the nodes, in turn.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+namespace { namespace Details
+{
+  typedef Usul::System::Processors::Indices ProcessorIndices;
+
+  inline ProcessorIndices getPoolThreadProcessors ( Manager::Affinity affinity, unsigned int index, const ProcessorIndices &available )
+  {
+    typedef Usul::System::Processors Processors;
+
+    if ( true == available.empty() )
+    {
+      return available;
+    }
+
+    if ( Manager::AFFINITY_PROCESSOR == affinity )
+    {
+      return ProcessorIndices ( 1, available.at ( index % available.size() ) );
+    }
+
+    if ( Manager::AFFINITY_NODE == affinity )
+    {
+      // Skip the nodes that this thread can not use.
+      const unsigned int numNodes = Processors::getNumNodes();
+      for ( unsigned int i = 0; i < numNodes; ++i )
+      {
+        ProcessorIndices processors;
+        const ProcessorIndices node = Processors::getNodeProcessors ( ( index + i ) % numNodes );
+        std::copy_if ( node.begin(), node.end(), std::back_inserter ( processors ), [ &available ] ( unsigned int p )
+        {
+          return ( available.end() != std::find ( available.begin(), available.end(), p ) );
+        } );
+        if ( false == processors.empty() )
+        {
+          return processors;
+        }
+      }
+    }
+
+    return available;
+  }
+} }
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  The name of the default lane, and of the mutex in the trace.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+namespace { namespace Details
+{
+  const std::string defaultLaneName ( "default" );
+  const std::string mutexName ( "mutex" );
+} }
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  The manager and pool thread of the calling thread, if any, and how many
+//  jobs it's running inside each other while it waits.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+namespace { namespace Details
+{
+  thread_local Manager *currentManager = nullptr;
+  thread_local Manager::PoolThread *currentPoolThread = nullptr;
+  thread_local unsigned int helpDepth = 0;
+} }
+
+
 ///////////////////////////////////////////////////////////////////////////////
 //
 //  Helper functions to handle standard exception.
@@ -110,6 +193,61 @@ namespace { namespace Details
 } }
 
 
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Make a job. The job and its reference count are one pooled block.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+namespace { namespace Details
+{
+  inline Manager::JobPtr makeJob ( const Manager::Callback &cb )
+  {
+    return std::allocate_shared < Job > ( Usul::Jobs::Allocator < Job > (), cb );
+  }
+} }
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  See if the job should be run.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+namespace { namespace Details
+{
+  inline bool shouldRunJob ( const Manager::JobPtr &job )
+  {
+    // This means the queue is empty.
+    if ( nullptr == job.get() )
+    {
+      return false;
+    }
+
+    // If the job does not have a callback function then skip it.
+    if ( !job->getCallback() )
+    {
+      return false;
+    }
+
+    // If the job has been cancelled then skip it.
+    if ( true == job->isCancelled() )
+    {
+      return false;
+    }
+
+    // If for some reason the job is done then skip it.
+    if ( true == job->isDone() )
+    {
+      return false;
+    }
+
+    // If we get to here then run the job.
+    return true;
+  }
+} }
+
+
 ///////////////////////////////////////////////////////////////////////////////
 //
 //  Function to sleep some to hopefully side-step a somewhat rare crash
@@ -154,12 +292,60 @@ Manager::Manager() :
   _mutex(),
   _workerThread(),
   _workerID(),
-  _queuedJobs(),
+  _queuedJobs ( _mutex ),
+  _submissions(),
   _runningJobs(),
+  _poolThreads(),
+  _poolTables(),
+  _poolTable ( nullptr ),
+  _lanes(),
+  _numLanes ( 1 ),
+  _numJobsInLanes ( 0 ),
+  _numJobsRunningInLanes ( 0 ),
   _errorHandler(),
+  _wakeCondition(),
+  _parkCondition(),
+  _allDoneCondition(),
+  _roomCondition(),
+  _timerMutex(),
+  _timerCondition(),
+  _timers(),
+  _timerThread(),
+  _timerStart ( Clock::now() ),
+  _timerWakeTick ( 0 ),
+  _numTimerClears ( 0 ),
   _maxNumThreadsAllowed ( Details::getDefaultMaxNumThreadsAllowed() ),
+  _adaptMinNumThreads ( 1 ),
+  _adaptMaxNumThreads ( 1 ),
+  _adaptGeneration ( 0 ),
+  _adaptWallTime ( 0 ),
+  _adaptThreadTime ( 0 ),
+  _adaptBlocked ( 0 ),
+  _adaptNumProcessors ( 0 ),
+  _adaptProcessorsTime(),
+  _isAdapting ( false ),
+  _isRecordingJobTimes ( false ),
+  _jobTimes ( std::string() ),
+  _jobTimesByName(),
+  _isTracing ( false ),
+  _trace(),
+  _maxNumJobsQueued ( std::numeric_limits < unsigned int >::max() ),
+  _numThreadsWaitingForRoom ( 0 ),
   _numMillisecondsToSleep ( 10 ),
+  _threadModel ( THREAD_POOL ),
+  _wakeModel ( WAKE_ON_EVENTS ),
+  _scheduler ( SCHEDULER_SHARED_QUEUE ),
+  _affinity ( AFFINITY_NONE ),
+  _processors ( Usul::System::Processors::getAvailable() ),
+  _numJobsInDeques ( 0 ),
+  _numJobsSubmitted ( 0 ),
+  _numJobsRunningInPool ( 0 ),
+  _numJobsRunningInThreads ( 0 ),
+  _numThreadsWaiting ( 0 ),
+  _numJobsWaiting ( 0 ),
   _shouldRunWorkerThread ( true ),
+  _shouldRunPoolThreads ( true ),
+  _shouldRunTimerThread ( false ),
   _isBeingDestroyed ( false ),
   _isBeingReset ( false ),
   _hasJobInTransition ( false )
@@ -176,6 +362,12 @@ Manager::Manager() :
 Manager::~Manager()
 {
   USUL_TOOLS_NO_THROW ( 1591069652, std::bind ( &Manager::_destroyManager, this ) );
+
+  // No thread is using these now.
+  for ( unsigned int i = 0; i < MAX_NUM_JOB_NAMES; ++i )
+  {
+    delete _jobTimesByName[i].exchange ( nullptr );
+  }
 }
 
 
@@ -200,9 +392,18 @@ void Manager::_destroyManager()
 
   Details::pause();
 
+  // Stop the timer thread so that it does not add any more jobs.
+  this->_stopTimerThread();
+
   // Stop the worker thread.
   this->_stopWorkerThread();
 
+  // Stop the threads in the pool.
+  this->_stopPoolThreads();
+
+  // Stop the threads in the lanes.
+  this->_stopLaneThreads();
+
   Details::pause();
 
   // We're done with our worker thread. This is probably already null.
@@ -250,6 +451,7 @@ void Manager::reset()
   // Make sure these containers are empty.
   _queuedJobs.clear();
   _runningJobs.clear();
+  _numJobsRunningInThreads = 0;
 }
 
 
@@ -275,10 +477,16 @@ Manager &Manager::instance()
 void Manager::sortQueuedJobs()
 {
   Guard guard ( _mutex );
-  std::sort ( _queuedJobs.begin(), _queuedJobs.end(), [] ( JobPtr a, JobPtr b )
+  this->_drainSubmissions();
+  _queuedJobs.rebuild();
+
+  // Same for the queues of the lanes.
+  for ( unsigned int i = 1; i < _numLanes; ++i )
   {
-    return ( a->getPriority() < b->getPriority() );
-  } );
+    LaneInfo &lane = *_lanes[i];
+    Guard laneGuard ( lane.mutex );
+    lane.queue.rebuild();
+  }
 }
 
 
@@ -289,6 +497,42 @@ void Manager::sortQueuedJobs()
 ///////////////////////////////////////////////////////////////////////////////
 
 void Manager::addJob ( JobPtr job )
+{
+  this->_addJob ( job, true, 0 );
+}
+Manager::JobPtr Manager::addJob ( Callback cb )
+{
+  JobPtr job = Details::makeJob ( cb );
+  this->addJob ( job );
+  return job;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Add the job if there is room in the queue.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+bool Manager::tryAddJob ( JobPtr job )
+{
+  return this->_addJob ( job, false, 0 );
+}
+bool Manager::tryAddJobFor ( JobPtr job, unsigned int milliseconds )
+{
+  return this->_addJob ( job, false, milliseconds );
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Add a job to the queue. If the queue is full then wait for room, either
+//  forever or for the given number of milliseconds. Returns false if the
+//  job was not added.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+bool Manager::_addJob ( JobPtr job, bool waitForever, unsigned int milliseconds )
 {
   IS_NOT_WORKER_THREAD_OR_THROW;
 
@@ -298,22 +542,54 @@ void Manager::addJob ( JobPtr job )
     throw std::runtime_error ( "Can not add null job" );
   }
 
-  // Make sure we are not being destroyed.
-  if ( true == _isBeingDestroyed )
+  // Make sure we are not being destroyed or reset.
+  this->_canAddJobsOrThrow();
+
+  // Catch adding it twice before anything about it is recorded.
+  Manager::_canQueueJobOrThrow ( *job );
+
+  // Only a job for the pool waits for room, and that may fail. Otherwise,
+  // it's added now, and it's recorded before another thread can take it.
+  const bool shouldWaitForRoom = ( ( nullptr == this->_getLane ( job->getLane() ) ) && ( true == this->_shouldWaitForRoom() ) );
+  if ( false == shouldWaitForRoom )
   {
-    throw std::runtime_error ( "Can not add job to manager that is being destroyed" );
+    this->_jobAdded ( *job, true );
   }
 
-  // Make sure we are not being reset.
-  if ( true == _isBeingReset )
+  // A job in another lane goes to that lane's queue.
+  if ( true == this->_addLaneJob ( job ) )
   {
-    throw std::runtime_error ( "Can not add job to manager that is being reset" );
+    return true;
+  }
+
+  // A job added by a job in the pool may go to that thread's deque.
+  if ( true == this->_addLocalJob ( job ) )
+  {
+    return true;
+  }
+
+  // Most jobs for the pool go in the ring without locking the mutex. When
+  // the queue has a maximum size, the room is checked with the mutex locked.
+  if ( ( false == shouldWaitForRoom ) && ( true == this->_submitJob ( job ) ) )
+  {
+    return true;
   }
 
   // Need a local scope for the lock.
   {
     // One thread at a time.
-    Guard guard ( _mutex );
+    std::unique_lock < Mutex > lock ( _mutex, std::defer_lock );
+    this->_lockMutex ( lock );
+
+    // Wait for room if we should. The job is not added until there is room.
+    if ( true == shouldWaitForRoom )
+    {
+      if ( false == this->_waitForRoom ( lock, 1, waitForever, milliseconds ) )
+      {
+        return false;
+      }
+      this->_jobAdded ( *job, true );
+    }
 
     // Do not allow more jobs than the unsigned int max.
     typedef std::numeric_limits < unsigned int > Limits;
@@ -324,430 +600,3380 @@ void Manager::addJob ( JobPtr job )
       throw std::runtime_error ( out.str() );
     }
 
-    // Add the job to the queue.
-    _queuedJobs.push_back ( job );
-
-    // Sort the queue now while the mutex is locked to keep it consistent.
-    this->sortQueuedJobs();
+    // Add the job to the queue. It goes where its priority says it should.
+    _queuedJobs.push ( job );
   }
 
-  // Make sure the worker thread is started.
-  this->_startWorkerThread();
-}
-Manager::JobPtr Manager::addJob ( Callback cb )
-{
-  JobPtr job ( new Job ( cb ) );
-  this->addJob ( job );
-  return job;
+  // Make sure there is a thread to run the job.
+  this->_startThreads();
+
+  // Wake up a thread to run the job.
+  this->_wakeThreads ( false );
+
+  return true;
 }
 
 
 ///////////////////////////////////////////////////////////////////////////////
 //
-//  Remove the queued job. Has no effect on running jobs.
+//  Add the jobs to the queue all at once.
 //
 ///////////////////////////////////////////////////////////////////////////////
 
-bool Manager::removeQueuedJob ( JobPtr j1 )
+void Manager::addJobs ( const Jobs &jobs )
 {
   IS_NOT_WORKER_THREAD_OR_THROW;
 
-  // One thread at a time.
-  Guard guard ( _mutex );
-
-  // Shortcut
-  QueuedJobs &q = _queuedJobs;
-
-  // Get the number of queued jobs before we do anything.
-  const QueuedJobs::size_type numBefore = q.size();
+  // Handle no jobs.
+  if ( true == jobs.empty() )
+  {
+    return;
+  }
 
-  // Erase all the jobs that are the given job.
-  q.erase ( std::remove_if ( q.begin(), q.end(), [ &j1 ] ( JobPtr j2 )
+  // Check input.
+  if ( true == std::any_of ( jobs.begin(), jobs.end(), [] ( const JobPtr &job ) { return ( nullptr == job.get() ); } ) )
   {
-    return ( j1 == j2 );
-  } ),
-  q.end() );
+    throw std::runtime_error ( "Can not add null job" );
+  }
 
-  // Get the number of queued jobs now that we (may) have erase one.
-  const QueuedJobs::size_type numAfter = q.size();
+  // Make sure we are not being destroyed or reset.
+  this->_canAddJobsOrThrow();
 
-  // How many did we erase?
-  const QueuedJobs::size_type numErased = numBefore - numAfter;
+  // Catch a job that's in a queue, or in the list twice, before any are
+  // added. Marking them all catches both, and then they are unmarked.
+  for ( auto i = jobs.begin(); i != jobs.end(); ++i )
+  {
+    try
+    {
+      Manager::_setSubmitted ( **i );
+    }
+    catch ( ... )
+    {
+      std::for_each ( jobs.begin(), i, [] ( const JobPtr &job ) { Manager::_clearSubmitted ( *job ); } );
+      throw;
+    }
+  }
+  std::for_each ( jobs.begin(), jobs.end(), [] ( const JobPtr &job ) { Manager::_clearSubmitted ( *job ); } );
 
-  // Make sure we erased either one or zero.
-  if ( ( 0 != numErased ) && ( 1 != numErased ) )
+  // Most of the time they are all for the pool. This also checks the lanes.
+  if ( false == std::any_of ( jobs.begin(), jobs.end(), [ this ] ( const JobPtr &job ) { return ( nullptr != this->_getLane ( job->getLane() ) ); } ) )
   {
-    std::ostringstream out;
-    out << "Erased " << numErased << " jobs";
-    throw std::runtime_error ( out.str() );
+    this->_addPoolJobs ( jobs );
+    return;
   }
 
-  // Return true if we erased one.
-  return ( 1 == numErased );
+  // Adding the jobs for the pool can still throw, so they go first, and then
+  // the jobs in other lanes go to their lanes' queues.
+  Jobs pool, lanes;
+  for ( auto i = jobs.begin(); i != jobs.end(); ++i )
+  {
+    ( ( nullptr == this->_getLane ( (*i)->getLane() ) ) ? pool : lanes ).push_back ( *i );
+  }
+  if ( false == pool.empty() )
+  {
+    this->_addPoolJobs ( pool );
+  }
+  for ( auto i = lanes.begin(); i != lanes.end(); ++i )
+  {
+    this->_jobAdded ( **i, true );
+    this->_addLaneJob ( *i );
+  }
 }
 
 
 ///////////////////////////////////////////////////////////////////////////////
 //
-//  Cancel the running jobs.
+//  Add the jobs for the pool all at once. Each one is recorded when it's
+//  sure to be added, and before another thread can take it.
 //
 ///////////////////////////////////////////////////////////////////////////////
 
-void Manager::cancelRunningJobs()
+void Manager::_addPoolJobs ( const Jobs &jobs )
 {
-  IS_NOT_WORKER_THREAD_OR_THROW;
-  Guard guard ( _mutex );
+  auto added = [ this, &jobs ] ()
+  {
+    std::for_each ( jobs.begin(), jobs.end(), [ this ] ( const JobPtr &job )
+    {
+      this->_jobAdded ( *job, true );
+    } );
+  };
 
-  // Loop through the running jobs and cancel them.
-  // Note: They stay in the container. The normal mechanism will remove them.
-  std::for_each ( _runningJobs.begin(), _runningJobs.end(), [] ( RunningInfo info )
+  // Jobs added by a job in the pool may go to that thread's deque. They
+  // do not wait for room.
+  if ( true == this->_canAddLocalJobs() )
   {
-    info.second->cancel();
-  } );
+    added();
+    this->_addLocalJobs ( jobs );
+    return;
+  }
+
+  // Need a local scope for the lock.
+  {
+    // One thread at a time.
+    std::unique_lock < Mutex > lock ( _mutex );
+
+    // Wait until there is room for all of them.
+    if ( true == this->_shouldWaitForRoom() )
+    {
+      if ( jobs.size() > this->getMaxNumJobsQueued() )
+      {
+        throw std::invalid_argument ( "More jobs than the maximum number that can be queued" );
+      }
+      this->_waitForRoom ( lock, jobs.size(), true, 0 );
+    }
+
+    // Do not allow more jobs than the unsigned int max.
+    typedef std::numeric_limits < unsigned int > Limits;
+    if ( jobs.size() > ( Limits::max() - _queuedJobs.size() ) )
+    {
+      std::ostringstream out;
+      out << "Exceeded maximum size of job queue: " << Limits::max();
+      throw std::runtime_error ( out.str() );
+    }
+
+    // Add the jobs to the queue and fix the heap once.
+    added();
+    _queuedJobs.push ( jobs );
+  }
+
+  // Make sure there is a thread to run the jobs.
+  this->_startThreads();
+
+  // Wake up the threads to run the jobs.
+  this->_wakeThreads ( jobs.size() > 1 );
+}
+Manager::Jobs Manager::addJobs ( const Callbacks &callbacks )
+{
+  Jobs jobs;
+  jobs.reserve ( callbacks.size() );
+  for ( auto i = callbacks.begin(); i != callbacks.end(); ++i )
+  {
+    jobs.push_back ( Details::makeJob ( *i ) );
+  }
+  this->addJobs ( jobs );
+  return jobs;
 }
 
 
 ///////////////////////////////////////////////////////////////////////////////
 //
-//  Clear any jobs that are in the queue.
+//  Add the job to the queue when all of the given jobs are done.
 //
 ///////////////////////////////////////////////////////////////////////////////
 
-void Manager::clearQueuedJobs()
+void Manager::addJob ( JobPtr job, const Jobs &predecessors )
 {
   IS_NOT_WORKER_THREAD_OR_THROW;
-  Guard guard ( _mutex );
 
-  // If the jobs are still in the queue then there is no need to cancel them.
-  _queuedJobs.clear();
+  // Check input.
+  if ( ( nullptr == job.get() ) || ( true == std::any_of ( predecessors.begin(), predecessors.end(), [] ( const JobPtr &p ) { return ( nullptr == p.get() ); } ) ) )
+  {
+    throw std::runtime_error ( "Can not add null job" );
+  }
+
+  // Handle no predecessors.
+  if ( true == predecessors.empty() )
+  {
+    this->addJob ( job );
+    return;
+  }
+
+  // Make sure we are not being destroyed or reset.
+  this->_canAddJobsOrThrow();
+
+  // Make sure the lane is there now rather than when the job is queued.
+  this->_getLane ( job->getLane() );
+
+  // Typedef this for readability.
+  typedef std::numeric_limits < unsigned int > Limits;
+
+  // Make sure that we can count them.
+  if ( predecessors.size() >= Limits::max() )
+  {
+    throw std::runtime_error ( "Too many jobs to wait for" );
+  }
+
+  // There is one extra so that the job is not queued before we're done here.
+  // Setting it from zero catches a job that's already waiting, even when two
+  // threads add it at once.
+  unsigned int expected = 0;
+  if ( false == job->_numPredecessors.compare_exchange_strong ( expected, static_cast < unsigned int > ( predecessors.size() + 1 ) ) )
+  {
+    throw std::runtime_error ( "Job is already waiting for other jobs" );
+  }
+
+  this->_jobAdded ( *job, false );
+
+  // Count it now so that waitAll() waits for it.
+  ++_numJobsWaiting;
+
+  for ( auto i = predecessors.begin(); i != predecessors.end(); ++i )
+  {
+    (*i)->whenDone ( [ this, job ] ()
+    {
+      this->_predecessorDone ( job );
+    } );
+  }
+
+  // Now remove the extra one.
+  this->_predecessorDone ( job );
+}
+Manager::JobPtr Manager::addJob ( Callback cb, const Jobs &predecessors )
+{
+  JobPtr job = Details::makeJob ( cb );
+  this->addJob ( job, predecessors );
+  return job;
 }
 
 
 ///////////////////////////////////////////////////////////////////////////////
 //
-//  Get the names of the running jobs.
+//  One of the jobs that the given job is waiting for is done.
 //
 ///////////////////////////////////////////////////////////////////////////////
 
-void Manager::getRunningJobNames ( Names &names ) const
+void Manager::_predecessorDone ( JobPtr job )
 {
-  Guard guard ( _mutex );
-  std::for_each ( _runningJobs.begin(), _runningJobs.end(), [ &names ] ( RunningInfo info )
+  // Queue it when it's the last one.
+  if ( 1 == job->_numPredecessors-- )
   {
-    names.push_back ( info.second->getName() );
-  } );
-}
-Manager::Names Manager::getRunningJobNames() const
-{
-  Names names;
-  this->getRunningJobNames ( names );
-  return names;
+    this->_addWaitingJob ( job );
+  }
 }
 
 
 ///////////////////////////////////////////////////////////////////////////////
 //
-//  Get the names of the queued jobs.
+//  Add the job that was waiting. This is called from the thread that marked
+//  the other job done, which may be any thread, so it does not throw.
 //
 ///////////////////////////////////////////////////////////////////////////////
 
-void Manager::getQueuedJobNames ( Names &names ) const
+void Manager::_addWaitingJob ( JobPtr job )
 {
-  Guard guard ( _mutex );
-  std::for_each ( _queuedJobs.begin(), _queuedJobs.end(), [ &names ] ( JobPtr job )
+  // Always count it as no longer waiting, after it's in the queue.
+  USUL_SCOPED_CALL ( [ this ] ()
+  {
+    --_numJobsWaiting;
+    this->_notifyIfAllDone();
+  } );
+
+  // If the job is not added then it will never run, so it's done.
+  bool added = false;
+  try
+  {
+    // A manager that is being destroyed or reset will never run the job.
+    if ( ( true == _isBeingDestroyed ) || ( true == _isBeingReset ) )
+    {
+      job->done();
+      return;
+    }
+
+    this->_jobQueued ( *job );
+
+    // A job in another lane goes to that lane's queue.
+    if ( true == this->_addLaneJob ( job ) )
+    {
+      return;
+    }
+
+    // A job added by a job in the pool may go to that thread's deque.
+    if ( true == this->_addLocalJob ( job ) )
+    {
+      return;
+    }
+
+    // Try the ring, and if it's full then add the job to the queue.
+    if ( true == this->_submitJob ( job ) )
+    {
+      return;
+    }
+    {
+      Guard guard ( _mutex );
+      _queuedJobs.push ( job );
+      added = true;
+    }
+
+    // The worker thread is already running if this is it.
+    if ( false == this->_isWorkerThread() )
+    {
+      this->_startThreads();
+    }
+
+    // Wake up a thread to run the job.
+    this->_wakeThreads ( false );
+  }
+  JOB_MANAGER_CATCH_EXCEPTIONS ( 1700417721, job )
+
+  if ( false == added )
+  {
+    job->done();
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Add the job to the queue at the given time.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void Manager::addJobAt ( JobPtr job, TimePoint when )
+{
+  IS_NOT_WORKER_THREAD_OR_THROW;
+
+  // Check input.
+  if ( nullptr == job.get() )
+  {
+    throw std::runtime_error ( "Can not add null job" );
+  }
+
+  // Make sure we are not being destroyed or reset.
+  this->_canAddJobsOrThrow();
+
+  // Make sure the lane is there now rather than when the job is queued.
+  this->_getLane ( job->getLane() );
+
+  // The timer is like a job that it's waiting for, so it can not also be
+  // waiting for other jobs.
+  unsigned int expected = 0;
+  if ( false == job->_numPredecessors.compare_exchange_strong ( expected, 1 ) )
+  {
+    throw std::runtime_error ( "Job is already waiting for other jobs" );
+  }
+
+  this->_jobAdded ( *job, false );
+
+  // Count it now so that waitAll() waits for it.
+  ++_numJobsWaiting;
+
+  Timer timer;
+  timer.job = job;
+  timer.period = 0;
+  this->_addTimer ( timer, when );
+}
+Manager::JobPtr Manager::addJobAt ( Callback cb, TimePoint when )
+{
+  JobPtr job = Details::makeJob ( cb );
+  this->addJobAt ( job, when );
+  return job;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Add the job to the queue after the given number of milliseconds.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void Manager::addJobAfter ( JobPtr job, unsigned int milliseconds )
+{
+  this->addJobAt ( job, Clock::now() + std::chrono::milliseconds ( milliseconds ) );
+}
+Manager::JobPtr Manager::addJobAfter ( Callback cb, unsigned int milliseconds )
+{
+  JobPtr job = Details::makeJob ( cb );
+  this->addJobAfter ( job, milliseconds );
+  return job;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Add a new job to the queue every given number of milliseconds.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void Manager::addPeriodicJob ( JobPtr job, unsigned int milliseconds )
+{
+  IS_NOT_WORKER_THREAD_OR_THROW;
+
+  // Check input.
+  if ( nullptr == job.get() )
+  {
+    throw std::runtime_error ( "Can not add null job" );
+  }
+  if ( 0 == milliseconds )
+  {
+    throw std::invalid_argument ( "Interval of periodic job must be at least one millisecond" );
+  }
+
+  // Make sure we are not being destroyed or reset.
+  this->_canAddJobsOrThrow();
+
+  // Make sure the lane is there now rather than when the jobs are queued.
+  this->_getLane ( job->getLane() );
+
+  Timer timer;
+  timer.job = job;
+  timer.period = milliseconds;
+  this->_addTimer ( timer, Clock::now() + std::chrono::milliseconds ( milliseconds ) );
+}
+Manager::JobPtr Manager::addPeriodicJob ( Callback cb, unsigned int milliseconds )
+{
+  JobPtr job = Details::makeJob ( cb );
+  this->addPeriodicJob ( job, milliseconds );
+  return job;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Add the timer to the wheel and make sure the timer thread knows.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void Manager::_addTimer ( const Timer &timer, TimePoint when )
+{
+  const Tick tick = this->_getTick ( when );
+
+  std::lock_guard < std::mutex > guard ( _timerMutex );
+
+  this->_startTimerThread();
+
+  _timers.add ( tick, timer );
+
+  // Only wake the timer thread if it would sleep past this one.
+  if ( tick < _timerWakeTick )
+  {
+    _timerCondition.notify_one();
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Take the timed jobs out of the wheel. They will never be queued so they
+//  are done, and the periodic ones stop.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void Manager::_clearTimers()
+{
+  Timers::Items items;
+  {
+    std::lock_guard < std::mutex > guard ( _timerMutex );
+    _timers.clear ( items );
+
+    // So that the timer thread does not put back the ones it's firing.
+    ++_numTimerClears;
+
+    // The timers with functions are not jobs, so put them back unless the
+    // timer thread is stopping.
+    if ( true == _shouldRunTimerThread )
+    {
+      for ( auto i = items.begin(); i != items.end(); ++i )
+      {
+        if ( i->second.fun )
+        {
+          _timers.add ( i->first, i->second );
+        }
+      }
+    }
+  }
+
+  for ( auto i = items.begin(); i != items.end(); ++i )
+  {
+    const Timer &timer = i->second;
+    if ( timer.fun )
+    {
+      continue;
+    }
+    else if ( 0 == timer.period )
+    {
+      timer.job->_numPredecessors = 0;
+      timer.job->done();
+      --_numJobsWaiting;
+    }
+    else
+    {
+      timer.job->done();
+    }
+  }
+
+  if ( false == items.empty() )
+  {
+    this->_notifyIfAllDone();
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  The timer is due. Returns true if it's periodic and should be put back.
+//  Called from the timer thread without the timer mutex locked.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+bool Manager::_fireTimer ( Timer &timer )
+{
+  // The function says if it should keep going.
+  if ( timer.fun )
+  {
+    return timer.fun();
+  }
+
+  // The one-time job goes in the queue now.
+  if ( 0 == timer.period )
+  {
+    this->_predecessorDone ( timer.job );
+    return false;
+  }
+
+  // Stop the periodic job if we should.
+  if ( ( true == timer.job->isCancelled() ) || ( true == _isBeingDestroyed ) || ( true == _isBeingReset ) )
+  {
+    timer.job->done();
+    return false;
+  }
+
+  // Skip this time if the last one is not done.
+  if ( ( nullptr != timer.last.get() ) && ( false == timer.last->isDone() ) )
+  {
+    return true;
+  }
+
+  // Queue a new job like the periodic one. It's counted as waiting until
+  // it's in the queue.
+  const Job &periodic = *timer.job;
+  timer.last = std::allocate_shared < Job > ( Usul::Jobs::Allocator < Job > (), periodic.getName(), periodic.getPriority(), periodic.getCallback() );
+  timer.last->setLane ( periodic.getLane() );
+  this->_jobAdded ( *timer.last, false );
+  ++_numJobsWaiting;
+  this->_addWaitingJob ( timer.last );
+
+  return true;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Return the number of milliseconds since the timers started, rounded up
+//  so that a job is never early.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+Manager::Tick Manager::_getTick ( TimePoint when ) const
+{
+  if ( when <= _timerStart )
+  {
+    return 0;
+  }
+
+  typedef std::chrono::duration < Tick, std::milli > Milliseconds;
+  const Clock::duration elapsed = when - _timerStart;
+  const Milliseconds rounded = std::chrono::duration_cast < Milliseconds > ( elapsed );
+  return ( ( rounded < elapsed ) ? ( rounded.count() + 1 ) : rounded.count() );
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Return the number of whole milliseconds since the timers started. This
+//  is rounded down, so that the timers due by this tick are really due.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+Manager::Tick Manager::_getCurrentTick() const
+{
+  typedef std::chrono::duration < Tick, std::milli > Milliseconds;
+  const Clock::duration elapsed = Clock::now() - _timerStart;
+  return ( ( elapsed.count() > 0 ) ? std::chrono::duration_cast < Milliseconds > ( elapsed ).count() : 0 );
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Start the timer thread. Call this with the timer mutex locked.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void Manager::_startTimerThread()
+{
+  // Do not start the timer thread if it's already running.
+  if ( nullptr != _timerThread.get() )
+  {
+    return;
+  }
+
+  _shouldRunTimerThread = true; // This variable is atomic.
+
+  _timerThread = ThreadPtr ( new std::thread ( [ this ] ()
+  {
+    // If an exception sneaks through it will bring down the house.
+    try
+    {
+      this->_timerThreadStarted();
+    }
+    JOB_MANAGER_CATCH_EXCEPTIONS ( 1700764052, JobPtr() )
+  } ) );
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Stop the timer thread.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void Manager::_stopTimerThread()
+{
+  ThreadPtr thread;
+  {
+    std::lock_guard < std::mutex > guard ( _timerMutex );
+    _shouldRunTimerThread = false; // This variable is atomic.
+    thread = _timerThread;
+    _timerThread = nullptr;
+    _timerCondition.notify_all();
+  }
+
+  if ( nullptr != thread.get() )
+  {
+    thread->join();
+  }
+
+  // Any timed jobs left will never be queued.
+  this->_clearTimers();
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Called when the timer thread starts. It sleeps until the next timer is
+//  due, then queues the jobs that are due.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void Manager::_timerThreadStarted()
+{
+  Trace::setThreadName ( "timer" );
+
+  Timers::Items due;
+
+  std::unique_lock < std::mutex > lock ( _timerMutex );
+
+  // Loop until told otherwise.
+  while ( true == _shouldRunTimerThread )
+  {
+    // Take the timers that are due.
+    _timers.advance ( this->_getCurrentTick(), due );
+
+    if ( false == due.empty() )
+    {
+      // This thread is awake, so adding a timer does not need to wake it.
+      _timerWakeTick = 0;
+      const unsigned int numClears = _numTimerClears;
+
+      // Adding the jobs may lock the manager's mutex, so unlock this one.
+      lock.unlock();
+      for ( auto i = due.begin(); i != due.end(); ++i )
+      {
+        if ( false == this->_fireTimer ( i->second ) )
+        {
+          i->second.period = 0;
+        }
+      }
+      lock.lock();
+
+      // Put back the periodic ones at their next time after now. If the
+      // timers were cleared in the mean time then stop these too.
+      const Tick now = this->_getCurrentTick();
+      for ( auto i = due.begin(); i != due.end(); ++i )
+      {
+        Timer &timer = i->second;
+        if ( 0 == timer.period )
+        {
+          continue;
+        }
+
+        if ( ( numClears != _numTimerClears ) && ( !timer.fun ) )
+        {
+          timer.job->done();
+          continue;
+        }
+
+        Tick next = i->first + timer.period;
+        if ( next <= now )
+        {
+          next += ( ( now - next ) / timer.period + 1 ) * timer.period;
+        }
+        _timers.add ( next, timer );
+      }
+      due.clear();
+      continue;
+    }
+
+    // Sleep until the next timer, or until one is added that is sooner.
+    _timerWakeTick = _timers.next();
+    if ( std::numeric_limits < Tick >::max() == _timerWakeTick )
+    {
+      _timerCondition.wait ( lock );
+    }
+    else
+    {
+      _timerCondition.wait_until ( lock, _timerStart + std::chrono::milliseconds ( _timerWakeTick ) );
+    }
+    _timerWakeTick = 0;
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Throw an exception if jobs can not be added now.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void Manager::_canAddJobsOrThrow() const
+{
+  // Make sure we are not being destroyed.
+  if ( true == _isBeingDestroyed )
+  {
+    throw std::runtime_error ( "Can not add job to manager that is being destroyed" );
+  }
+
+  // Make sure we are not being reset.
+  if ( true == _isBeingReset )
+  {
+    throw std::runtime_error ( "Can not add job to manager that is being reset" );
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Make sure there is a thread to run the queued jobs.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void Manager::_startThreads()
+{
+  if ( THREAD_POOL == this->getThreadModel() )
+  {
+    // Do not lock the mutex if the pool already has enough threads.
+    const PoolTable *table = _poolTable; // This is atomic.
+    if ( ( nullptr != table ) && ( true == _shouldRunPoolThreads ) && ( table->size() >= this->getMaxNumThreadsAllowed() ) )
+    {
+      return;
+    }
+
+    this->_startPoolThreads();
+  }
+  else
+  {
+    this->_startWorkerThread();
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Remove the queued job. Has no effect on running jobs. The job will never
+//  run so it's done, the same as when the queue is cleared.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+bool Manager::removeQueuedJob ( JobPtr job )
+{
+  IS_NOT_WORKER_THREAD_OR_THROW;
+
+  // Handle bad input.
+  if ( nullptr == job.get() )
+  {
+    return false;
+  }
+
+  // A job in another lane is in that lane's queue. The others are in the
+  // shared queue, or may still be in the ring. The job knows where it is
+  // in the queue, if it's there at all.
+  bool erased = false;
+  LaneInfo *lane = this->_getLane ( job->getLane() );
+  if ( nullptr != lane )
+  {
+    Guard guard ( lane->mutex );
+    erased = lane->queue.remove ( job );
+    if ( true == erased )
+    {
+      --_numJobsInLanes;
+    }
+  }
+  else
+  {
+    Guard guard ( _mutex );
+    this->_drainSubmissions();
+    erased = _queuedJobs.remove ( job );
+  }
+
+  // Waiting for it returns now, and the jobs that wait for it are queued.
+  if ( true == erased )
+  {
+    this->_traceJob ( Trace::CANCEL, *job );
+    job->done();
+  }
+
+  // There may not be any jobs now, and there may be room for more.
+  this->_notifyIfAllDone();
+  this->_notifyIfRoom();
+
+  // Return true if we erased it.
+  return erased;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Cancel the running jobs.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void Manager::cancelRunningJobs()
+{
+  IS_NOT_WORKER_THREAD_OR_THROW;
+  Guard guard ( _mutex );
+
+  // Loop through the running jobs and cancel them.
+  // Note: They stay in the container. The normal mechanism will remove them.
+  std::for_each ( _runningJobs.begin(), _runningJobs.end(), [ this ] ( RunningInfo info )
+  {
+    this->_traceJob ( Trace::CANCEL, *info.second );
+    info.second->cancel();
+  } );
+
+  // Same for the jobs running in the pool.
+  std::for_each ( _poolThreads.begin(), _poolThreads.end(), [ this ] ( PoolThreadPtr pt )
+  {
+    std::lock_guard < std::mutex > guard ( pt->mutex );
+    if ( nullptr != pt->job.get() )
+    {
+      this->_traceJob ( Trace::CANCEL, *pt->job );
+      pt->job->cancel();
+    }
+
+    // The jobs that the thread is running inside of are still running too.
+    for ( auto j = pt->waiting.begin(); j != pt->waiting.end(); ++j )
+    {
+      if ( nullptr != j->get() )
+      {
+        this->_traceJob ( Trace::CANCEL, **j );
+        (*j)->cancel();
+      }
+    }
+  } );
+
+  // Same for the jobs running in the lanes.
+  for ( unsigned int i = 1; i < _numLanes; ++i )
+  {
+    LaneInfo &lane = *_lanes[i];
+    Guard laneGuard ( lane.mutex );
+    for ( auto j = lane.running.begin(); j != lane.running.end(); ++j )
+    {
+      if ( nullptr != j->get() )
+      {
+        this->_traceJob ( Trace::CANCEL, **j );
+        (*j)->cancel();
+      }
+    }
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Clear any jobs that are in the queue.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void Manager::clearQueuedJobs()
+{
+  IS_NOT_WORKER_THREAD_OR_THROW;
+
+  // If the jobs are still in the queue then there is no need to cancel them.
+  Queue::Jobs jobs;
+  {
+    Guard guard ( _mutex );
+    this->_drainSubmissions();
+    _queuedJobs.clear ( jobs );
+  }
+
+  // Same for the queues of the lanes.
+  for ( unsigned int i = 1; i < _numLanes; ++i )
+  {
+    LaneInfo &lane = *_lanes[i];
+    Guard guard ( lane.mutex );
+    _numJobsInLanes -= static_cast < unsigned int > ( lane.queue.size() );
+    lane.queue.clear ( jobs );
+  }
+
+  // These jobs will never run so they are done.
+  std::for_each ( jobs.begin(), jobs.end(), [ this ] ( JobPtr job )
+  {
+    this->_traceJob ( Trace::CANCEL, *job );
+    job->done();
+  } );
+
+  // Same for the jobs in the deques.
+  this->_clearDeques();
+
+  // Same for the timed jobs that are not queued yet.
+  this->_clearTimers();
+
+  // There may not be any jobs now, and there is room for more.
+  this->_notifyIfAllDone();
+  this->_notifyIfRoom();
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Get the names of the running jobs.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void Manager::getRunningJobNames ( Names &names ) const
+{
+  Guard guard ( _mutex );
+  std::for_each ( _runningJobs.begin(), _runningJobs.end(), [ &names ] ( RunningInfo info )
+  {
+    names.push_back ( info.second->getName() );
+  } );
+  std::for_each ( _poolThreads.begin(), _poolThreads.end(), [ &names ] ( PoolThreadPtr pt )
+  {
+    std::lock_guard < std::mutex > guard ( pt->mutex );
+    if ( nullptr != pt->job.get() )
+    {
+      names.push_back ( pt->job->getName() );
+    }
+    for ( auto j = pt->waiting.begin(); j != pt->waiting.end(); ++j )
+    {
+      if ( nullptr != j->get() )
+      {
+        names.push_back ( (*j)->getName() );
+      }
+    }
+  } );
+  for ( unsigned int i = 1; i < _numLanes; ++i )
+  {
+    LaneInfo &lane = *_lanes[i];
+    Guard laneGuard ( lane.mutex );
+    for ( auto j = lane.running.begin(); j != lane.running.end(); ++j )
+    {
+      if ( nullptr != j->get() )
+      {
+        names.push_back ( (*j)->getName() );
+      }
+    }
+  }
+}
+Manager::Names Manager::getRunningJobNames() const
+{
+  Names names;
+  this->getRunningJobNames ( names );
+  return names;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Get/set if the manager records the times of the jobs.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+bool Manager::isRecordingJobTimes() const
+{
+  return _isRecordingJobTimes; // This is atomic.
+}
+void Manager::setRecordingJobTimes ( bool state )
+{
+  _isRecordingJobTimes = state; // This is atomic.
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Get the times of the jobs.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+Manager::JobTimes Manager::getJobTimes() const
+{
+  JobTimes times;
+  times.queued = _jobTimes.queued.get();
+  times.running = _jobTimes.running.get();
+  times.total = _jobTimes.total.get();
+  return times;
+}
+void Manager::getJobTimesByName ( JobTimesByName &answer ) const
+{
+  for ( unsigned int i = 0; i < MAX_NUM_JOB_NAMES; ++i )
+  {
+    const JobTimesRecord *record = _jobTimesByName[i].load();
+    if ( nullptr != record )
+    {
+      JobTimes &times = answer[record->name];
+      times.queued = record->queued.get();
+      times.running = record->running.get();
+      times.total = record->total.get();
+    }
+  }
+}
+Manager::JobTimesByName Manager::getJobTimesByName() const
+{
+  JobTimesByName answer;
+  this->getJobTimesByName ( answer );
+  return answer;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Clear the times of the jobs. The names stay so that the threads that are
+//  recording can keep using them.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void Manager::clearJobTimes()
+{
+  _jobTimes.queued.clear();
+  _jobTimes.running.clear();
+  _jobTimes.total.clear();
+
+  for ( unsigned int i = 0; i < MAX_NUM_JOB_NAMES; ++i )
+  {
+    JobTimesRecord *record = _jobTimesByName[i].load();
+    if ( nullptr != record )
+    {
+      record->queued.clear();
+      record->running.clear();
+      record->total.clear();
+    }
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Return the times of the jobs with the name, making it the first time.
+//  The names go in an open hash table that is only added to, so this does
+//  not lock anything. Returns null if there is no room.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+Manager::JobTimesRecord *Manager::_getJobTimesRecord ( const std::string &name )
+{
+  const std::size_t start = std::hash < std::string > () ( name );
+  std::unique_ptr < JobTimesRecord > made;
+
+  for ( unsigned int i = 0; i < MAX_NUM_JOB_NAMES; ++i )
+  {
+    AtomicJobTimesRecord &slot = _jobTimesByName[( start + i ) % MAX_NUM_JOB_NAMES];
+
+    JobTimesRecord *record = slot.load();
+    if ( nullptr == record )
+    {
+      if ( nullptr == made.get() )
+      {
+        made.reset ( new JobTimesRecord ( name ) );
+      }
+      if ( true == slot.compare_exchange_strong ( record, made.get() ) )
+      {
+        return made.release();
+      }
+      // Another thread got this one first, and now it's in the record.
+    }
+
+    if ( name == record->name )
+    {
+      return record;
+    }
+  }
+
+  return nullptr;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  The manager got the job, or the job is ready to run after waiting.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void Manager::_jobAdded ( Job &job, bool queued )
+{
+  if ( true == _isRecordingJobTimes )
+  {
+    job._addedTime = Clock::now();
+    job._queuedTime = job._addedTime;
+  }
+
+  this->_traceJob ( ( ( true == queued ) ? Trace::ENQUEUE : Trace::WAIT ), job );
+}
+void Manager::_jobQueued ( Job &job )
+{
+  if ( ( true == _isRecordingJobTimes ) && ( TimePoint() != job._addedTime ) )
+  {
+    job._queuedTime = Clock::now();
+  }
+
+  this->_traceJob ( Trace::ENQUEUE, job );
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Record the times of the job that ran.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void Manager::_recordJobTimes ( const Job &job, TimePoint started, TimePoint finished )
+{
+  typedef std::chrono::microseconds Microseconds;
+  typedef Histogram::Value Value;
+
+  auto toValue = [] ( Clock::duration d )
+  {
+    const Microseconds::rep us = std::chrono::duration_cast < Microseconds > ( d ).count();
+    return static_cast < Value > ( ( us > 0 ) ? us : 0 );
+  };
+
+  const Value queued = toValue ( started - job._queuedTime );
+  const Value running = toValue ( finished - started );
+  const Value total = toValue ( finished - job._addedTime );
+
+  _jobTimes.queued.add ( queued );
+  _jobTimes.running.add ( running );
+  _jobTimes.total.add ( total );
+
+  JobTimesRecord *record = this->_getJobTimesRecord ( job._name );
+  if ( nullptr != record )
+  {
+    record->queued.add ( queued );
+    record->running.add ( running );
+    record->total.add ( total );
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Get/set if the manager traces what its threads do.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+bool Manager::isTracing() const
+{
+  return _isTracing; // This is atomic.
+}
+void Manager::setTracing ( bool state )
+{
+  _isTracing = state; // This is atomic.
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Write the trace, or remove the events from it.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void Manager::writeTrace ( std::ostream &out ) const
+{
+  _trace.write ( out );
+}
+void Manager::clearTrace()
+{
+  _trace.clear();
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Lock the mutex. When tracing, the time spent waiting for it is recorded.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void Manager::_lockMutex ( std::unique_lock < Mutex > &lock )
+{
+  if ( ( false == _isTracing ) || ( true == lock.try_lock() ) )
+  {
+    if ( false == lock.owns_lock() )
+    {
+      lock.lock();
+    }
+    return;
+  }
+
+  const TimePoint start = Clock::now();
+  lock.lock();
+  const std::chrono::microseconds waited = std::chrono::duration_cast < std::chrono::microseconds > ( Clock::now() - start );
+
+  _trace.record ( Trace::LOCK, 0, Details::mutexName, static_cast < std::uint64_t > ( waited.count() ) );
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Trace the start and end of what the calling thread is doing.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void Manager::_traceBegin ( const char *name )
+{
+  if ( true == _isTracing )
+  {
+    _trace.record ( Trace::BEGIN, 0, name );
+  }
+}
+void Manager::_traceEnd ( const char *name )
+{
+  if ( true == _isTracing )
+  {
+    _trace.record ( Trace::END, 0, name );
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Trace what happened to the job.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void Manager::_traceJob ( Trace::Type type, const Job &job )
+{
+  if ( true == _isTracing )
+  {
+    _trace.record ( type, job.getID(), job._name );
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Get the names of the queued jobs.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void Manager::getQueuedJobNames ( Names &names ) const
+{
+  Guard guard ( _mutex );
+
+  // This moves the jobs from the ring to the queue. It does not change
+  // which jobs are queued.
+  const_cast < Manager * > ( this )->_drainSubmissions();
+
+  auto addName = [ &names ] ( const JobPtr &job )
   {
     names.push_back ( job->getName() );
+  };
+
+  _queuedJobs.forEach ( addName );
+
+  for ( unsigned int i = 1; i < _numLanes; ++i )
+  {
+    LaneInfo &lane = *_lanes[i];
+    Guard laneGuard ( lane.mutex );
+    lane.queue.forEach ( addName );
+  }
+}
+Manager::Names Manager::getQueuedJobNames() const
+{
+  Names names;
+  this->getQueuedJobNames ( names );
+  return names;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Get the number of jobs.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+unsigned int Manager::getNumJobs() const
+{
+  // Do not lock the mutex here!
+
+  // A job is counted where it's going before it's no longer counted where
+  // it was, so reading the counters in the order that the jobs move through
+  // them never misses one. A job is in transition if it has been taken out
+  // of the queue but not yet put into the list of running jobs.
+  const unsigned int numWaiting = _numJobsWaiting; // This is atomic.
+  const unsigned int numQueued = this->getNumJobsQueued();
+  const unsigned int numInTransition = ( _hasJobInTransition ? 1 : 0 );
+  const unsigned int numRunning = this->getNumJobsRunning();
+  return ( numWaiting + numQueued + numInTransition + numRunning );
+}
+unsigned int Manager::getNumJobsRunning() const
+{
+  // These are all atomic.
+  return ( _numJobsRunningInThreads + _numJobsRunningInPool + _numJobsRunningInLanes );
+}
+unsigned int Manager::getNumJobsQueued() const
+{
+  // These are all atomic. The submitted jobs move to the queue.
+  const unsigned int numSubmitted = _numJobsSubmitted;
+  const unsigned int numInQueue = static_cast < unsigned int > ( _queuedJobs.size() );
+  return ( numSubmitted + numInQueue + _numJobsInDeques + _numJobsInLanes );
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Get/set the maximum number of queued jobs.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+unsigned int Manager::getMaxNumJobsQueued() const
+{
+  return _maxNumJobsQueued; // This is atomic.
+}
+void Manager::setMaxNumJobsQueued ( unsigned int num )
+{
+  if ( 0 == num )
+  {
+    throw std::invalid_argument ( "Maximum number of queued jobs must be at least one" );
+  }
+
+  _maxNumJobsQueued = num; // This is atomic.
+
+  // There may be room now.
+  this->_notifyIfRoom();
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Get/set the maximum number of threads allowed. If more threads are
+//  currently running than the new maximum, it does not stop them.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+unsigned int Manager::getMaxNumThreadsAllowed() const
+{
+  return _maxNumThreadsAllowed; // This is atomic.
+}
+void Manager::setMaxNumThreadsAllowed ( unsigned int num )
+{
+  IS_NOT_WORKER_THREAD_OR_THROW;
+  _maxNumThreadsAllowed = num; // This is atomic.
+
+  // If the pool is already going then it may need more threads.
+  bool hasPool = false;
+  {
+    Guard guard ( _mutex );
+    hasPool = ( false == _poolThreads.empty() );
+  }
+  if ( true == hasPool )
+  {
+    this->_startPoolThreads();
+  }
+
+  // Idle threads may now be allowed to run jobs, or not.
+  this->_wakeThreads ( true );
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Adapt the maximum number of threads to the jobs.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void Manager::adaptNumThreads ( unsigned int minNumThreads, unsigned int maxNumThreads, unsigned int milliseconds )
+{
+  IS_NOT_WORKER_THREAD_OR_THROW;
+
+  // Check input.
+  if ( 0 == minNumThreads )
+  {
+    throw std::invalid_argument ( "Minimum number of threads must be at least one" );
+  }
+  if ( minNumThreads > maxNumThreads )
+  {
+    throw std::invalid_argument ( Usul::Strings::format (
+      "Minimum number of threads ", minNumThreads,
+      " is more than the maximum ", maxNumThreads ) );
+  }
+  if ( 0 == milliseconds )
+  {
+    throw std::invalid_argument ( "Interval of adapting must be at least one millisecond" );
+  }
+
+  // The timer that is already going, if any, stops when it sees this.
+  const unsigned int generation = ++_adaptGeneration;
+  _adaptMinNumThreads = minNumThreads;
+  _adaptMaxNumThreads = maxNumThreads;
+  _adaptWallTime = 0;
+  _adaptThreadTime = 0;
+  _isAdapting = true;
+
+  // Start within the bounds.
+  const unsigned int current = this->getMaxNumThreadsAllowed();
+  const unsigned int num = std::min ( maxNumThreads, std::max ( minNumThreads, current ) );
+  if ( num != current )
+  {
+    this->setMaxNumThreadsAllowed ( num );
+  }
+
+  Timer timer;
+  timer.period = milliseconds;
+  timer.fun = [ this, generation ] () { return this->_adaptNumThreads ( generation ); };
+  this->_addTimer ( timer, Clock::now() + std::chrono::milliseconds ( milliseconds ) );
+}
+void Manager::stopAdaptingNumThreads()
+{
+  ++_adaptGeneration;
+  _isAdapting = false;
+}
+bool Manager::isAdaptingNumThreads() const
+{
+  return _isAdapting; // This is atomic.
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Change the maximum number of threads if we should. Called on the timer
+//  thread. Returns false when it should stop.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+bool Manager::_adaptNumThreads ( unsigned int generation )
+{
+  // Stop if it was stopped or started again.
+  if ( ( generation != _adaptGeneration ) || ( true == _isBeingDestroyed ) )
+  {
+    return false;
+  }
+
+  // The fraction of the time that the jobs were blocked. If no job finished
+  // since the last time then keep the last one.
+  const std::uint64_t wallTime = _adaptWallTime.exchange ( 0 );
+  const std::uint64_t threadTime = _adaptThreadTime.exchange ( 0 );
+  if ( wallTime > 0 )
+  {
+    _adaptBlocked = 1.0 - std::min ( 1.0, static_cast < double > ( threadTime ) / static_cast < double > ( wallTime ) );
+  }
+
+  // The number of processors reads files in a container, so only look
+  // again every few seconds. It changes when the quota or affinity does.
+  const TimePoint now = Clock::now();
+  if ( ( 0 == _adaptNumProcessors ) || ( ( now - _adaptProcessorsTime ) >= std::chrono::seconds ( 10 ) ) )
+  {
+    _adaptNumProcessors = Usul::System::Processors::getNumAvailable();
+    _adaptProcessorsTime = now;
+  }
+
+  // This many threads keep the processors busy when the jobs are blocked
+  // that fraction of the time. Do not let a job that only sleeps make it
+  // huge; the upper bound is there for that too.
+  const unsigned int numProcessors = _adaptNumProcessors;
+  const double computing = std::max ( 0.05, 1.0 - _adaptBlocked );
+  const unsigned int target = static_cast < unsigned int > ( std::ceil ( static_cast < double > ( numProcessors ) / computing ) );
+
+  // Get the number of jobs waiting for the pool and running in it.
+  unsigned int numQueued = 0;
+  {
+    Guard guard ( _mutex );
+    const unsigned int numInDeques = _numJobsInDeques; // This is atomic.
+    const unsigned int numSubmitted = _numJobsSubmitted; // This is atomic.
+    numQueued = static_cast < unsigned int > ( _queuedJobs.size() ) + numInDeques + numSubmitted;
+  }
+  const unsigned int numRunning = _numJobsRunningInPool; // This is atomic.
+
+  // Grow toward the target when jobs are waiting, but not by more than the
+  // number waiting. Otherwise shrink one thread at a time, so that a short
+  // lull does not drop threads that are needed again right away.
+  const unsigned int current = this->getMaxNumThreadsAllowed();
+  unsigned int num = current;
+  if ( numQueued > 0 )
+  {
+    num = ( ( current < target ) ? std::min ( target, current + numQueued ) : target );
+  }
+  else if ( current > numRunning )
+  {
+    num = current - 1;
+  }
+
+  // Stay within the bounds.
+  num = std::min ( _adaptMaxNumThreads.load(), std::max ( _adaptMinNumThreads.load(), num ) );
+
+  if ( num != current )
+  {
+    this->setMaxNumThreadsAllowed ( num );
+  }
+
+  return true;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Add a lane with its own queue and threads.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+Manager::Lane Manager::addLane ( const std::string &name, unsigned int maxNumThreads )
+{
+  return this->_addLane ( name, maxNumThreads, ProcessorIndices() );
+}
+Manager::Lane Manager::_addLane ( const std::string &name, unsigned int maxNumThreads, const ProcessorIndices &processors )
+{
+  // One thread at a time.
+  Guard guard ( _mutex );
+
+  // The name has to be unique.
+  if ( ( Details::defaultLaneName == name ) || ( std::any_of ( _lanes + 1, _lanes + _numLanes, [ &name ] ( const LanePtr &lane ) { return ( name == lane->name ); } ) ) )
+  {
+    throw std::runtime_error ( Usul::Strings::format ( "Lane '", name, "' already exists" ) );
+  }
+
+  const Lane lane = _numLanes;
+  if ( lane >= MAX_NUM_LANES )
+  {
+    throw std::runtime_error ( Usul::Strings::format ( "Can not have more than ", static_cast < unsigned int > ( MAX_NUM_LANES ), " lanes" ) );
+  }
+
+  // Other threads look at the lanes without locking the mutex, so make the
+  // lane before counting it.
+  _lanes[lane].reset ( new LaneInfo ( name, maxNumThreads, processors ) );
+  _lanes[lane]->queue.setPolicy ( _queuedJobs.getPolicy() );
+  _lanes[lane]->queue.setAgingRate ( _queuedJobs.getAgingRate() );
+  ++_numLanes;
+
+  return lane;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Add a job to the given lane.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+Manager::JobPtr Manager::addJob ( Lane lane, Callback cb )
+{
+  JobPtr job = Details::makeJob ( cb );
+  job->setLane ( lane );
+  this->addJob ( job );
+  return job;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Return the lane for the NUMA node, adding it the first time.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+Manager::Lane Manager::getNodeLane ( unsigned int node )
+{
+  typedef Usul::System::Processors Processors;
+
+  if ( node >= Processors::getNumNodes() )
+  {
+    throw std::invalid_argument ( Usul::Strings::format ( "There is no node ", node ) );
+  }
+
+  // One thread at a time, so that it's only added once.
+  Guard guard ( _mutex );
+
+  const std::string name ( Usul::Strings::format ( "node ", node ) );
+  for ( unsigned int i = 1; i < _numLanes; ++i )
+  {
+    if ( name == _lanes[i]->name )
+    {
+      return i;
+    }
+  }
+
+  const Processors::Indices processors = Processors::getNodeProcessors ( node );
+  if ( true == processors.empty() )
+  {
+    throw std::runtime_error ( Usul::Strings::format ( "Node ", node, " has no processors that can be used" ) );
+  }
+
+  // The lane's threads run on top of the pool's, so it only gets the pool's
+  // share of the node: the threads that AFFINITY_NODE puts there. Otherwise
+  // the node would have a thread for each processor plus the pool's.
+  const unsigned int numPoolThreads = this->getMaxNumThreadsAllowed();
+  unsigned int share = 0;
+  for ( unsigned int i = 0; i < numPoolThreads; ++i )
+  {
+    const ProcessorIndices where = Details::getPoolThreadProcessors ( AFFINITY_NODE, i, _processors );
+    if ( ( false == where.empty() ) && ( processors.end() != std::find ( processors.begin(), processors.end(), where.front() ) ) )
+    {
+      ++share;
+    }
+  }
+  share = std::max ( 1u, std::min ( share, static_cast < unsigned int > ( processors.size() ) ) );
+
+  return this->_addLane ( name, share, processors );
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Return the lane with the name.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+Manager::Lane Manager::getLane ( const std::string &name ) const
+{
+  if ( Details::defaultLaneName == name )
+  {
+    return DEFAULT_LANE;
+  }
+
+  for ( unsigned int i = 1; i < _numLanes; ++i )
+  {
+    if ( name == _lanes[i]->name )
+    {
+      return i;
+    }
+  }
+
+  throw std::invalid_argument ( Usul::Strings::format ( "There is no lane '", name, "'" ) );
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Get the name of the lane, and the number of lanes.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+std::string Manager::getLaneName ( Lane lane ) const
+{
+  const LaneInfo *info = this->_getLane ( lane );
+  return ( ( nullptr == info ) ? Details::defaultLaneName : info->name );
+}
+unsigned int Manager::getNumLanes() const
+{
+  return _numLanes; // This is atomic.
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Get/set the maximum number of threads in the lane.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+unsigned int Manager::getMaxNumThreadsAllowed ( Lane lane ) const
+{
+  const LaneInfo *info = this->_getLane ( lane );
+  return ( ( nullptr == info ) ? this->getMaxNumThreadsAllowed() : info->maxNumThreads.load() );
+}
+void Manager::setMaxNumThreadsAllowed ( Lane lane, unsigned int num )
+{
+  LaneInfo *info = this->_getLane ( lane );
+  if ( nullptr == info )
+  {
+    this->setMaxNumThreadsAllowed ( num );
+    return;
+  }
+
+  info->maxNumThreads = num; // This is atomic.
+
+  // If the lane is already going then it may need more threads.
+  {
+    Guard guard ( info->mutex );
+    if ( false == info->threads.empty() )
+    {
+      this->_startLaneThreads ( *info );
+    }
+  }
+
+  // Idle threads may now be allowed to run jobs, or not.
+  info->condition.notify_all();
+  info->parkCondition.notify_all();
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Return the lane. Returns null for the default lane, and throws if there
+//  is no such lane. Lanes are never removed, so this does not lock.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+Manager::LaneInfo *Manager::_getLane ( Lane lane ) const
+{
+  if ( DEFAULT_LANE == lane )
+  {
+    return nullptr;
+  }
+
+  if ( lane >= _numLanes )
+  {
+    throw std::invalid_argument ( Usul::Strings::format ( "There is no lane ", lane ) );
+  }
+
+  return _lanes[lane].get();
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Add the job to its lane's queue. Returns false if it's in the default
+//  lane, which means it should go to the pool.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+bool Manager::_addLaneJob ( JobPtr job )
+{
+  LaneInfo *lane = this->_getLane ( job->getLane() );
+  if ( nullptr == lane )
+  {
+    return false;
+  }
+
+  {
+    Guard guard ( lane->mutex );
+    lane->queue.push ( job );
+    ++_numJobsInLanes;
+    this->_startLaneThreads ( *lane );
+  }
+
+  lane->condition.notify_one();
+  return true;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Start the threads in the lane. Call this with the lane's mutex locked.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void Manager::_startLaneThreads ( LaneInfo &lane )
+{
+  // Do not start them if they are being stopped.
+  if ( false == lane.shouldRun )
+  {
+    return;
+  }
+
+  // Make more threads until we have enough. If there are already more than
+  // the maximum then the extra ones just stay idle.
+  while ( lane.threads.size() < lane.maxNumThreads )
+  {
+    const unsigned int index = static_cast < unsigned int > ( lane.threads.size() );
+    lane.running.push_back ( JobPtr() );
+
+    LaneInfo *raw = &lane;
+    lane.threads.push_back ( ThreadPtr ( new std::thread ( [ this, raw, index ] ()
+    {
+      // If an exception sneaks through it will bring down the house.
+      try
+      {
+        this->_laneThreadStarted ( *raw, index );
+      }
+      JOB_MANAGER_CATCH_EXCEPTIONS ( 1700853391, JobPtr() )
+    } ) ) );
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Stop the threads in the lanes. The jobs left in their queues will never
+//  run so they are done.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void Manager::_stopLaneThreads()
+{
+  for ( unsigned int i = 1; i < _numLanes; ++i )
+  {
+    LaneInfo &lane = *_lanes[i];
+
+    std::vector < ThreadPtr > threads;
+    {
+      Guard guard ( lane.mutex );
+      lane.shouldRun = false; // This variable is atomic.
+      threads.swap ( lane.threads );
+    }
+    lane.condition.notify_all();
+    lane.parkCondition.notify_all();
+
+    // Wait for them to finish. Do not lock the mutex because they need it.
+    for ( auto j = threads.begin(); j != threads.end(); ++j )
+    {
+      (*j)->join();
+    }
+
+    Queue::Jobs jobs;
+    {
+      Guard guard ( lane.mutex );
+      _numJobsInLanes -= static_cast < unsigned int > ( lane.queue.size() );
+      lane.queue.clear ( jobs );
+      lane.running.clear();
+    }
+    std::for_each ( jobs.begin(), jobs.end(), [] ( JobPtr job )
+    {
+      job->done();
+    } );
+  }
+
+  this->_notifyIfAllDone();
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Called when a thread in a lane starts. It runs the lane's jobs.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void Manager::_laneThreadStarted ( LaneInfo &lane, unsigned int index )
+{
+  Trace::setThreadName ( Usul::Strings::format ( lane.name, ' ', index ) );
+
+  // Run where the lane says to, or anywhere. It's only a hint if it can not.
+  Usul::System::Processors::setThreadAffinity ( ( true == lane.processors.empty() ) ? _processors : lane.processors );
+
+  // Loop until told otherwise.
+  while ( true )
+  {
+    JobPtr job;
+    {
+      // The condition needs a lock, and it releases it while waiting.
+      std::unique_lock < Mutex > lock ( lane.mutex );
+
+      // Threads beyond the maximum allowed wait on their own condition until
+      // that changes, so that a new job always wakes a thread that can run it.
+      while ( true )
+      {
+        if ( index >= lane.maxNumThreads )
+        {
+          lane.parkCondition.wait ( lock, [ &lane, index ] ()
+          {
+            return ( ( false == lane.shouldRun ) || ( index < lane.maxNumThreads ) );
+          } );
+        }
+        else
+        {
+          lane.condition.wait ( lock, [ &lane, index ] ()
+          {
+            return ( ( false == lane.shouldRun ) || ( index >= lane.maxNumThreads ) || ( false == lane.queue.empty() ) );
+          } );
+        }
+
+        if ( false == lane.shouldRun )
+        {
+          return;
+        }
+
+        if ( ( index < lane.maxNumThreads ) && ( false == lane.queue.empty() ) )
+        {
+          break;
+        }
+      }
+
+      // Increment first so that the job is always counted.
+      job = lane.queue.pop();
+      ++_numJobsRunningInLanes;
+      --_numJobsInLanes;
+      lane.running.at ( index ) = job;
+    }
+
+    this->_traceJob ( Trace::DEQUEUE, *job );
+
+    // Run the job in this thread if we should. Otherwise, it's done.
+    if ( ( true == Details::shouldRunJob ( job ) ) && ( true == job->_start() ) )
+    {
+      this->_runJob ( job );
+    }
+    else
+    {
+      this->_traceJob ( Trace::CANCEL, *job );
+      job->done();
+    }
+
+    // The job is no longer running.
+    {
+      Guard guard ( lane.mutex );
+      lane.running.at ( index ) = nullptr;
+    }
+
+    // That may have been the last one.
+    if ( 0 == --_numJobsRunningInLanes )
+    {
+      this->_notifyIfAllDone();
+    }
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Get/set the number of milliseconds to sleep.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+unsigned int Manager::getNumMillisecondsToSleep() const
+{
+  return _numMillisecondsToSleep; // This is atomic.
+}
+void Manager::setNumMillisecondsToSleep ( unsigned int num )
+{
+  IS_NOT_WORKER_THREAD_OR_THROW;
+  _numMillisecondsToSleep = num; // This is atomic.
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Get/set the thread model. The model can only be changed when there are
+//  no jobs.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+Manager::ThreadModel Manager::getThreadModel() const
+{
+  return _threadModel; // This is atomic.
+}
+void Manager::setThreadModel ( ThreadModel model )
+{
+  IS_NOT_WORKER_THREAD_OR_THROW;
+
+  // Handle no change.
+  if ( model == this->getThreadModel() )
+  {
+    return;
+  }
+
+  // Make sure there are no jobs.
+  if ( this->getNumJobs() > 0 )
+  {
+    throw std::runtime_error ( "Can not change the thread model when there are jobs" );
+  }
+
+  // Stop the threads of the current model. They get started when needed.
+  this->_stopWorkerThread();
+  this->_stopPoolThreads();
+
+  _threadModel = model; // This is atomic.
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Get/set the wake model.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+Manager::WakeModel Manager::getWakeModel() const
+{
+  return _wakeModel; // This is atomic.
+}
+void Manager::setWakeModel ( WakeModel model )
+{
+  _wakeModel = model; // This is atomic.
+
+  // Threads that are waiting for an event should look again.
+  this->_wakeThreads ( true );
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Get/set where the threads in the pool run.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+Manager::Affinity Manager::getAffinity() const
+{
+  return _affinity; // This is atomic.
+}
+void Manager::setAffinity ( Affinity affinity )
+{
+  _affinity = affinity; // This is atomic.
+
+  // The idle threads change when they wake up.
+  this->_wakeThreads ( true );
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Get/set the scheduler. The scheduler can only be changed when there are
+//  no jobs.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+Manager::Scheduler Manager::getScheduler() const
+{
+  return _scheduler; // This is atomic.
+}
+void Manager::setScheduler ( Scheduler scheduler )
+{
+  IS_NOT_WORKER_THREAD_OR_THROW;
+
+  // Handle no change.
+  if ( scheduler == this->getScheduler() )
+  {
+    return;
+  }
+
+  // Make sure there are no jobs.
+  if ( this->getNumJobs() > 0 )
+  {
+    throw std::runtime_error ( "Can not change the scheduler when there are jobs" );
+  }
+
+  _scheduler = scheduler; // This is atomic.
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Get/set the order that the queued jobs run in.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+Manager::QueuePolicy Manager::getQueuePolicy() const
+{
+  return _queuedJobs.getPolicy();
+}
+void Manager::setQueuePolicy ( QueuePolicy policy )
+{
+  Guard guard ( _mutex );
+  _queuedJobs.setPolicy ( policy );
+
+  // Same for the queues of the lanes.
+  for ( unsigned int i = 1; i < _numLanes; ++i )
+  {
+    LaneInfo &lane = *_lanes[i];
+    Guard laneGuard ( lane.mutex );
+    lane.queue.setPolicy ( policy );
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Get/set how much a queued job's priority grows for every second.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+double Manager::getAgingRate() const
+{
+  return _queuedJobs.getAgingRate();
+}
+void Manager::setAgingRate ( double rate )
+{
+  Guard guard ( _mutex );
+  _queuedJobs.setAgingRate ( rate );
+
+  // Same for the queues of the lanes.
+  for ( unsigned int i = 1; i < _numLanes; ++i )
+  {
+    LaneInfo &lane = *_lanes[i];
+    Guard laneGuard ( lane.mutex );
+    lane.queue.setAgingRate ( rate );
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Wake up the threads that are waiting for an event.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void Manager::_wakeThreads ( bool all )
+{
+  // Lock the mutex so that no thread is between looking for something to do
+  // and waiting. Otherwise, it could miss this notification.
+  {
+    Guard guard ( _mutex );
+  }
+
+  if ( true == all )
+  {
+    _wakeCondition.notify_all();
+    _parkCondition.notify_all();
+  }
+  else
+  {
+    _wakeCondition.notify_one();
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Get/set the flag that says we should run the worker thread.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+bool Manager::_getShouldRunWorkerThread() const
+{
+  return _shouldRunWorkerThread; // This is atomic.
+}
+void Manager::_setShouldRunWorkerThread ( bool state )
+{
+  IS_NOT_WORKER_THREAD_OR_THROW;
+  _shouldRunWorkerThread = state; // This is atomic.
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Wait for all jobs to complete.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void Manager::waitAll()
+{
+  IS_NOT_WORKER_THREAD_OR_THROW;
+
+  // We could guard this function so that no new jobs are queued and start
+  // running while we are in here. On the other hand, we could make the mutex
+  // available and let the user decide if that is desired.
+
+  // The condition needs a lock, and it releases it while waiting.
+  // Do not call this function when the mutex is already locked.
+  std::unique_lock < Mutex > lock ( _mutex );
+
+  // Wait until there are no queued or running jobs.
+  _allDoneCondition.wait ( lock, [ this ] ()
+  {
+    return ( 0 == this->getNumJobs() );
+  } );
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Let anyone waiting know if there are no more jobs.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void Manager::_notifyIfAllDone()
+{
+  // Only lock if there may be nothing left. The waiter checks again with
+  // the mutex locked, so it does not miss this.
+  if ( 0 != this->getNumJobs() )
+  {
+    return;
+  }
+
+  Guard guard ( _mutex );
+  if ( 0 == this->getNumJobs() )
+  {
+    _allDoneCondition.notify_all();
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Let the threads waiting for room in the queue look again.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void Manager::_notifyIfRoom()
+{
+  // Only lock if a thread is waiting. See _waitForRoom().
+  if ( 0 == _numThreadsWaitingForRoom )
+  {
+    return;
+  }
+
+  Guard guard ( _mutex );
+  _roomCondition.notify_all();
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Should the calling thread wait when the queue is full? The threads in
+//  the pool do not, because they may be the ones that would make room.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+bool Manager::_shouldWaitForRoom() const
+{
+  if ( std::numeric_limits < unsigned int >::max() == this->getMaxNumJobsQueued() )
+  {
+    return false;
+  }
+
+  return ( false == this->_isPoolThread() );
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Wait until the queue has room for the given number of jobs. Call this
+//  with the mutex locked once. Returns false if the time ran out.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+bool Manager::_waitForRoom ( std::unique_lock < Mutex > &lock, std::size_t numJobs, bool waitForever, unsigned int milliseconds )
+{
+  // The threads that take jobs decrement the number queued and then look
+  // for waiting threads, and this thread does the opposite, so one of them
+  // sees the other.
+  ++_numThreadsWaitingForRoom;
+  USUL_SCOPED_CALL ( [ this ] ()
+  {
+    --_numThreadsWaitingForRoom; // This variable is atomic.
+  } );
+
+  auto hasRoom = [ this, numJobs ] ()
+  {
+    // Stop waiting if we're being destroyed or reset.
+    if ( ( true == _isBeingDestroyed ) || ( true == _isBeingReset ) )
+    {
+      return true;
+    }
+
+    // The jobs in the other lanes do not count.
+    const std::size_t maxNumQueued = this->getMaxNumJobsQueued();
+    const std::size_t numInDeques = _numJobsInDeques; // This is atomic.
+    const std::size_t numSubmitted = _numJobsSubmitted; // This is atomic.
+    const std::size_t numQueued = _queuedJobs.size() + numInDeques + numSubmitted;
+    return ( ( numQueued < maxNumQueued ) && ( numJobs <= ( maxNumQueued - numQueued ) ) );
+  };
+
+  if ( true == waitForever )
+  {
+    _roomCondition.wait ( lock, hasRoom );
+  }
+  else if ( false == _roomCondition.wait_for ( lock, std::chrono::milliseconds ( milliseconds ), hasRoom ) )
+  {
+    return false;
+  }
+
+  // We may have stopped waiting because of this.
+  this->_canAddJobsOrThrow();
+
+  return true;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Functions for checking threads.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+bool Manager::_isPoolThread() const
+{
+  return ( ( this == Details::currentManager ) && ( nullptr != Details::currentPoolThread ) );
+}
+bool Manager::_isWorkerThread() const
+{
+  return ( std::this_thread::get_id() == _workerID );
+}
+void Manager::_isWorkerThreadOrThrow() const
+{
+  if ( false == this->_isWorkerThread() )
+  {
+    throw std::runtime_error ( "The current thread should be the worker thread" );
+  }
+}
+void Manager::_isNotWorkerThreadOrThrow() const
+{
+  if ( true == this->_isWorkerThread() )
+  {
+    throw std::runtime_error ( "The current thread should not be the worker thread" );
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Start the worker thread.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void Manager::_startWorkerThread()
+{
+  IS_NOT_WORKER_THREAD_OR_THROW;
+
+  // One thread at a time.
+  Guard guard ( _mutex );
+
+  // Do not start the worker thread if it's already running.
+  if ( nullptr == _workerThread.get() )
+  {
+    // It may have been stopped before.
+    _shouldRunWorkerThread = true; // This variable is atomic.
+
+    // Make the new thread. Need a lambda here that assigns _workerID before
+    // calling the thread's function. Otherwise, it could start executing the
+    // thread before it assigns _workerID below, and then _isWorkerThreadOrThrow()
+    // will throw an exception when it should not.
+    _workerThread = ThreadPtr ( new std::thread ( [ this ] ()
+    {
+      // If an exception sneaks through it will bring down the house.
+      try
+      {
+        // Assign the thread-id of this worker-thread. It is an atomic
+        // std::thread::id so no need to lock the mutex to access it.
+        // This helps avoid deadlock.
+        _workerID = std::this_thread::get_id();
+
+        // TODO: At one point, without this _isWorkerThreadOrThrow() would
+        // throw an exception. Is this still needed?
+        // std::this_thread::sleep_for ( std::chrono::milliseconds ( this->getNumMillisecondsToSleep() ) );
+
+        // Now run this new thread.
+        this->_threadStarted();
+      }
+      JOB_MANAGER_CATCH_EXCEPTIONS ( 1591247240, JobPtr() )
+    } ) );
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Stop the worker thread.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void Manager::_stopWorkerThread()
+{
+  IS_NOT_WORKER_THREAD_OR_THROW;
+
+  // The worker thread should break out of its loop.
+  this->_setShouldRunWorkerThread ( false );
+  this->_wakeThreads ( true );
+
+  // Make a copy of the worker thread pointer then make it null.
+  ThreadPtr worker = nullptr;
+  {
+    Guard guard ( _mutex );
+    worker = _workerThread;
+    _workerThread = nullptr;
+  }
+
+  // We're done with our worker thread.
+  if ( nullptr != worker.get() )
+  {
+    // Wait for it to finish.
+    worker->join();
+
+    // Now we can do this, but not before.
+    _workerID = std::thread::id();
+
+    // This should be the last reference so it will get deleted.
+    worker = nullptr;
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Start the threads in the pool. There is one for each thread allowed.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void Manager::_startPoolThreads()
+{
+  // One thread at a time.
+  Guard guard ( _mutex );
+
+  // Do not start them if they are being stopped.
+  if ( ( true == _poolThreads.empty() ) && ( false == _isBeingDestroyed ) )
+  {
+    _shouldRunPoolThreads = true; // This variable is atomic.
+  }
+  if ( false == _shouldRunPoolThreads )
+  {
+    return;
+  }
+
+  // Make more threads until we have enough. If there are already more than
+  // the maximum then the extra ones just stay idle.
+  const unsigned int maxNumThreads = this->getMaxNumThreadsAllowed();
+  if ( _poolThreads.size() >= maxNumThreads )
+  {
+    return;
+  }
+
+  while ( _poolThreads.size() < maxNumThreads )
+  {
+    // Make the record for the new thread before the thread starts.
+    PoolThreadPtr pt ( new PoolThread ( static_cast < unsigned int > ( _poolThreads.size() ) ) );
+    _poolThreads.push_back ( pt );
+
+    // Make the new thread.
+    PoolThread *raw = pt.get();
+    pt->thread = ThreadPtr ( new std::thread ( [ this, raw ] ()
+    {
+      // If an exception sneaks through it will bring down the house.
+      try
+      {
+        this->_poolThreadStarted ( *raw );
+      }
+      JOB_MANAGER_CATCH_EXCEPTIONS ( 1700158463, JobPtr() )
+    } ) );
+  }
+
+  // Threads that steal look in this table without locking the mutex. Since
+  // one of them may be looking in the current table, it's kept until the
+  // threads are stopped.
+  PoolTablePtr table ( new PoolTable );
+  std::for_each ( _poolThreads.begin(), _poolThreads.end(), [ &table ] ( PoolThreadPtr pt )
+  {
+    table->push_back ( pt.get() );
+  } );
+  _poolTable = table.get(); // This is atomic.
+  _poolTables.push_back ( std::move ( table ) );
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Stop the threads in the pool.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void Manager::_stopPoolThreads()
+{
+  IS_NOT_WORKER_THREAD_OR_THROW;
+
+  // Make a copy of the threads. The pool stays as it is until the threads
+  // are finished so that no new ones get started in the mean time.
+  PoolThreads threads;
+  {
+    Guard guard ( _mutex );
+
+    // The threads should break out of their loops.
+    _shouldRunPoolThreads = false; // This variable is atomic.
+
+    threads = _poolThreads;
+  }
+
+  // Wake them up if they are waiting.
+  this->_wakeThreads ( true );
+
+  // Wait for them to finish. Do not lock the mutex because they need it.
+  for ( auto i = threads.begin(); i != threads.end(); ++i )
+  {
+    (*i)->thread->join();
+  }
+
+  // Any jobs left in the deques or the ring will never run.
+  this->_clearDeques();
+  this->_clearSubmissions();
+
+  // Now we can do this, but not before.
+  {
+    Guard guard ( _mutex );
+    _poolTable = nullptr; // This is atomic.
+    _poolThreads.clear();
+    _poolTables.clear();
+  }
+
+  // There may not be any jobs now, and there may be room for more.
+  this->_notifyIfAllDone();
+  this->_notifyIfRoom();
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Called when a thread in the pool starts.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void Manager::_poolThreadStarted ( PoolThread &pt )
+{
+  // Do not lock mutex here!
+
+  // So that jobs added from this thread can find its deque.
+  Details::currentManager = this;
+  Details::currentPoolThread = &pt;
+
+  Trace::setThreadName ( Usul::Strings::format ( "pool ", pt.index ) );
+
+  // This thread may have been started by a thread that only runs on some
+  // processors, so always set where it runs.
+  Affinity affinity = this->getAffinity();
+  Usul::System::Processors::setThreadAffinity ( Details::getPoolThreadProcessors ( affinity, pt.index, _processors ) );
+
+  // Loop until told otherwise.
+  while ( true == _shouldRunPoolThreads )
+  {
+    // Move this thread if we should.
+    if ( affinity != this->getAffinity() )
+    {
+      affinity = this->getAffinity();
+      Usul::System::Processors::setThreadAffinity ( Details::getPoolThreadProcessors ( affinity, pt.index, _processors ) );
+    }
+
+    // Get the next job. This also makes it one of the running jobs.
+    JobPtr job = this->_getNextQueuedJob ( pt );
+
+    // If there is no job then wait for one.
+    if ( nullptr == job.get() )
+    {
+      this->_poolThreadWait ( pt );
+      continue;
+    }
+
+    this->_traceJob ( Trace::DEQUEUE, *job );
+
+    // There is room in the queue now.
+    this->_notifyIfRoom();
+
+    // Run the job in this thread if we should. Otherwise, it's done.
+    if ( ( true == Details::shouldRunJob ( job ) ) && ( true == job->_start() ) )
+    {
+      if ( true == _isAdapting )
+      {
+        // Measure how much of the time the job was computing.
+        const TimePoint start = Clock::now();
+        const std::uint64_t threadTime = Usul::System::Processors::getThreadTime();
+
+        this->_runJob ( job );
+
+        _adaptThreadTime += ( Usul::System::Processors::getThreadTime() - threadTime );
+        _adaptWallTime += static_cast < std::uint64_t > ( std::chrono::duration_cast < std::chrono::microseconds > ( Clock::now() - start ).count() );
+      }
+      else
+      {
+        this->_runJob ( job );
+      }
+    }
+    else
+    {
+      this->_traceJob ( Trace::CANCEL, *job );
+      job->done();
+    }
+
+    // The job is no longer running.
+    {
+      std::lock_guard < std::mutex > guard ( pt.mutex );
+      pt.job = nullptr;
+    }
+
+    // That may have been the last one.
+    if ( 0 == --_numJobsRunningInPool )
+    {
+      this->_notifyIfAllDone();
+    }
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Called when a thread in the pool has nothing to do.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void Manager::_poolThreadWait ( const PoolThread &pt )
+{
+  // Sleep some so that we don't spike the cpu.
+  if ( WAKE_BY_POLLING == this->getWakeModel() )
+  {
+    this->_traceBegin ( "sleep" );
+    std::this_thread::sleep_for ( std::chrono::milliseconds ( this->getNumMillisecondsToSleep() ) );
+    this->_traceEnd ( "sleep" );
+    return;
+  }
+
+  // The condition needs a lock, and it releases it while waiting.
+  std::unique_lock < Mutex > lock ( _mutex, std::defer_lock );
+  this->_lockMutex ( lock );
+
+  // Threads beyond the maximum allowed wait until that changes.
+  if ( pt.index >= this->getMaxNumThreadsAllowed() )
+  {
+    this->_traceBegin ( "parked" );
+    USUL_SCOPED_CALL ( [ this ] ()
+    {
+      this->_traceEnd ( "parked" );
+    } );
+
+    _parkCondition.wait ( lock, [ this, &pt ] ()
+    {
+      return (
+        ( false == _shouldRunPoolThreads ) ||
+        ( WAKE_BY_POLLING == this->getWakeModel() ) ||
+        ( pt.index < this->getMaxNumThreadsAllowed() ) );
+    } );
+    return;
+  }
+
+  // Jobs are pushed onto the deques and the ring without locking the mutex.
+  // The pusher increments the number of jobs and then looks for waiting
+  // threads, and this thread does the opposite, so one of them sees the other.
+  ++_numThreadsWaiting;
+  USUL_SCOPED_CALL ( [ this ] ()
+  {
+    --_numThreadsWaiting; // This variable is atomic.
+  } );
+
+  this->_traceBegin ( "idle" );
+  USUL_SCOPED_CALL ( [ this ] ()
+  {
+    this->_traceEnd ( "idle" );
+  } );
+
+  // Wait until there is a job in the queue or in a deque.
+  _wakeCondition.wait ( lock, [ this, &pt ] ()
+  {
+    return (
+      ( false == _shouldRunPoolThreads ) ||
+      ( WAKE_BY_POLLING == this->getWakeModel() ) ||
+      ( pt.index >= this->getMaxNumThreadsAllowed() ) ||
+      ( false == _queuedJobs.empty() ) ||
+      ( _numJobsSubmitted > 0 ) ||
+      ( _numJobsInDeques > 0 ) );
   } );
 }
-Manager::Names Manager::getQueuedJobNames() const
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Is the calling thread in the pool of any manager?
+//
+///////////////////////////////////////////////////////////////////////////////
+
+bool Manager::isPoolThread()
 {
-  Names names;
-  this->getQueuedJobNames ( names );
-  return names;
+  return ( ( nullptr != Details::currentManager ) && ( nullptr != Details::currentPoolThread ) );
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Run one queued job in the calling thread, if it's in a manager's pool.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+bool Manager::runQueuedJob ( const Job *wanted )
+{
+  if ( false == Manager::isPoolThread() )
+  {
+    return false;
+  }
+
+  return Details::currentManager->_runQueuedJob ( *Details::currentPoolThread, wanted );
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Run queued jobs until the function says that it's done.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+bool Manager::helpWhileWaiting ( IsDoneFunction isDone, WaitFunction wait, TimePoint end, const Job *wanted )
+{
+  while ( false == isDone() )
+  {
+    const TimePoint now = Clock::now();
+    if ( now >= end )
+    {
+      return false;
+    }
+
+    // When there is nothing to run, wait a little and look again, because
+    // the jobs this one is waiting for may add more.
+    if ( false == Manager::runQueuedJob ( wanted ) )
+    {
+      wait ( std::min < Clock::duration > ( end - now, std::chrono::milliseconds ( 1 ) ) );
+    }
+  }
+
+  return true;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Run one queued job in the calling thread, which is in the pool and is
+//  waiting inside the job it's running. The job it runs is the thread's
+//  running job until it's done, and then the waiting one is again.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+bool Manager::_runQueuedJob ( PoolThread &pt, const Job *wanted )
+{
+  // Do not lock mutex here!
+
+  // Too many jobs inside each other could use up the stack.
+  if ( ( false == _shouldRunPoolThreads ) || ( Details::helpDepth >= MAX_HELP_DEPTH ) )
+  {
+    return false;
+  }
+
+  // The job that's waiting is still running, so it goes on the thread's
+  // list of them before another job takes its place.
+  JobPtr waiting;
+  {
+    std::lock_guard < std::mutex > guard ( pt.mutex );
+    waiting = pt.job;
+    pt.waiting.push_back ( waiting );
+  }
+
+  // Get the wanted job, or else the next one. This also makes it one of
+  // the running jobs.
+  JobPtr job = ( ( nullptr == wanted ) ? JobPtr() : this->_getQueuedJob ( pt, *wanted ) );
+  if ( nullptr == job.get() )
+  {
+    job = this->_getNextQueuedJob ( pt );
+  }
+  if ( nullptr == job.get() )
+  {
+    std::lock_guard < std::mutex > guard ( pt.mutex );
+    pt.waiting.pop_back();
+    return false;
+  }
+
+  ++Details::helpDepth;
+  USUL_SCOPED_CALL ( ( [ this, &pt, &waiting ] ()
+  {
+    --Details::helpDepth;
+
+    // The job is no longer running, and the one that's waiting is again
+    // the thread's running job.
+    {
+      std::lock_guard < std::mutex > guard ( pt.mutex );
+      pt.job = waiting;
+      pt.waiting.pop_back();
+    }
+
+    if ( 0 == --_numJobsRunningInPool )
+    {
+      this->_notifyIfAllDone();
+    }
+  } ) );
+
+  this->_traceJob ( Trace::DEQUEUE, *job );
+
+  // There is room in the queue now.
+  this->_notifyIfRoom();
+
+  // Run the job in this thread if we should. Otherwise, it's done.
+  if ( ( true == Details::shouldRunJob ( job ) ) && ( true == job->_start() ) )
+  {
+    this->_runJob ( job );
+  }
+  else
+  {
+    this->_traceJob ( Trace::CANCEL, *job );
+    job->done();
+  }
+
+  return true;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Run the job in the calling thread.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void Manager::_runJob ( JobPtr job )
+{
+  // If an exception sneaks through it will bring down the house.
+  try
+  {
+    // This should never happen but check anyway.
+    if ( nullptr == job.get() )
+    {
+      throw std::runtime_error ( "Invalid job in thread" );
+    }
+
+    // Always set the job as done before we leave here.
+    // This only captures a reference so it does not allocate.
+    USUL_SCOPED_CALL ( [ &job ] () { job->done(); } );
+
+    // The job has times if it was added while recording.
+    const bool shouldRecord = ( ( true == _isRecordingJobTimes ) && ( TimePoint() != job->_addedTime ) );
+    const TimePoint started = ( ( true == shouldRecord ) ? Clock::now() : TimePoint() );
+
+    this->_traceJob ( Trace::START, *job );
+
+    try
+    {
+      // Get the callback function.
+      const Job::Callback &fun = job->getCallback();
+
+      // Make sure it is valid.
+      if ( fun )
+      {
+        // Call the function.
+        fun ( job );
+      }
+    }
+    JOB_MANAGER_CATCH_EXCEPTIONS ( 1591073635, job )
+
+    // Before the job is done, so that they're there for whoever waits on it.
+    if ( true == shouldRecord )
+    {
+      this->_recordJobTimes ( *job, started, Clock::now() );
+    }
+
+    this->_traceJob ( Trace::FINISH, *job );
+  }
+  JOB_MANAGER_CATCH_EXCEPTIONS ( 1591071534, job )
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Called when the internal thread starts.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void Manager::_threadStarted()
+{
+  // If an exception sneaks through it will bring down the house.
+  try
+  {
+    IS_WORKER_THREAD_OR_THROW;
+
+    // Do not lock mutex here!
+
+    Trace::setThreadName ( "worker" );
+
+    // Loop until told otherwise.
+    while ( true == this->_getShouldRunWorkerThread() )
+    {
+      // Note: A try-catch block in here will create an infinite loop if the
+      // worker thread throws an exception.
+
+      // Check the running jobs and remove any that are done.
+      this->_checkRunningJobs();
+
+      // Check the queue and maybe start a new job.
+      this->_checkQueuedJobs();
+
+      // Wait until there is something to do.
+      this->_threadWait();
+    }
+  }
+  JOB_MANAGER_CATCH_EXCEPTIONS ( 1591049996, JobPtr() )
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Called when the internal thread is between checking the jobs.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void Manager::_threadWait()
+{
+  IS_WORKER_THREAD_OR_THROW;
+
+  // Sleep some so that we don't spike the cpu.
+  if ( WAKE_BY_POLLING == this->getWakeModel() )
+  {
+    this->_traceBegin ( "sleep" );
+    std::this_thread::sleep_for ( std::chrono::milliseconds ( this->getNumMillisecondsToSleep() ) );
+    this->_traceEnd ( "sleep" );
+    return;
+  }
+
+  // The condition needs a lock, and it releases it while waiting.
+  std::unique_lock < Mutex > lock ( _mutex );
+
+  this->_traceBegin ( "idle" );
+  USUL_SCOPED_CALL ( [ this ] ()
+  {
+    this->_traceEnd ( "idle" );
+  } );
+
+  // Wait until we can start a job, or until a running job is done.
+  _wakeCondition.wait ( lock, [ this ] ()
+  {
+    if ( ( false == this->_getShouldRunWorkerThread() ) || ( WAKE_BY_POLLING == this->getWakeModel() ) )
+    {
+      return true;
+    }
+
+    if ( ( false == _queuedJobs.empty() ) && ( _runningJobs.size() < this->getMaxNumThreadsAllowed() ) )
+    {
+      return true;
+    }
+
+    return std::any_of ( _runningJobs.begin(), _runningJobs.end(), [] ( const RunningInfo &info )
+    {
+      return info.second->isDone();
+    } );
+  } );
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Return the next job in the queue or null if the queue is empty.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+Manager::JobPtr Manager::_getNextQueuedJob()
+{
+  IS_WORKER_THREAD_OR_THROW;
+  Guard guard ( _mutex );
+
+  // Should not happen but make sure.
+  USUL_CHECK_AND_THROW ( ( false == _hasJobInTransition ), "There is already a job in transition" );
+
+  // Handle an empty queue.
+  if ( true == _queuedJobs.empty() )
+  {
+    return JobPtr();
+  }
+
+  // We now have a job in transition. Set this first so that the job is
+  // always counted.
+  _hasJobInTransition = true;
+
+  // Pop the job with the highest priority.
+  JobPtr job = _queuedJobs.pop();
+
+  // Return the job.
+  return job;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Return the next job in the queue for the thread in the pool, or null if
+//  the queue is empty. The job becomes the one that the thread is running.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+Manager::JobPtr Manager::_getNextQueuedJob ( PoolThread &pt )
+{
+  // Do not lock the mutex unless we have to.
+
+  // Threads beyond the maximum allowed stay idle.
+  if ( pt.index >= this->getMaxNumThreadsAllowed() )
+  {
+    return JobPtr();
+  }
+
+  // First look in this thread's deque. The most recent job is popped so
+  // that the data it uses is likely still in the cache.
+  if ( _numJobsInDeques > 0 )
+  {
+    JobPtr job = this->_takeJob ( pt.deque.pop() );
+    if ( nullptr != job.get() )
+    {
+      return this->_startPoolJob ( pt, job );
+    }
+  }
+
+  // Next look in the shared queue, after moving the new jobs into it.
+  {
+    std::unique_lock < Mutex > guard ( _mutex, std::defer_lock );
+    this->_lockMutex ( guard );
+
+    this->_drainSubmissions();
+
+    if ( false == _queuedJobs.empty() )
+    {
+      // Pop the job with the highest priority and make it the running job
+      // for this thread. This happens while the mutex is locked so there is
+      // no transition. Increment first so that the job is always counted.
+      ++_numJobsRunningInPool;
+      JobPtr job = _queuedJobs.pop();
+      {
+        std::lock_guard < std::mutex > guard ( pt.mutex );
+        pt.job = job;
+      }
+
+      // Return the job.
+      return job;
+    }
+  }
+
+  // Last, steal the oldest job from another thread's deque. The oldest job
+  // is likely the biggest piece of a recursive job.
+  if ( _numJobsInDeques > 0 )
+  {
+    const PoolTable *table = _poolTable; // This is atomic.
+    if ( nullptr != table )
+    {
+      const std::size_t size = table->size();
+      for ( std::size_t i = 1; i < size; ++i )
+      {
+        PoolThread *victim = table->at ( ( pt.index + i ) % size );
+        JobPtr job = this->_takeJob ( victim->deque.steal() );
+        if ( nullptr != job.get() )
+        {
+          return this->_startPoolJob ( pt, job );
+        }
+      }
+    }
+  }
+
+  // There is nothing to do.
+  return JobPtr();
 }
 
 
 ///////////////////////////////////////////////////////////////////////////////
 //
-//  Get the number of jobs.
+//  Take the job out of the shared queue and make it the one that the thread
+//  in the pool is running. Returns null if it's not in the shared queue.
 //
 ///////////////////////////////////////////////////////////////////////////////
 
-unsigned int Manager::getNumJobs() const
+Manager::JobPtr Manager::_getQueuedJob ( PoolThread &pt, const Job &wanted )
 {
-  // The mutex is recursive so guard here to return a number that is
-  // accurate for the time this function was called.
-  Guard guard ( _mutex );
+  // Jobs in a lane are run by the lane's threads, and the jobs in the
+  // deques are already taken newest first.
+  if ( nullptr != this->_getLane ( wanted.getLane() ) )
+  {
+    return JobPtr();
+  }
 
-  // Return the number of queued jobs, jobs, and in transition.
-  // A job is in transition if it has been taken out of the queue
-  // but not yet put into the list of running jobs.
-  const unsigned int numQueued = this->getNumJobsQueued();
-  const unsigned int numRunning = this->getNumJobsRunning();
-  const unsigned int numInTransition = ( _hasJobInTransition ? 1 : 0 );
-  return ( numQueued + numRunning + numInTransition );
-}
-unsigned int Manager::getNumJobsRunning() const
-{
-  Guard guard ( _mutex );
-  return static_cast < unsigned int > ( _runningJobs.size() );
-}
-unsigned int Manager::getNumJobsQueued() const
-{
-  Guard guard ( _mutex );
-  return static_cast < unsigned int > ( _queuedJobs.size() );
+  std::unique_lock < Mutex > guard ( _mutex, std::defer_lock );
+  this->_lockMutex ( guard );
+
+  // The job may still be in the ring.
+  this->_drainSubmissions();
+
+  // Increment first so that the job is always counted. The thread is
+  // running the job that waits, so this never goes back to zero here.
+  ++_numJobsRunningInPool;
+  JobPtr job = _queuedJobs.remove ( wanted );
+  if ( nullptr == job.get() )
+  {
+    --_numJobsRunningInPool;
+    return JobPtr();
+  }
+
+  {
+    std::lock_guard < std::mutex > ptGuard ( pt.mutex );
+    pt.job = job;
+  }
+
+  return job;
 }
 
 
 ///////////////////////////////////////////////////////////////////////////////
 //
-//  Get/set the maximum number of threads allowed. If more threads are
-//  currently running than the new maximum, it does not stop them.
+//  Make the job from a deque the running job for the thread in the pool.
 //
 ///////////////////////////////////////////////////////////////////////////////
 
-unsigned int Manager::getMaxNumThreadsAllowed() const
-{
-  return _maxNumThreadsAllowed; // This is atomic.
-}
-void Manager::setMaxNumThreadsAllowed ( unsigned int num )
+Manager::JobPtr Manager::_startPoolJob ( PoolThread &pt, JobPtr job )
 {
-  IS_NOT_WORKER_THREAD_OR_THROW;
-  _maxNumThreadsAllowed = num; // This is atomic.
+  // Increment first so that the job is always counted.
+  ++_numJobsRunningInPool;
+  --_numJobsInDeques;
+
+  {
+    std::lock_guard < std::mutex > guard ( pt.mutex );
+    pt.job = job;
+  }
+
+  return job;
 }
 
 
 ///////////////////////////////////////////////////////////////////////////////
 //
-//  Get/set the number of milliseconds to sleep.
+//  Take the job out of the deque's reference to it.
 //
 ///////////////////////////////////////////////////////////////////////////////
 
-unsigned int Manager::getNumMillisecondsToSleep() const
-{
-  return _numMillisecondsToSleep; // This is atomic.
-}
-void Manager::setNumMillisecondsToSleep ( unsigned int num )
+Manager::JobPtr Manager::_takeJob ( Job *raw )
 {
-  IS_NOT_WORKER_THREAD_OR_THROW;
-  _numMillisecondsToSleep = num; // This is atomic.
+  JobPtr job;
+  if ( nullptr != raw )
+  {
+    job.swap ( raw->_keepAlive );
+    Manager::_clearSubmitted ( *raw );
+  }
+  return job;
 }
 
 
 ///////////////////////////////////////////////////////////////////////////////
 //
-//  Get/set the flag that says we should run the worker thread.
+//  Throw if the job is in a queue, the ring, or a deque.
 //
 ///////////////////////////////////////////////////////////////////////////////
 
-bool Manager::_getShouldRunWorkerThread() const
-{
-  return _shouldRunWorkerThread; // This is atomic.
-}
-void Manager::_setShouldRunWorkerThread ( bool state )
+void Manager::_canQueueJobOrThrow ( const Job &job )
 {
-  IS_NOT_WORKER_THREAD_OR_THROW;
-  _shouldRunWorkerThread = state; // This is atomic.
+  if ( ( nullptr != job._queue.load() ) || ( 0 != ( job._state.load ( std::memory_order_acquire ) & Job::STATE_SUBMITTED ) ) )
+  {
+    throw std::runtime_error ( "Job is already in a queue" );
+  }
 }
 
 
 ///////////////////////////////////////////////////////////////////////////////
 //
-//  Wait for all jobs to complete.
+//  Mark the job as being in the ring or a deque. A job there is not in the
+//  queue yet, so this is how adding it twice is caught, the same as adding
+//  a job that's in the queue.
 //
 ///////////////////////////////////////////////////////////////////////////////
 
-void Manager::waitAll()
+void Manager::_setSubmitted ( Job &job )
 {
-  IS_NOT_WORKER_THREAD_OR_THROW;
-
-  // We could guard this function so that no new jobs are queued and start
-  // running while we are in here. On the other hand, we could make the mutex
-  // available and let the user decide if that is desired.
-
-  // Shortcut
-  const unsigned int numMillisecondsToSleep = this->getNumMillisecondsToSleep();
+  if ( nullptr != job._queue.load() )
+  {
+    throw std::runtime_error ( "Job is already in a queue" );
+  }
 
-  // Loop until there are no queued or running jobs.
-  while ( this->getNumJobs() > 0 )
+  const unsigned int state = job._state.fetch_or ( Job::STATE_SUBMITTED, std::memory_order_acq_rel );
+  if ( 0 != ( state & Job::STATE_SUBMITTED ) )
   {
-    // Sleep some so that we don't spike the cpu.
-    std::this_thread::sleep_for ( std::chrono::milliseconds ( numMillisecondsToSleep ) );
+    throw std::runtime_error ( "Job is already in a queue" );
   }
 }
+void Manager::_clearSubmitted ( Job &job )
+{
+  job._state.fetch_and ( ~static_cast < unsigned int > ( Job::STATE_SUBMITTED ), std::memory_order_release );
+}
 
 
 ///////////////////////////////////////////////////////////////////////////////
 //
-//  Functions for checking threads.
+//  Push the job onto the deque of the calling thread if it's one of our
+//  threads in the pool and we're using the work-stealing scheduler.
+//  Returns false if the job should go in the shared queue instead.
 //
 ///////////////////////////////////////////////////////////////////////////////
 
-bool Manager::_isWorkerThread() const
+bool Manager::_addLocalJob ( JobPtr job )
 {
-  return ( std::this_thread::get_id() == _workerID );
+  // Do not lock the mutex here!
+
+  if ( false == this->_canAddLocalJobs() )
+  {
+    return false;
+  }
+
+  // Catch adding it twice now, because the deque can not.
+  Manager::_setSubmitted ( *job );
+
+  // Count it before it's in the deque so that it's never missed.
+  ++_numJobsInDeques;
+
+  // The deque holds a raw pointer so the job keeps itself alive.
+  job->_keepAlive = job;
+  Details::currentPoolThread->deque.push ( job.get() );
+
+  // Only wake a thread if one is waiting. See _poolThreadWait().
+  if ( _numThreadsWaiting > 0 )
+  {
+    this->_wakeThreads ( false );
+  }
+
+  return true;
 }
-void Manager::_isWorkerThreadOrThrow() const
+bool Manager::_addLocalJobs ( const Jobs &jobs )
 {
-  if ( false == this->_isWorkerThread() )
+  // Do not lock the mutex here!
+
+  if ( false == this->_canAddLocalJobs() )
   {
-    throw std::runtime_error ( "The current thread should be the worker thread" );
+    return false;
+  }
+
+  // Catch adding one twice now, because the deque can not. If one throws
+  // then none of them are added.
+  for ( auto i = jobs.begin(); i != jobs.end(); ++i )
+  {
+    try
+    {
+      Manager::_setSubmitted ( **i );
+    }
+    catch ( ... )
+    {
+      std::for_each ( jobs.begin(), i, [] ( const JobPtr &job ) { Manager::_clearSubmitted ( *job ); } );
+      throw;
+    }
+  }
+
+  // Count them before they are in the deque so that they are never missed.
+  _numJobsInDeques += static_cast < unsigned int > ( jobs.size() );
+
+  // The deque holds raw pointers so the jobs keep themselves alive.
+  PoolThread &pt = *Details::currentPoolThread;
+  for ( auto i = jobs.begin(); i != jobs.end(); ++i )
+  {
+    const JobPtr &job = *i;
+    job->_keepAlive = job;
+    pt.deque.push ( job.get() );
   }
+
+  // Only wake the threads if one is waiting. See _poolThreadWait().
+  if ( _numThreadsWaiting > 0 )
+  {
+    this->_wakeThreads ( jobs.size() > 1 );
+  }
+
+  return true;
 }
-void Manager::_isNotWorkerThreadOrThrow() const
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Can the calling thread push jobs onto its own deque?
+//
+///////////////////////////////////////////////////////////////////////////////
+
+bool Manager::_canAddLocalJobs() const
 {
-  if ( true == this->_isWorkerThread() )
+  if ( SCHEDULER_WORK_STEALING != this->getScheduler() )
   {
-    throw std::runtime_error ( "The current thread should not be the worker thread" );
+    return false;
   }
+
+  return this->_isPoolThread();
 }
 
 
 ///////////////////////////////////////////////////////////////////////////////
 //
-//  Start the worker thread.
+//  Take the jobs out of the deques. They will never run so they are done.
 //
 ///////////////////////////////////////////////////////////////////////////////
 
-void Manager::_startWorkerThread()
+void Manager::_clearDeques()
 {
-  IS_NOT_WORKER_THREAD_OR_THROW;
-
-  // One thread at a time.
-  Guard guard ( _mutex );
+  // Copy the threads so that they stay around while we're using them.
+  PoolThreads threads;
+  {
+    Guard guard ( _mutex );
+    threads = _poolThreads;
+  }
 
-  // Do not start the worker thread if it's already running.
-  if ( nullptr == _workerThread.get() )
+  // Steal every job. Another thread may be taking them too.
+  std::for_each ( threads.begin(), threads.end(), [ this ] ( PoolThreadPtr pt )
   {
-    // Make the new thread. Need a lambda here that assigns _workerID before
-    // calling the thread's function. Otherwise, it could start executing the
-    // thread before it assigns _workerID below, and then _isWorkerThreadOrThrow()
-    // will throw an exception when it should not.
-    _workerThread = ThreadPtr ( new std::thread ( [ this ] ()
+    while ( false == pt->deque.empty() )
     {
-      // If an exception sneaks through it will bring down the house.
-      try
+      JobPtr job = this->_takeJob ( pt->deque.steal() );
+      if ( nullptr != job.get() )
       {
-        // Assign the thread-id of this worker-thread. It is an atomic
-        // std::thread::id so no need to lock the mutex to access it.
-        // This helps avoid deadlock.
-        _workerID = std::this_thread::get_id();
-
-        // TODO: At one point, without this _isWorkerThreadOrThrow() would
-        // throw an exception. Is this still needed?
-        // std::this_thread::sleep_for ( std::chrono::milliseconds ( this->getNumMillisecondsToSleep() ) );
-
-        // Now run this new thread.
-        this->_threadStarted();
+        --_numJobsInDeques;
+        job->done();
       }
-      JOB_MANAGER_CATCH_EXCEPTIONS ( 1591247240, JobPtr() )
-    } ) );
-  }
+    }
+  } );
 }
 
 
 ///////////////////////////////////////////////////////////////////////////////
 //
-//  Stop the worker thread.
+//  Push the job onto the ring if the pool will run it. The threads in the
+//  pool move it to the queue. Returns false if the ring is full or if the
+//  job should go in the queue now.
 //
 ///////////////////////////////////////////////////////////////////////////////
 
-void Manager::_stopWorkerThread()
+bool Manager::_submitJob ( JobPtr job )
 {
-  IS_NOT_WORKER_THREAD_OR_THROW;
+  // Do not lock the mutex here!
 
-  // The worker thread should break out of its loop.
-  this->_setShouldRunWorkerThread ( false );
-
-  // Make a copy of the worker thread pointer then make it null.
-  ThreadPtr worker = nullptr;
+  // The thread for each job only looks in the queue.
+  if ( THREAD_POOL != this->getThreadModel() )
   {
-    Guard guard ( _mutex );
-    worker = _workerThread;
-    _workerThread = nullptr;
+    return false;
   }
 
-  // We're done with our worker thread.
-  if ( nullptr != worker.get() )
+  // Catch this now rather than when the job is moved to the queue.
+  Manager::_setSubmitted ( *job );
+
+  // Count it before it's in the ring so that it's never missed.
+  ++_numJobsSubmitted;
+
+  // The ring holds a raw pointer so the job keeps itself alive.
+  job->_keepAlive = job;
+  if ( false == _submissions.push ( job.get() ) )
   {
-    // Wait for it to finish.
-    worker->join();
+    job->_keepAlive = nullptr;
+    Manager::_clearSubmitted ( *job );
+    --_numJobsSubmitted;
+    return false;
+  }
 
-    // Now we can do this, but not before.
-    _workerID = std::thread::id();
+  // Make sure there is a thread to run the job.
+  this->_startThreads();
 
-    // This should be the last reference so it will get deleted.
-    worker = nullptr;
+  // Only wake a thread if one is waiting. See _poolThreadWait().
+  if ( _numThreadsWaiting > 0 )
+  {
+    this->_wakeThreads ( false );
   }
+
+  return true;
 }
 
 
 ///////////////////////////////////////////////////////////////////////////////
 //
-//  Called when the internal thread starts.
+//  Move the jobs from the ring to the queue. Call with the mutex locked.
 //
 ///////////////////////////////////////////////////////////////////////////////
 
-void Manager::_threadStarted()
+void Manager::_drainSubmissions()
 {
-  // If an exception sneaks through it will bring down the house.
-  try
+  // Handle nothing to move.
+  if ( 0 == _numJobsSubmitted )
   {
-    IS_WORKER_THREAD_OR_THROW;
-
-    // Do not lock mutex here!
+    return;
+  }
 
-    // Loop until told otherwise.
-    while ( true == this->_getShouldRunWorkerThread() )
+  while ( Job *raw = _submissions.pop() )
+  {
+    // Decrement after it's in the queue so that it's always counted.
+    USUL_SCOPED_CALL ( [ this ] ()
     {
-      // Note: A try-catch block in here will create an infinite loop if the
-      // worker thread throws an exception.
-
-      // Check the running jobs and remove any that are done.
-      this->_checkRunningJobs();
+      --_numJobsSubmitted; // This variable is atomic.
+    } );
 
-      // Check the queue and maybe start a new job.
-      this->_checkQueuedJobs();
+    // Should not happen, because adding a job twice throws, but check.
+    JobPtr job = this->_takeJob ( raw );
+    if ( nullptr == job.get() )
+    {
+      continue;
+    }
 
-      // Sleep some so that we don't spike the cpu.
-      std::this_thread::sleep_for ( std::chrono::milliseconds ( this->getNumMillisecondsToSleep() ) );
+    // This only throws if the job was added twice by different paths.
+    try
+    {
+      _queuedJobs.push ( job );
     }
+    JOB_MANAGER_CATCH_EXCEPTIONS ( 1700502214, job )
   }
-  JOB_MANAGER_CATCH_EXCEPTIONS ( 1591049996, JobPtr() )
 }
 
 
 ///////////////////////////////////////////////////////////////////////////////
 //
-//  Return the next job in the queue or null if the queue is empty.
+//  Take the jobs out of the ring. They will never run so they are done.
 //
 ///////////////////////////////////////////////////////////////////////////////
 
-Manager::JobPtr Manager::_getNextQueuedJob()
+void Manager::_clearSubmissions()
 {
-  IS_WORKER_THREAD_OR_THROW;
-  Guard guard ( _mutex );
-
-  // Should not happen but make sure.
-  USUL_CHECK_AND_THROW ( ( false == _hasJobInTransition ), "There is already a job in transition" );
-
-  // Handle an empty queue.
-  if ( true == _queuedJobs.empty() )
+  while ( Job *raw = _submissions.pop() )
   {
-    return JobPtr();
+    JobPtr job = this->_takeJob ( raw );
+    --_numJobsSubmitted;
+    if ( nullptr != job.get() )
+    {
+      job->done();
+    }
   }
-
-  // Get the last job. It should have the highest priority.
-  JobPtr job = _queuedJobs.back();
-
-  // We now have a job in transition.
-  _hasJobInTransition = true;
-
-  // Pop the job from the queue.
-  _queuedJobs.pop_back();
-
-  // Return the job.
-  return job;
 }
 
 
@@ -774,68 +4000,43 @@ void Manager::_checkQueuedJobs()
   USUL_SCOPED_CALL ( [ this ] ()
   {
     _hasJobInTransition = false; // This variable is atomic.
+    this->_notifyIfAllDone();
   } );
 
-  // This means the queue is empty.
-  if ( nullptr == job.get() )
-  {
-    return;
-  }
-
-  // If the job does not have a callback function then skip it.
-  if ( !job->getCallback() )
-  {
-    return;
-  }
-
-  // If the job has been cancelled then skip it.
-  if ( true == job->isCancelled() )
+  // There is room in the queue if we got a job.
+  if ( nullptr != job.get() )
   {
-    return;
+    this->_traceJob ( Trace::DEQUEUE, *job );
+    this->_notifyIfRoom();
   }
 
-  // If for some reason the job is done then skip it.
-  if ( true == job->isDone() )
+  // Skip the job if we should, or if the queue is empty.
+  if ( ( false == Details::shouldRunJob ( job ) ) || ( false == job->_start() ) )
   {
+    if ( nullptr != job.get() )
+    {
+      this->_traceJob ( Trace::CANCEL, *job );
+      job->done();
+    }
     return;
   }
 
   // Start a new thread and have it run the job.
   ThreadPtr thread ( new std::thread ( [ job, this ] ()
   {
-    // If an exception sneaks through it will bring down the house.
-    try
-    {
-      // This should never happen but check anyway.
-      if ( nullptr == job.get() )
-      {
-        throw std::runtime_error ( "Invalid job in thread" );
-      }
+    Trace::setThreadName ( "job" );
 
-      // Always set the job as done before we leave here.
-      USUL_SCOPED_CALL ( std::bind ( &Job::done, job ) );
-
-      try
-      {
-        // Get the callback function.
-        Job::Callback fun = job->getCallback();
+    this->_runJob ( job );
 
-        // Make sure it is valid.
-        if ( fun )
-        {
-          // Call the function.
-          fun ( job );
-        }
-      }
-      JOB_MANAGER_CATCH_EXCEPTIONS ( 1591073635, job )
-    }
-    JOB_MANAGER_CATCH_EXCEPTIONS ( 1591071534, job )
+    // Let the worker thread know that this job is done.
+    this->_wakeThreads ( false );
   } ) );
 
   // Add the job to the container of running jobs.
   {
     Guard guard ( _mutex );
     _runningJobs.insert ( RunningInfo ( thread, job ) );
+    _numJobsRunningInThreads = static_cast < unsigned int > ( _runningJobs.size() );
   }
 }
 
@@ -874,6 +4075,7 @@ void Manager::_checkRunningJobs()
       // Remove this item from the container of running jobs.
       _runningJobs.erase ( *i );
     }
+    _numJobsRunningInThreads = static_cast < unsigned int > ( _runningJobs.size() );
   }
 
   // Loop through the set we are supposed to remove.
@@ -882,6 +4084,12 @@ void Manager::_checkRunningJobs()
     // Wait for the thread. Since the job is done this should return immediately.
     i->first->join();
   }
+
+  // That may have been the last one.
+  if ( false == removeMe.empty() )
+  {
+    this->_notifyIfAllDone();
+  }
 }
 
 
@@ -18,15 +18,28 @@
 
 #include "Usul/Export.h"
 #include "Usul/Config.h" // Ignore the 4251 warning.
+#include "Usul/Define.h"
+#include "Usul/Jobs/Deque.h"
+#include "Usul/Jobs/Histogram.h"
 #include "Usul/Jobs/Job.h"
+#include "Usul/Jobs/Queue.h"
+#include "Usul/Jobs/Ring.h"
+#include "Usul/Jobs/TimerWheel.h"
+#include "Usul/Jobs/Trace.h"
 #include "Usul/Tools/NoCopying.h"
 
 #include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
 #include <functional>
+#include <iosfwd>
+#include <map>
 #include <mutex>
 #include <set>
 #include <string>
 #include <thread>
+#include <type_traits>
 #include <vector>
 
 
@@ -34,6 +47,10 @@ namespace Usul {
 namespace Jobs {
 
 
+template < class R > class Future;
+class ScheduleAwaiter;
+
+
 class USUL_EXPORT Manager : public Usul::Tools::NoCopying
 {
 public:
@@ -42,7 +59,10 @@ public:
   typedef std::lock_guard < Mutex > Guard;
   typedef Job::Callback Callback;
   typedef Job::Ptr JobPtr;
-  typedef std::vector < JobPtr > QueuedJobs;
+  typedef Queue QueuedJobs;
+  typedef Queue::Policy QueuePolicy;
+  typedef std::vector < JobPtr > Jobs;
+  typedef std::vector < Callback > Callbacks;
   typedef std::shared_ptr < std::thread > ThreadPtr;
   typedef std::pair < ThreadPtr, JobPtr > RunningInfo;
   typedef std::set < RunningInfo > RunningJobs;
@@ -51,19 +71,199 @@ public:
   typedef std::atomic < unsigned int > AtomicUnsignedInt;
   typedef std::atomic < bool > AtomicBool;
   typedef std::atomic < std::thread::id > AtomicThreadID;
+  typedef Ring < Job > Submissions;
+  typedef std::chrono::steady_clock Clock;
+  typedef Clock::time_point TimePoint;
+  typedef unsigned int Lane;
+
+  // The lane that uses the thread pool, how many lanes there can be, how
+  // many job names have their own times, and how many jobs a waiting thread
+  // in the pool runs inside each other.
+  enum
+  {
+    DEFAULT_LANE = 0,
+    MAX_NUM_LANES = 16,
+    MAX_NUM_JOB_NAMES = 1024,
+    MAX_HELP_DEPTH = 64
+  };
+
+  // How the jobs get a thread to run on.
+  enum ThreadModel
+  {
+    THREAD_PER_JOB = 0, // Start a new thread for every job.
+    THREAD_POOL = 1     // Long-lived threads take the jobs from the queue.
+  };
+  typedef std::atomic < ThreadModel > AtomicThreadModel;
+
+  // How the idle threads find out that there is something to do.
+  enum WakeModel
+  {
+    WAKE_ON_EVENTS = 0, // Sleep until a job is added, finishes, etc.
+    WAKE_BY_POLLING = 1 // Sleep for the number of milliseconds and then look.
+  };
+  typedef std::atomic < WakeModel > AtomicWakeModel;
+  typedef std::condition_variable_any Condition;
+
+  // How the threads in the pool find their jobs.
+  enum Scheduler
+  {
+    SCHEDULER_SHARED_QUEUE = 0, // All threads take jobs from the one queue.
+    SCHEDULER_WORK_STEALING = 1 // Jobs added by a job go to its thread's deque.
+  };
+  typedef std::atomic < Scheduler > AtomicScheduler;
+
+  // Where the threads in the pool run.
+  enum Affinity
+  {
+    AFFINITY_NONE = 0,      // Anywhere the process can run.
+    AFFINITY_PROCESSOR = 1, // Each thread on its own processor.
+    AFFINITY_NODE = 2       // Each thread on the processors of a NUMA node.
+  };
+  typedef std::atomic < Affinity > AtomicAffinity;
+  typedef std::vector < unsigned int > ProcessorIndices;
+
+  // A thread in the pool. The mutex guards the job that it's running, and
+  // the jobs that are waiting inside each other while it runs that one.
+  struct PoolThread : public Usul::Tools::NoCopying
+  {
+    explicit PoolThread ( unsigned int i ) : index ( i ), mutex(), job(), waiting(), deque(), thread() {}
+    const unsigned int index;
+    std::mutex mutex;
+    JobPtr job;
+    std::vector < JobPtr > waiting;
+    Deque < Job > deque;
+    ThreadPtr thread;
+  };
+  typedef std::shared_ptr < PoolThread > PoolThreadPtr;
+  typedef std::vector < PoolThreadPtr > PoolThreads;
+  typedef std::vector < PoolThread * > PoolTable;
+  typedef std::unique_ptr < PoolTable > PoolTablePtr;
+  typedef std::vector < PoolTablePtr > PoolTables;
+  typedef std::atomic < const PoolTable * > AtomicPoolTable;
+
+  // A lane with its own queue and threads. The mutex guards all of it.
+  struct LaneInfo : public Usul::Tools::NoCopying
+  {
+    LaneInfo ( const std::string &n, unsigned int m, const ProcessorIndices &p ) : name ( n ), processors ( p ), maxNumThreads ( m ), mutex(), queue ( mutex ), condition(), parkCondition(), threads(), running(), shouldRun ( true ) {}
+    const std::string name;
+    const ProcessorIndices processors; // Where the threads run. Anywhere if empty.
+    AtomicUnsignedInt maxNumThreads;
+    Mutex mutex;
+    QueuedJobs queue;
+    Condition condition;     // Threads that can run a job wait on this one.
+    Condition parkCondition; // Threads beyond the maximum wait on this one.
+    std::vector < ThreadPtr > threads;
+    Jobs running; // The job that each thread is running, if any.
+    AtomicBool shouldRun;
+  };
+  typedef std::unique_ptr < LaneInfo > LanePtr;
+
+  // The times of jobs in microseconds: how long they waited in the queue,
+  // how long they ran, and how long from when they were added until they
+  // were done. The last includes waiting for other jobs and timers.
+  struct JobTimes
+  {
+    Histogram queued;
+    Histogram running;
+    Histogram total;
+  };
+  typedef std::map < std::string, JobTimes > JobTimesByName;
 
   // Constructor and destructor. Use as a singleton or as individual objects.
   Manager();
   ~Manager();
 
-  // Add a job to the queue.
+  // Add a job to the queue. When the work-stealing scheduler is used, a job
+  // added by a job running in the pool goes to that thread's deque instead.
+  // If the queue is full then it waits for room. See setMaxNumJobsQueued().
   void   addJob ( JobPtr );
   JobPtr addJob ( Callback );
 
+  // Add the job if there is room in the queue. The timed version waits for
+  // room up to the given number of milliseconds. Returns false if the job
+  // was not added.
+  bool tryAddJob ( JobPtr );
+  bool tryAddJobFor ( JobPtr, unsigned int milliseconds );
+
+  // Add the jobs to the queue all at once. This locks the mutex once and
+  // wakes the threads once, so it's faster than adding them one at a time.
+  // If one of the jobs is null or already in a queue then none of them are
+  // added. If the queue does not have room for all of them then it waits.
+  void addJobs ( const Jobs & );
+  Jobs addJobs ( const Callbacks & );
+
+  // Add the job to the queue when all of the given jobs are done. Until then
+  // it's counted as a waiting job. A predecessor that is cleared or
+  // cancelled is still done, so the job runs anyway.
+  void   addJob ( JobPtr, const Jobs &predecessors );
+  JobPtr addJob ( Callback, const Jobs &predecessors );
+
+  // Add the job to the queue at the given time, or after the given number
+  // of milliseconds. Until then it's counted as a waiting job, but no thread
+  // from the pool waits for it. One timer thread handles all the timed jobs.
+  void   addJobAt ( JobPtr, TimePoint );
+  JobPtr addJobAt ( Callback, TimePoint );
+  void   addJobAfter ( JobPtr, unsigned int milliseconds );
+  JobPtr addJobAfter ( Callback, unsigned int milliseconds );
+
+  // Add a new job to the queue every given number of milliseconds, starting
+  // one interval from now. Each new job has the given job's name, priority,
+  // and callback. If the last one is not done yet then that time is skipped.
+  // The given job is never queued. Cancel it to stop, and then it's done.
+  // It's not counted as a job, so waitAll() does not wait for it.
+  void   addPeriodicJob ( JobPtr, unsigned int milliseconds );
+  JobPtr addPeriodicJob ( Callback, unsigned int milliseconds );
+
+  // Add a job that calls the function and return its future value. The
+  // value, or the exception thrown, is stored in the job. See Future.h.
+  template < class F >
+  auto submit ( F &&fun ) -> Future < typename std::decay < decltype ( fun() ) >::type >;
+
+  #ifdef USUL_HAS_COROUTINES
+
+  // Return an awaitable that moves the coroutine to a thread in the pool.
+  // Use it like this: co_await manager.schedule(); See Coroutine.h.
+  ScheduleAwaiter schedule();
+
+  #endif
+
+  // Add a lane with its own queue and threads, and return it. Jobs in one
+  // lane never wait for the threads of another, so a lane for jobs that
+  // block, like reading files, lets the jobs that compute keep every core.
+  // The default lane is the pool, with getMaxNumThreadsAllowed() threads.
+  // Set the lane of a job with Job::setLane() before adding it. Lanes can
+  // not be removed. Throws if the name is taken or there are too many.
+  Lane addLane ( const std::string &name, unsigned int maxNumThreads );
+
+  // Add a job to the given lane.
+  JobPtr addJob ( Lane, Callback );
+
+  // Return the lane whose threads only run on the given NUMA node, adding
+  // it the first time. Jobs in it run near the memory they touch, like a
+  // buffer that was read by an earlier job in the same lane. Its threads
+  // are in addition to the pool's, so it only gets the pool's share of the
+  // node: as many threads as AFFINITY_NODE puts there, at least one. This
+  // uses the pool's maximum when the lane is added. Change it later with
+  // setMaxNumThreadsAllowed. Throws if there is no such node.
+  Lane getNodeLane ( unsigned int node );
+
+  // Return the lane with the name. Throws if there is none.
+  Lane getLane ( const std::string &name ) const;
+
+  // Get the name of the lane, and the number of lanes.
+  std::string  getLaneName ( Lane ) const;
+  unsigned int getNumLanes() const;
+
+  // Get/set the maximum number of threads in the lane.
+  unsigned int getMaxNumThreadsAllowed ( Lane ) const;
+  void         setMaxNumThreadsAllowed ( Lane, unsigned int );
+
   // Cancel all the running jobs. This is a hint; the jobs can ignore it.
   void cancelRunningJobs();
 
-  // Clear any jobs that are in the queue.
+  // Clear any jobs that are in the queue, and the timed jobs that are not
+  // queued yet. They are marked as done so that anything waiting on them
+  // returns. This also stops the periodic jobs.
   void clearQueuedJobs();
 
   // Get/set the error handler.
@@ -74,27 +274,114 @@ public:
   Names getRunningJobNames() const;
   void  getRunningJobNames ( Names & ) const;
 
-  // Get the names of the queued jobs.
+  // Get/set if the manager records the times of the jobs that run. It's off
+  // by default. Recording does not lock anything, but it does get the time
+  // three times for each job.
+  bool isRecordingJobTimes() const;
+  void setRecordingJobTimes ( bool );
+
+  // Get the times of all the jobs that ran while recording, and of the jobs
+  // with each name. There is room for MAX_NUM_JOB_NAMES names, and jobs
+  // with other names are only in the times of all the jobs.
+  JobTimes       getJobTimes() const;
+  JobTimesByName getJobTimesByName() const;
+  void           getJobTimesByName ( JobTimesByName & ) const;
+  void           clearJobTimes();
+
+  // Get/set if the manager traces what its threads do: when each job is
+  // queued, taken, started, finished, and cancelled, when threads wait and
+  // why, and how long they wait for the manager's mutex. It's off by
+  // default. Each thread keeps its last Trace::DEFAULT_CAPACITY events.
+  bool isTracing() const;
+  void setTracing ( bool );
+
+  // Write the trace as Chrome trace-event JSON, which Perfetto can open,
+  // or remove the events from it.
+  void writeTrace ( std::ostream & ) const;
+  void clearTrace();
+
+  // Get the names of the queued jobs. This does not include the jobs in
+  // the deques of the work-stealing scheduler.
   Names getQueuedJobNames() const;
   void  getQueuedJobNames ( Names & ) const;
 
   // Get the singleton.
   static Manager &instance();
 
-  // Get the number of jobs.
+  // Is the calling thread in the pool of any manager?
+  static bool isPoolThread();
+
+  // Get the number of jobs. This includes the jobs that are waiting for
+  // another job to be done before they are queued. These read counters
+  // without locking the mutex, so they can be polled often. A job that is
+  // moving from queued to running may be counted twice but it's never
+  // missed, so the total is zero only when there are no jobs.
   unsigned int getNumJobs() const;
   unsigned int getNumJobsRunning() const;
   unsigned int getNumJobsQueued() const;
 
+  // Get/set the maximum number of queued jobs. When the queue is full,
+  // addJob() and addJobs() wait for room and tryAddJob() returns false.
+  // Jobs added by jobs running in the pool never wait, so they can go over
+  // the maximum. Only the default lane has a maximum. Making it smaller
+  // does not remove any jobs. The default is the unsigned int max, which
+  // means no limit.
+  unsigned int getMaxNumJobsQueued() const;
+  void         setMaxNumJobsQueued ( unsigned int );
+
   // Get/set the maximum number of threads allowed. If more threads are
-  // currently running than the new maximum, it does not stop them.
+  // currently running than the new maximum, it does not stop them. The
+  // default is the number of processors this process can use, less two.
   unsigned int getMaxNumThreadsAllowed() const;
   void         setMaxNumThreadsAllowed ( unsigned int );
 
-  // Get/set the number of milliseconds to sleep.
+  // Change the maximum number of threads in the pool every given number of
+  // milliseconds, keeping it between the bounds. It grows when jobs are
+  // queued, more so when the jobs spend their time blocked rather than
+  // computing, and shrinks when they are not. It's limited by the number
+  // of processors, including a container's CPU quota. Calling it again
+  // changes the bounds. While it's adapting, setMaxNumThreadsAllowed() only
+  // holds until the next change. Throws if the bounds are not valid.
+  void adaptNumThreads ( unsigned int minNumThreads, unsigned int maxNumThreads, unsigned int milliseconds = 100 );
+  void stopAdaptingNumThreads();
+  bool isAdaptingNumThreads() const;
+
+  // Get/set the number of milliseconds to sleep when polling.
   unsigned int getNumMillisecondsToSleep() const;
   void         setNumMillisecondsToSleep ( unsigned int );
 
+  // Get/set the thread model. The default is the thread pool.
+  // The model can only be changed when there are no jobs.
+  ThreadModel getThreadModel() const;
+  void        setThreadModel ( ThreadModel );
+
+  // Get/set the wake model. The default is to wake on events.
+  WakeModel getWakeModel() const;
+  void      setWakeModel ( WakeModel );
+
+  // Get/set where the threads in the pool run. The default is anywhere.
+  // Threads that are running a job change when they finish it. With
+  // AFFINITY_NODE, a node's pool threads share its processors with the
+  // threads of its lane, if any. See getNodeLane.
+  Affinity getAffinity() const;
+  void     setAffinity ( Affinity );
+
+  // Get/set the scheduler used by the thread pool. The default is the
+  // shared queue. The scheduler can only be changed when there are no jobs.
+  Scheduler getScheduler() const;
+  void      setScheduler ( Scheduler );
+
+  // Get/set the order that the queued jobs run in, for the shared queue and
+  // the queues of the lanes. The default is the priority. See Queue::Policy.
+  // The jobs in the deques of the work-stealing scheduler keep their order.
+  QueuePolicy getQueuePolicy() const;
+  void        setQueuePolicy ( QueuePolicy );
+
+  // Get/set how much a queued job's priority grows for every second that it
+  // waits, when the policy is aging. The default is one.
+  double getAgingRate() const;
+  void   setAgingRate ( double );
+
   // Is the job manager being destroyed or reset?
   bool isBeingDestroyed() const { return _isBeingDestroyed; }
   bool isBeingReset() const { return _isBeingReset; }
@@ -102,7 +389,10 @@ public:
   // Direct access to the mutex. Use with caution.
   Mutex &mutex() { return _mutex; }
 
-  // Remove the queued job. Has no effect on running jobs.
+  // Remove the queued job. Has no effect on running jobs, or on the jobs
+  // in the deques of the work-stealing scheduler. The removed job will
+  // never run, so it's done, the same as a cleared job: waiting for it
+  // returns, and adding it again does not run it.
   bool removeQueuedJob ( JobPtr );
 
   // Reset the manager to the initial state. This will clear the queue,
@@ -110,32 +400,145 @@ public:
   // before this function returns then an exception is thrown.
   void reset();
 
-  // Sort the queue. Call this if you change a job's priority after adding it.
-  // This function has no effect on a running job.
+  // Sort the queue. There is no need to call this when a job's priority
+  // changes because the job moves itself. This function has no effect on a
+  // running job.
   void sortQueuedJobs();
 
-  // Wait for all jobs to complete.
+  // Wait for all jobs to complete. Returns when the last one is done.
   void waitAll();
 
+  // When the calling thread is in a manager's pool, run one of that
+  // manager's queued jobs in it and return true. Returns false if there is
+  // nothing to run, or if the thread is not in a pool. Waiting for a job,
+  // group, or future calls this, so that a job that waits for the jobs it
+  // added runs them instead of blocking its thread. A job that is run this
+  // way must not need a lock that the waiting job holds. If the given job
+  // is still in the shared queue then it's the one that runs, so waiting
+  // for jobs in the order they were added goes down the tree first.
+  static bool runQueuedJob ( const Job *wanted = nullptr );
+
+  // Run queued jobs until the function says that it's done, or until the
+  // time is up, and return its last answer. When there is nothing to run it
+  // waits with the other function, for at most a millisecond at a time. For
+  // waiting in a pool thread; see above.
+  typedef std::function < bool () > IsDoneFunction;
+  typedef std::function < void ( Clock::duration ) > WaitFunction;
+  static bool helpWhileWaiting ( IsDoneFunction, WaitFunction, TimePoint end = TimePoint::max(), const Job *wanted = nullptr );
+
 protected:
 
+  // A timed job. The period is zero if it's only queued once. A timer with
+  // a function calls it on the timer thread instead, and the function
+  // returns false to stop.
+  struct Timer
+  {
+    JobPtr job;
+    JobPtr last; // The last job queued for a periodic one.
+    unsigned int period;
+    std::function < bool() > fun;
+  };
+  typedef TimerWheel < Timer > Timers;
+  typedef Timers::Tick Tick;
+
+  // The times of the jobs with a name. Once it's made it's there until the
+  // manager is gone, so it can be used without a lock.
+  struct JobTimesRecord : public Usul::Tools::NoCopying
+  {
+    explicit JobTimesRecord ( const std::string &n ) : name ( n ), queued(), running(), total() {}
+    const std::string name;
+    AtomicHistogram queued;
+    AtomicHistogram running;
+    AtomicHistogram total;
+  };
+  typedef std::atomic < JobTimesRecord * > AtomicJobTimesRecord;
+
+  bool _addJob ( JobPtr, bool waitForever, unsigned int milliseconds );
+  void _addPoolJobs ( const Jobs & );
+  void _addWaitingJob ( JobPtr );
+  void _predecessorDone ( JobPtr );
+
   void _checkQueuedJobs();
   void _checkRunningJobs();
   void _checkThreads();
 
   JobPtr _getNextQueuedJob();
+  JobPtr _getNextQueuedJob ( PoolThread & );
+  JobPtr _getQueuedJob ( PoolThread &, const Job & );
+
+  bool _addLocalJob ( JobPtr );
+  bool _addLocalJobs ( const Jobs & );
+  bool _canAddLocalJobs() const;
+  void _canAddJobsOrThrow() const;
+  static void _canQueueJobOrThrow ( const Job & );
+  void _clearDeques();
+  void _clearSubmissions();
+  void _drainSubmissions();
+  JobPtr _startPoolJob ( PoolThread &, JobPtr );
+  bool _submitJob ( JobPtr );
+  static JobPtr _takeJob ( Job * );
+  static void _setSubmitted ( Job & );
+  static void _clearSubmitted ( Job & );
 
   bool _getShouldRunWorkerThread() const;
   void _setShouldRunWorkerThread ( bool );
 
+  bool _isPoolThread() const;
   bool _isWorkerThread() const;
   void _isWorkerThreadOrThrow() const;
   void _isNotWorkerThreadOrThrow() const;
 
+  void _poolThreadStarted ( PoolThread & );
+  void _poolThreadWait ( const PoolThread & );
+
+  void _runJob ( JobPtr );
+  bool _runQueuedJob ( PoolThread &, const Job *wanted );
+
+  void _startPoolThreads();
+  void _startThreads();
+  void _stopPoolThreads();
+
   void _startWorkerThread();
   void _stopWorkerThread();
 
+  Lane _addLane ( const std::string &name, unsigned int maxNumThreads, const ProcessorIndices & );
+  bool _addLaneJob ( JobPtr );
+  LaneInfo *_getLane ( Lane ) const;
+  void _laneThreadStarted ( LaneInfo &, unsigned int index );
+  void _startLaneThreads ( LaneInfo & );
+  void _stopLaneThreads();
+
+  bool _adaptNumThreads ( unsigned int generation );
+
+  JobTimesRecord *_getJobTimesRecord ( const std::string &name );
+  void _jobAdded ( Job &, bool queued );
+  void _jobQueued ( Job & );
+  void _recordJobTimes ( const Job &, TimePoint started, TimePoint finished );
+
+  void _lockMutex ( std::unique_lock < Mutex > & );
+  void _traceBegin ( const char *name );
+  void _traceEnd ( const char *name );
+  void _traceJob ( Trace::Type, const Job & );
+
+  void _addTimer ( const Timer &, TimePoint );
+  void _clearTimers();
+  bool _fireTimer ( Timer & );
+  Tick _getCurrentTick() const;
+  Tick _getTick ( TimePoint ) const;
+  void _startTimerThread();
+  void _stopTimerThread();
+  void _timerThreadStarted();
+
   void _threadStarted();
+  void _threadWait();
+
+  void _wakeThreads ( bool all );
+
+  void _notifyIfAllDone();
+  void _notifyIfRoom();
+
+  bool _shouldWaitForRoom() const;
+  bool _waitForRoom ( std::unique_lock < Mutex > &, std::size_t numJobs, bool waitForever, unsigned int milliseconds );
 
 private:
 
@@ -145,11 +548,59 @@ private:
   ThreadPtr _workerThread;
   AtomicThreadID _workerID;
   QueuedJobs _queuedJobs;
+  Submissions _submissions;
   RunningJobs _runningJobs;
+  PoolThreads _poolThreads;
+  PoolTables _poolTables;
+  AtomicPoolTable _poolTable;
+  LanePtr _lanes[MAX_NUM_LANES]; // The default lane is null.
+  AtomicUnsignedInt _numLanes;
+  AtomicUnsignedInt _numJobsInLanes;
+  AtomicUnsignedInt _numJobsRunningInLanes;
   ErrorHandler _errorHandler;
+  Condition _wakeCondition;
+  Condition _parkCondition;
+  Condition _allDoneCondition;
+  Condition _roomCondition;
+  std::mutex _timerMutex;
+  std::condition_variable _timerCondition;
+  Timers _timers;
+  ThreadPtr _timerThread;
+  const TimePoint _timerStart;
+  Tick _timerWakeTick; // When the timer thread wakes up. Guarded by its mutex.
+  unsigned int _numTimerClears; // Guarded by the timer mutex.
   AtomicUnsignedInt _maxNumThreadsAllowed;
+  AtomicUnsignedInt _adaptMinNumThreads;
+  AtomicUnsignedInt _adaptMaxNumThreads;
+  AtomicUnsignedInt _adaptGeneration;
+  std::atomic < std::uint64_t > _adaptWallTime; // Microseconds.
+  std::atomic < std::uint64_t > _adaptThreadTime; // Microseconds.
+  double _adaptBlocked; // Only used by the timer thread.
+  unsigned int _adaptNumProcessors; // Only used by the timer thread.
+  TimePoint _adaptProcessorsTime; // When that was read. Only used by the timer thread.
+  AtomicBool _isAdapting;
+  AtomicBool _isRecordingJobTimes;
+  JobTimesRecord _jobTimes;
+  AtomicJobTimesRecord _jobTimesByName[MAX_NUM_JOB_NAMES];
+  AtomicBool _isTracing;
+  Trace _trace;
+  AtomicUnsignedInt _maxNumJobsQueued;
+  AtomicUnsignedInt _numThreadsWaitingForRoom;
   AtomicUnsignedInt _numMillisecondsToSleep;
+  AtomicThreadModel _threadModel;
+  AtomicWakeModel _wakeModel;
+  AtomicScheduler _scheduler;
+  AtomicAffinity _affinity;
+  const ProcessorIndices _processors; // Where the thread that made this runs.
+  AtomicUnsignedInt _numJobsInDeques;
+  AtomicUnsignedInt _numJobsSubmitted;
+  AtomicUnsignedInt _numJobsRunningInPool;
+  AtomicUnsignedInt _numJobsRunningInThreads; // The size of _runningJobs.
+  AtomicUnsignedInt _numThreadsWaiting;
+  AtomicUnsignedInt _numJobsWaiting;
   AtomicBool _shouldRunWorkerThread;
+  AtomicBool _shouldRunPoolThreads;
+  AtomicBool _shouldRunTimerThread;
   AtomicBool _isBeingDestroyed;
   AtomicBool _isBeingReset;
   AtomicBool _hasJobInTransition;
@@ -160,4 +611,8 @@ private:
 } // namespace Usul
 
 
+// The template functions that use the future need it.
+#include "Usul/Jobs/Future.h"
+
+
 #endif // _USUL_JOBS_JOB_MANAGER_CLASS_H_
@@ -0,0 +1,310 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Copyright (c) 2020, Perry L Miller IV
+//  All rights reserved.
+//  MIT License: https://opensource.org/licenses/mit-license.html
+//
+///////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Parallel algorithms that run on the job manager.
+//
+//  The range is split into chunks of "grain" elements. Jobs are added to
+//  the manager to help, and the calling thread also takes chunks until they
+//  are all taken, so these functions work even if the manager is busy or
+//  when they are called from inside a job. A grain of zero picks one.
+//
+//  If a function throws then the chunks that have not started are skipped,
+//  and the first exception is thrown in the calling thread.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef _USUL_JOBS_PARALLEL_ALGORITHMS_H_
+#define _USUL_JOBS_PARALLEL_ALGORITHMS_H_
+
+#include "Usul/Jobs/Allocator.h"
+#include "Usul/Jobs/Manager.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <vector>
+
+
+namespace Usul {
+namespace Jobs {
+
+
+namespace Details
+{
+  ///////////////////////////////////////////////////////////////////////////
+  //
+  //  The state shared by the calling thread and the helping jobs.
+  //
+  ///////////////////////////////////////////////////////////////////////////
+
+  struct ParallelState
+  {
+    typedef std::size_t size_type;
+    typedef std::atomic < size_type > AtomicSize;
+    typedef std::function < void ( size_type ) > ChunkFunction;
+
+    explicit ParallelState ( size_type n, const ChunkFunction *f ) :
+      numChunks ( n ),
+      nextChunk ( 0 ),
+      numFinished ( 0 ),
+      stop ( false ),
+      fun ( f ),
+      mutex(),
+      finished(),
+      error()
+    {
+    }
+
+    // Take chunks and run them until there are none left.
+    void run()
+    {
+      while ( true )
+      {
+        const size_type chunk = nextChunk++;
+        if ( chunk >= numChunks )
+        {
+          return;
+        }
+
+        if ( false == stop )
+        {
+          try
+          {
+            ( *fun ) ( chunk );
+          }
+          catch ( ... )
+          {
+            std::lock_guard < std::mutex > guard ( mutex );
+            if ( !error )
+            {
+              error = std::current_exception();
+            }
+            stop = true;
+          }
+        }
+
+        if ( numChunks == ++numFinished )
+        {
+          std::lock_guard < std::mutex > guard ( mutex );
+          finished.notify_all();
+        }
+      }
+    }
+
+    // Wait for the chunks that other threads took.
+    void wait()
+    {
+      std::unique_lock < std::mutex > lock ( mutex );
+      finished.wait ( lock, [ this ] () { return ( numChunks == numFinished ); } );
+    }
+
+    const size_type numChunks;
+    AtomicSize nextChunk;
+    AtomicSize numFinished;
+    std::atomic < bool > stop;
+    const ChunkFunction *fun; // Only used after taking a chunk.
+    std::mutex mutex;
+    std::condition_variable finished;
+    std::exception_ptr error;
+  };
+
+
+  ///////////////////////////////////////////////////////////////////////////
+  //
+  //  Run the chunks with the calling thread and the manager's threads.
+  //
+  ///////////////////////////////////////////////////////////////////////////
+
+  inline void runChunks ( Manager &manager, std::size_t numChunks, const ParallelState::ChunkFunction &fun )
+  {
+    typedef std::shared_ptr < ParallelState > StatePtr;
+
+    // Handle no work.
+    if ( 0 == numChunks )
+    {
+      return;
+    }
+
+    // Handle one chunk without any jobs.
+    if ( 1 == numChunks )
+    {
+      fun ( 0 );
+      return;
+    }
+
+    // The jobs may start after we return, so they share the state.
+    StatePtr state ( new ParallelState ( numChunks, &fun ) );
+
+    // Add a helping job for each of the other threads.
+    const std::size_t numThreads = std::max ( 1u, manager.getMaxNumThreadsAllowed() );
+    const std::size_t numHelpers = std::min ( numChunks - 1, numThreads );
+    const Manager::Callback helper = [ state ] ( Manager::JobPtr )
+    {
+      state->run();
+    };
+
+    // When the queue has a maximum size, only add the helpers that fit now.
+    // This thread can run all the chunks, so it does not wait for room.
+    if ( std::numeric_limits < unsigned int >::max() == manager.getMaxNumJobsQueued() )
+    {
+      manager.addJobs ( Manager::Callbacks ( numHelpers, helper ) );
+    }
+    else
+    {
+      for ( std::size_t i = 0; i < numHelpers; ++i )
+      {
+        if ( false == manager.tryAddJob ( std::allocate_shared < Job > ( Usul::Jobs::Allocator < Job > (), helper ) ) )
+        {
+          break;
+        }
+      }
+    }
+
+    // Help too, then wait for the chunks the jobs took.
+    state->run();
+    state->wait();
+
+    if ( state->error )
+    {
+      std::rethrow_exception ( state->error );
+    }
+  }
+
+
+  ///////////////////////////////////////////////////////////////////////////
+  //
+  //  Return the grain to use.
+  //
+  ///////////////////////////////////////////////////////////////////////////
+
+  inline std::size_t getGrain ( const Manager &manager, std::size_t size, std::size_t grain )
+  {
+    if ( grain > 0 )
+    {
+      return grain;
+    }
+
+    // A few chunks per thread so that threads that finish early can help.
+    const std::size_t numThreads = std::max ( 1u, manager.getMaxNumThreadsAllowed() );
+    return std::max < std::size_t > ( 1, size / ( 4 * numThreads ) );
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Call the function for each index in [begin, end).
+//
+///////////////////////////////////////////////////////////////////////////////
+
+template < class Index, class Function >
+inline void parallelFor ( Manager &manager, Index begin, Index end, Index grain, Function fun )
+{
+  static_assert ( std::is_integral < Index >::value, "Not an integer index type" );
+
+  // Handle an empty range.
+  if ( !( begin < end ) )
+  {
+    return;
+  }
+
+  const std::size_t size = static_cast < std::size_t > ( end - begin );
+  const std::size_t chunkSize = Details::getGrain ( manager, size, static_cast < std::size_t > ( grain ) );
+  const std::size_t numChunks = ( size + chunkSize - 1 ) / chunkSize;
+
+  Details::runChunks ( manager, numChunks, [ &fun, begin, size, chunkSize ] ( std::size_t chunk )
+  {
+    const std::size_t first = chunk * chunkSize;
+    const std::size_t last = std::min ( size, first + chunkSize );
+    for ( std::size_t i = first; i < last; ++i )
+    {
+      fun ( static_cast < Index > ( begin + static_cast < Index > ( i ) ) );
+    }
+  } );
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Reduce the values for the indices in [begin, end). Each chunk starts with
+//  the identity and calls reduce ( first, last, value ) to get its value.
+//  The values of the chunks are combined in order, so the answer is the same
+//  every time even if combine is not exactly associative.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+template < class Index, class T, class Reduce, class Combine >
+inline T parallelReduce ( Manager &manager, Index begin, Index end, Index grain, const T &identity, Reduce reduce, Combine combine )
+{
+  static_assert ( std::is_integral < Index >::value, "Not an integer index type" );
+
+  // Handle an empty range.
+  if ( !( begin < end ) )
+  {
+    return identity;
+  }
+
+  const std::size_t size = static_cast < std::size_t > ( end - begin );
+  const std::size_t chunkSize = Details::getGrain ( manager, size, static_cast < std::size_t > ( grain ) );
+  const std::size_t numChunks = ( size + chunkSize - 1 ) / chunkSize;
+
+  std::vector < T > values ( numChunks, identity );
+
+  Details::runChunks ( manager, numChunks, [ &reduce, &values, &identity, begin, size, chunkSize ] ( std::size_t chunk )
+  {
+    const std::size_t first = chunk * chunkSize;
+    const std::size_t last = std::min ( size, first + chunkSize );
+    values[chunk] = reduce (
+      static_cast < Index > ( begin + static_cast < Index > ( first ) ),
+      static_cast < Index > ( begin + static_cast < Index > ( last ) ),
+      identity );
+  } );
+
+  T answer = identity;
+  for ( auto i = values.begin(); i != values.end(); ++i )
+  {
+    answer = combine ( answer, *i );
+  }
+  return answer;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Assign out[i] = fun ( in[i] ) for each element of the input range.
+//  The iterators should be random access. The ranges can be the same.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+template < class InputIterator, class OutputIterator, class Function >
+inline void parallelTransform ( Manager &manager, InputIterator begin, InputIterator end, OutputIterator out, std::size_t grain, Function fun )
+{
+  const std::size_t size = static_cast < std::size_t > ( std::distance ( begin, end ) );
+
+  parallelFor ( manager, static_cast < std::size_t > ( 0 ), size, grain, [ &fun, begin, out ] ( std::size_t i )
+  {
+    typedef typename std::iterator_traits < InputIterator >::difference_type InputDifference;
+    typedef typename std::iterator_traits < OutputIterator >::difference_type OutputDifference;
+    out[static_cast < OutputDifference > ( i )] = fun ( begin[static_cast < InputDifference > ( i )] );
+  } );
+}
+
+
+} // namespace Jobs
+} // namespace Usul
+
+
+#endif // _USUL_JOBS_PARALLEL_ALGORITHMS_H_
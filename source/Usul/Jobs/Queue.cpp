@@ -0,0 +1,580 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Copyright (c) 2020, Perry L Miller IV
+//  All rights reserved.
+//  MIT License: https://opensource.org/licenses/mit-license.html
+//
+///////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Priority queue of jobs.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "Usul/Jobs/Queue.h"
+#include "Usul/Tools/NoThrow.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <stdexcept>
+#include <utility>
+
+
+namespace Usul {
+namespace Jobs {
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Constructor
+//
+///////////////////////////////////////////////////////////////////////////////
+
+Queue::Queue ( Mutex &mutex ) :
+  _mutex ( mutex ),
+  _entries(),
+  _sequence ( 0 ),
+  _policy ( POLICY_PRIORITY ),
+  _agingRate ( 1 ),
+  _start ( Clock::now() ),
+  _size ( 0 )
+{
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Destructor
+//
+///////////////////////////////////////////////////////////////////////////////
+
+Queue::~Queue()
+{
+  USUL_TOOLS_NO_THROW ( 1700327125, [ this ] ()
+  {
+    this->clear();
+  } );
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Remove all the jobs.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void Queue::clear ( Jobs &removed )
+{
+  Guard guard ( _mutex );
+
+  removed.reserve ( removed.size() + _entries.size() );
+
+  for ( auto i = _entries.begin(); i != _entries.end(); ++i )
+  {
+    i->job->_queue = nullptr;
+    removed.push_back ( i->job );
+  }
+
+  _entries.clear();
+  _size = 0;
+}
+void Queue::clear()
+{
+  Jobs removed;
+  this->clear ( removed );
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Is the queue empty?
+//
+///////////////////////////////////////////////////////////////////////////////
+
+bool Queue::empty() const
+{
+  return ( 0 == _size ); // This is atomic.
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Return the number of jobs.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+Queue::size_type Queue::size() const
+{
+  return _size; // This is atomic.
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Call the function for each job.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void Queue::forEach ( Visitor fun ) const
+{
+  Guard guard ( _mutex );
+  for ( auto i = _entries.begin(); i != _entries.end(); ++i )
+  {
+    fun ( i->job );
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Add the job.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void Queue::push ( JobPtr job )
+{
+  if ( nullptr == job.get() )
+  {
+    throw std::invalid_argument ( "Can not add null job to the queue" );
+  }
+
+  Guard guard ( _mutex );
+
+  // A job knows about one queue at a time, and the one in the manager's
+  // ring or a deque is on the way to a queue.
+  if ( true == Queue::_isQueued ( *job ) )
+  {
+    throw std::runtime_error ( "Job is already in a queue" );
+  }
+
+  // Add the job at the bottom and move it up to where it belongs.
+  const double pushed = std::chrono::duration < double > ( Clock::now() - _start ).count();
+  _entries.push_back ( this->_getEntry ( job, pushed ) );
+  job->_queue = this;
+  job->_queueIndex = _entries.size() - 1;
+  this->_moveUp ( _entries.size() - 1 );
+
+  // After it's in place, so that a thread that sees it can pop it.
+  _size = _entries.size();
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Add the jobs.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void Queue::push ( const Jobs &jobs )
+{
+  Guard guard ( _mutex );
+
+  const size_type numBefore = _entries.size();
+  _entries.reserve ( numBefore + jobs.size() );
+
+  const double pushed = std::chrono::duration < double > ( Clock::now() - _start ).count();
+
+  // Append the jobs. If there is a problem then take them all back out.
+  for ( auto i = jobs.begin(); i != jobs.end(); ++i )
+  {
+    const JobPtr &job = *i;
+    if ( ( nullptr == job.get() ) || ( true == Queue::_isQueued ( *job ) ) )
+    {
+      while ( _entries.size() > numBefore )
+      {
+        _entries.back().job->_queue = nullptr;
+        _entries.pop_back();
+      }
+
+      throw std::runtime_error ( ( nullptr == job.get() ) ?
+        "Can not add null job to the queue" : "Job is already in a queue" );
+    }
+
+    _entries.push_back ( this->_getEntry ( job, pushed ) );
+    job->_queue = this;
+    job->_queueIndex = _entries.size() - 1;
+  }
+
+  // When there are more new jobs than old ones it's faster to make the
+  // heap again than to move each new one up.
+  const size_type numAdded = _entries.size() - numBefore;
+  if ( numAdded > numBefore )
+  {
+    this->_makeHeap();
+  }
+  else
+  {
+    for ( size_type i = numBefore; i < _entries.size(); ++i )
+    {
+      this->_moveUp ( i );
+    }
+  }
+
+  _size = _entries.size();
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Return the job with the highest priority and remove it from the queue.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+Queue::JobPtr Queue::pop()
+{
+  Guard guard ( _mutex );
+
+  if ( true == _entries.empty() )
+  {
+    return JobPtr();
+  }
+
+  JobPtr job = _entries.front().job;
+  this->_removeAt ( 0 );
+  return job;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Remove the job.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+bool Queue::remove ( JobPtr job )
+{
+  if ( nullptr == job.get() )
+  {
+    return false;
+  }
+
+  Guard guard ( _mutex );
+
+  if ( this != job->_queue.load() )
+  {
+    return false;
+  }
+
+  this->_removeAt ( job->_queueIndex );
+  return true;
+}
+Queue::JobPtr Queue::remove ( const Job &job )
+{
+  Guard guard ( _mutex );
+
+  if ( this != job._queue.load() )
+  {
+    return JobPtr();
+  }
+
+  // The entry has the pointer that keeps it alive.
+  const size_type i = job._queueIndex;
+  JobPtr removed = _entries.at ( i ).job;
+  this->_removeAt ( i );
+  return removed;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Move the job to where its current priority says it should be.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void Queue::update ( Job &job )
+{
+  Guard guard ( _mutex );
+
+  // The job may have left the queue since it looked.
+  if ( this != job._queue.load() )
+  {
+    return;
+  }
+
+  const size_type i = job._queueIndex;
+  Entry &entry = _entries.at ( i );
+  entry.priority = this->_getPriority ( job, entry.pushed );
+  entry.deadline = job._deadline.load();
+  this->_place ( i );
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Rebuild the heap from the current priorities of all the jobs.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void Queue::rebuild()
+{
+  Guard guard ( _mutex );
+
+  for ( auto i = _entries.begin(); i != _entries.end(); ++i )
+  {
+    i->priority = this->_getPriority ( *i->job, i->pushed );
+    i->deadline = i->job->_deadline.load();
+  }
+
+  this->_makeHeap();
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Get/set the policy.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+Queue::Policy Queue::getPolicy() const
+{
+  Guard guard ( _mutex );
+  return _policy;
+}
+void Queue::setPolicy ( Policy policy )
+{
+  Guard guard ( _mutex );
+
+  if ( policy != _policy )
+  {
+    _policy = policy;
+    this->rebuild();
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Get/set how much the priority grows for every second in the queue.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+double Queue::getAgingRate() const
+{
+  Guard guard ( _mutex );
+  return _agingRate;
+}
+void Queue::setAgingRate ( double rate )
+{
+  if ( false == std::isfinite ( rate ) )
+  {
+    throw std::invalid_argument ( "Aging rate must be a finite number" );
+  }
+
+  Guard guard ( _mutex );
+
+  if ( rate != _agingRate )
+  {
+    _agingRate = rate;
+    this->rebuild();
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Make the entry for the job. The mutex should be locked.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+Queue::Entry Queue::_getEntry ( JobPtr job, double pushed )
+{
+  return Entry { this->_getPriority ( *job, pushed ), job->_deadline.load(), pushed, _sequence++, job };
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Return the priority that the job is sorted by. With aging, every job's
+//  priority grows at the same rate, so the one that went in earlier is
+//  ahead by the rate times the difference. That does not change as time
+//  goes by, so the heap stays in order. The mutex should be locked.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+double Queue::_getPriority ( const Job &job, double pushed ) const
+{
+  const double priority = job.getPriority();
+  return ( ( POLICY_AGING == _policy ) ? ( priority - ( _agingRate * pushed ) ) : priority );
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Make the entries a heap. The mutex should be locked.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void Queue::_makeHeap()
+{
+  // Move down every entry that has children, starting at the last one.
+  const size_type size = _entries.size();
+  for ( size_type i = size / 2; i > 0; --i )
+  {
+    this->_moveDown ( i - 1 );
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Remove the entry at the given index. The mutex should be locked.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void Queue::_removeAt ( size_type i )
+{
+  _entries.at ( i ).job->_queue = nullptr;
+
+  // Fill the hole with the last entry and then move that one where it goes.
+  const size_type last = _entries.size() - 1;
+  if ( i != last )
+  {
+    this->_set ( i, std::move ( _entries.back() ) );
+    _entries.pop_back();
+    this->_place ( i );
+  }
+  else
+  {
+    _entries.pop_back();
+  }
+
+  _size = _entries.size();
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Is the job in a queue, or in the manager's ring or a deque?
+//
+///////////////////////////////////////////////////////////////////////////////
+
+bool Queue::_isQueued ( const Job &job )
+{
+  return ( ( nullptr != job._queue.load() ) || ( 0 != ( job._state.load ( std::memory_order_acquire ) & Job::STATE_SUBMITTED ) ) );
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Should the first entry come out of the queue before the second?
+//
+///////////////////////////////////////////////////////////////////////////////
+
+bool Queue::_isBefore ( size_type a, size_type b ) const
+{
+  const Entry &ea = _entries[a];
+  const Entry &eb = _entries[b];
+
+  // The earliest deadline is first. No deadline is the latest one.
+  if ( ( POLICY_DEADLINE == _policy ) && ( ea.deadline != eb.deadline ) )
+  {
+    return ( ea.deadline < eb.deadline );
+  }
+
+  if ( ( POLICY_FIFO != _policy ) && ( ea.priority != eb.priority ) )
+  {
+    return ( ea.priority > eb.priority );
+  }
+
+  return ( ea.sequence < eb.sequence );
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Put the entry at the index and tell the job where it is.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void Queue::_set ( size_type i, Entry &&entry )
+{
+  _entries[i] = std::move ( entry );
+  _entries[i].job->_queueIndex = i;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Move the entry at the index up or down to where it belongs.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void Queue::_place ( size_type i )
+{
+  if ( ( i > 0 ) && ( true == this->_isBefore ( i, ( i - 1 ) / 2 ) ) )
+  {
+    this->_moveUp ( i );
+  }
+  else
+  {
+    this->_moveDown ( i );
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Move the entry at the index towards the top.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void Queue::_moveUp ( size_type i )
+{
+  while ( i > 0 )
+  {
+    const size_type parent = ( i - 1 ) / 2;
+    if ( false == this->_isBefore ( i, parent ) )
+    {
+      break;
+    }
+
+    Entry entry = std::move ( _entries[i] );
+    this->_set ( i, std::move ( _entries[parent] ) );
+    this->_set ( parent, std::move ( entry ) );
+    i = parent;
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Move the entry at the index towards the bottom.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void Queue::_moveDown ( size_type i )
+{
+  const size_type size = _entries.size();
+  while ( true )
+  {
+    const size_type left = 2 * i + 1;
+    const size_type right = left + 1;
+
+    // Find which of this entry and its children should come out first.
+    size_type first = i;
+    if ( ( left < size ) && ( true == this->_isBefore ( left, first ) ) )
+    {
+      first = left;
+    }
+    if ( ( right < size ) && ( true == this->_isBefore ( right, first ) ) )
+    {
+      first = right;
+    }
+
+    if ( first == i )
+    {
+      break;
+    }
+
+    Entry entry = std::move ( _entries[i] );
+    this->_set ( i, std::move ( _entries[first] ) );
+    this->_set ( first, std::move ( entry ) );
+    i = first;
+  }
+}
+
+
+} // namespace Jobs
+} // namespace Usul
@@ -0,0 +1,153 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Copyright (c) 2020, Perry L Miller IV
+//  All rights reserved.
+//  MIT License: https://opensource.org/licenses/mit-license.html
+//
+///////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Priority queue of jobs. It's a binary heap that knows where each job is,
+//  so a job's priority can be changed while it's in the queue. The policy
+//  says what order the jobs come out in.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef _USUL_JOBS_QUEUE_CLASS_H_
+#define _USUL_JOBS_QUEUE_CLASS_H_
+
+#include "Usul/Export.h"
+#include "Usul/Config.h" // Ignore the 4251 warning.
+#include "Usul/Jobs/Job.h"
+#include "Usul/Tools/NoCopying.h"
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+
+namespace Usul {
+namespace Jobs {
+
+
+class USUL_EXPORT Queue : public Usul::Tools::NoCopying
+{
+public:
+
+  typedef std::recursive_mutex Mutex;
+  typedef std::lock_guard < Mutex > Guard;
+  typedef Job::Ptr JobPtr;
+  typedef std::vector < JobPtr > Jobs;
+  typedef std::uint64_t Sequence;
+  typedef std::size_t size_type;
+  typedef std::function < void ( const JobPtr & ) > Visitor;
+  typedef Job::Clock Clock;
+
+  // The order that the jobs come out in. Ties go to the job that went in
+  // first, so the same priority or deadline is first in, first out.
+  enum Policy
+  {
+    POLICY_PRIORITY = 0, // Highest priority first.
+    POLICY_DEADLINE = 1, // Earliest deadline first, then highest priority.
+    POLICY_AGING = 2,    // Highest priority first, where the priority grows
+                         // by the aging rate for every second in the queue.
+    POLICY_FIFO = 3      // First in, first out.
+  };
+
+  // Constructor and destructor. The given mutex guards the queue.
+  explicit Queue ( Mutex & );
+  ~Queue();
+
+  // Remove all the jobs. The removed jobs are appended to the given container.
+  void clear();
+  void clear ( Jobs &removed );
+
+  // Is the queue empty? Does not lock the mutex.
+  bool empty() const;
+
+  // Get/set how much the priority of a job grows for every second that it
+  // waits, when the policy is aging. Setting it reorders the jobs.
+  double getAgingRate() const;
+  void   setAgingRate ( double );
+
+  // Call the function for each job. The order is not the priority order.
+  void forEach ( Visitor ) const;
+
+  // Return the next job by the policy and remove it from the queue. Jobs
+  // that tie come out in the order they went in. Returns null if the queue
+  // is empty.
+  JobPtr pop();
+
+  // Add the job. Throws if the job is already in a queue.
+  void push ( JobPtr );
+
+  // Add the jobs. Either all of them are added or, if one is null or
+  // already in a queue, none of them are and it throws.
+  void push ( const Jobs & );
+
+  // Get/set the policy. Setting it reorders the jobs.
+  Policy getPolicy() const;
+  void   setPolicy ( Policy );
+
+  // Rebuild the heap from the current priorities of all the jobs.
+  void rebuild();
+
+  // Remove the job. Returns false if it's not in this queue.
+  bool remove ( JobPtr );
+
+  // Remove the job and return it, or null if it's not in this queue.
+  JobPtr remove ( const Job & );
+
+  // Return the number of jobs. Does not lock the mutex, so it can be
+  // called often from any thread.
+  size_type size() const;
+
+  // Move the job to where its current priority says it should be.
+  // Called by the job when its priority changes.
+  void update ( Job & );
+
+private:
+
+  // The priority and deadline are saved so that the heap does not change
+  // when a job's changes before the job calls update(). With aging, the
+  // priority that's saved includes the time the job went in.
+  struct Entry
+  {
+    double priority;
+    Clock::rep deadline;
+    double pushed; // Seconds from when the queue was made.
+    Sequence sequence;
+    JobPtr job;
+  };
+  typedef std::vector < Entry > Entries;
+
+  Entry _getEntry ( JobPtr, double pushed );
+  double _getPriority ( const Job &, double pushed ) const;
+
+  bool _isBefore ( size_type, size_type ) const;
+  void _moveDown ( size_type );
+  void _moveUp ( size_type );
+  void _makeHeap();
+  void _place ( size_type );
+  void _removeAt ( size_type );
+  static bool _isQueued ( const Job & );
+  void _set ( size_type, Entry && );
+
+  Mutex &_mutex;
+  Entries _entries;
+  Sequence _sequence;
+  Policy _policy;
+  double _agingRate;
+  const Clock::time_point _start;
+  std::atomic < size_type > _size; // Set when the entries change.
+};
+
+
+} // namespace Jobs
+} // namespace Usul
+
+
+#endif // _USUL_JOBS_QUEUE_CLASS_H_
@@ -0,0 +1,195 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Copyright (c) 2020, Perry L Miller IV
+//  All rights reserved.
+//  MIT License: https://opensource.org/licenses/mit-license.html
+//
+///////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Bounded ring of pointers that any number of threads can push onto and
+//  pop from without a lock. It's first in, first out.
+//
+//  This is Dmitry Vyukov's bounded MPMC queue:
+//  https://www.1024cores.net/home/lock-free-algorithms/queues/bounded-mpmc-queue
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef _USUL_JOBS_BOUNDED_RING_CLASS_H_
+#define _USUL_JOBS_BOUNDED_RING_CLASS_H_
+
+#include "Usul/Tools/NoCopying.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+
+
+namespace Usul {
+namespace Jobs {
+
+
+template < class T >
+class Ring : public Usul::Tools::NoCopying
+{
+public:
+
+  typedef std::size_t size_type;
+  typedef std::atomic < size_type > AtomicSize;
+
+  /////////////////////////////////////////////////////////////////////////////
+  //
+  //  Constructor. The capacity should be a power of two.
+  //
+  /////////////////////////////////////////////////////////////////////////////
+
+  explicit Ring ( size_type capacity = 1024 ) :
+    _cells(),
+    _mask ( capacity - 1 ),
+    _pad0(),
+    _pushAt ( 0 ),
+    _pad1(),
+    _popAt ( 0 ),
+    _pad2()
+  {
+    if ( ( capacity < 2 ) || ( 0 != ( capacity & ( capacity - 1 ) ) ) )
+    {
+      throw std::invalid_argument ( "Ring capacity must be a power of two" );
+    }
+
+    _cells.reset ( new Cell[capacity] );
+    for ( size_type i = 0; i < capacity; ++i )
+    {
+      _cells[i].sequence.store ( i, std::memory_order_relaxed );
+      _cells[i].item = nullptr;
+    }
+  }
+
+  /////////////////////////////////////////////////////////////////////////////
+  //
+  //  Push the item. Returns false if the ring is full.
+  //
+  /////////////////////////////////////////////////////////////////////////////
+
+  bool push ( T *item )
+  {
+    Cell *cell = nullptr;
+    size_type pos = _pushAt.load ( std::memory_order_relaxed );
+
+    while ( true )
+    {
+      cell = &_cells[pos & _mask];
+      const size_type sequence = cell->sequence.load ( std::memory_order_acquire );
+      const std::intptr_t diff = static_cast < std::intptr_t > ( sequence ) - static_cast < std::intptr_t > ( pos );
+
+      // The cell is free, so try to claim it.
+      if ( 0 == diff )
+      {
+        if ( true == _pushAt.compare_exchange_weak ( pos, pos + 1, std::memory_order_relaxed ) )
+        {
+          break;
+        }
+      }
+
+      // The cell has not been popped yet, so the ring is full.
+      else if ( diff < 0 )
+      {
+        return false;
+      }
+
+      // Another thread claimed it.
+      else
+      {
+        pos = _pushAt.load ( std::memory_order_relaxed );
+      }
+    }
+
+    cell->item = item;
+    cell->sequence.store ( pos + 1, std::memory_order_release );
+    return true;
+  }
+
+  /////////////////////////////////////////////////////////////////////////////
+  //
+  //  Pop the oldest item, or return null if the ring is empty.
+  //
+  /////////////////////////////////////////////////////////////////////////////
+
+  T *pop()
+  {
+    Cell *cell = nullptr;
+    size_type pos = _popAt.load ( std::memory_order_relaxed );
+
+    while ( true )
+    {
+      cell = &_cells[pos & _mask];
+      const size_type sequence = cell->sequence.load ( std::memory_order_acquire );
+      const std::intptr_t diff = static_cast < std::intptr_t > ( sequence ) - static_cast < std::intptr_t > ( pos + 1 );
+
+      // The cell has an item, so try to claim it.
+      if ( 0 == diff )
+      {
+        if ( true == _popAt.compare_exchange_weak ( pos, pos + 1, std::memory_order_relaxed ) )
+        {
+          break;
+        }
+      }
+
+      // The cell has not been pushed yet, so the ring is empty.
+      else if ( diff < 0 )
+      {
+        return nullptr;
+      }
+
+      // Another thread claimed it.
+      else
+      {
+        pos = _popAt.load ( std::memory_order_relaxed );
+      }
+    }
+
+    T *item = cell->item;
+    cell->sequence.store ( pos + _mask + 1, std::memory_order_release );
+    return item;
+  }
+
+  /////////////////////////////////////////////////////////////////////////////
+  //
+  //  Return the capacity.
+  //
+  /////////////////////////////////////////////////////////////////////////////
+
+  size_type capacity() const
+  {
+    return ( _mask + 1 );
+  }
+
+private:
+
+  struct Cell
+  {
+    AtomicSize sequence;
+    T *item;
+  };
+
+  // The producers and consumers each have their own cache line.
+  typedef char Padding[64];
+
+  std::unique_ptr < Cell[] > _cells;
+  const size_type _mask;
+  Padding _pad0;
+  AtomicSize _pushAt;
+  Padding _pad1;
+  AtomicSize _popAt;
+  Padding _pad2;
+};
+
+
+} // namespace Jobs
+} // namespace Usul
+
+
+#endif // _USUL_JOBS_BOUNDED_RING_CLASS_H_
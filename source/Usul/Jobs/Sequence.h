@@ -0,0 +1,134 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Copyright (c) 2020, Perry L Miller IV
+//  All rights reserved.
+//  MIT License: https://opensource.org/licenses/mit-license.html
+//
+///////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Math functions for sequences of vectors that run on the job manager.
+//  They are overloads of the ones in Usul/Math/Sequence.h, which does not
+//  depend on the jobs.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef _USUL_JOBS_SEQUENCE_FUNCTIONS_H_
+#define _USUL_JOBS_SEQUENCE_FUNCTIONS_H_
+
+#include "Usul/Jobs/Parallel.h"
+#include "Usul/Math/Box.h"
+#include "Usul/Math/Matrix44.h"
+#include "Usul/Math/Sequence.h"
+#include "Usul/Math/Vector3.h"
+
+#include <vector>
+
+
+namespace Usul {
+namespace Math {
+
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Transform the sequence of vec3 elements using the job manager.
+//  Note: a and b can be the same vector.
+//
+/////////////////////////////////////////////////////////////////////////////
+
+template < class T, class I >
+inline void transform ( Usul::Jobs::Manager &manager, const Matrix44 < T, I > &m,
+  const std::vector < Vector3 < T, I > > &a, std::vector < Vector3 < T, I > > &b, std::size_t grain = 0 )
+{
+  // Resize if we have to.
+  // This also handles the case when a and b are the same vector.
+  if ( b.size() != a.size() )
+  {
+    b.resize ( a.size() );
+  }
+
+  Usul::Jobs::parallelFor ( manager, static_cast < std::size_t > ( 0 ), a.size(), grain, [ &m, &a, &b ] ( std::size_t i )
+  {
+    Usul::Math::multiply ( m, a[i], b[i] );
+  } );
+}
+template < class T, class I >
+inline void transform ( Usul::Jobs::Manager &manager, const Matrix44 < T, I > &m, std::vector < Vector3 < T, I > > &a, std::size_t grain = 0 )
+{
+  transform ( manager, m, a, a, grain );
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Normalize the sequence of vec3 elements using the job manager.
+//  Note: a and b can be the same vector.
+//
+/////////////////////////////////////////////////////////////////////////////
+
+template < class T, class I >
+inline void normalize ( Usul::Jobs::Manager &manager,
+  const std::vector < Vector3 < T, I > > &a, std::vector < Vector3 < T, I > > &b, std::size_t grain = 0 )
+{
+  // Resize if we have to.
+  // This also handles the case when a and b are the same vector.
+  if ( b.size() != a.size() )
+  {
+    b.resize ( a.size() );
+  }
+
+  Usul::Jobs::parallelFor ( manager, static_cast < std::size_t > ( 0 ), a.size(), grain, [ &a, &b ] ( std::size_t i )
+  {
+    Usul::Math::normalize ( a[i], b[i] );
+  } );
+}
+template < class T, class I >
+inline void normalize ( Usul::Jobs::Manager &manager, std::vector < Vector3 < T, I > > &a, std::size_t grain = 0 )
+{
+  normalize ( manager, a, a, grain );
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Grow the box by the sequence of vec3 elements using the job manager.
+//  Each chunk makes its own box and then they are combined.
+//
+/////////////////////////////////////////////////////////////////////////////
+
+template < class T, class I >
+inline void grow ( Usul::Jobs::Manager &manager, Box < T, I > &box, const std::vector < Vector3 < T, I > > &a, std::size_t grain = 0 )
+{
+  typedef Box < T, I > BoxType;
+
+  const BoxType answer = Usul::Jobs::parallelReduce ( manager, static_cast < std::size_t > ( 0 ), a.size(), grain, BoxType(),
+    [ &a ] ( std::size_t first, std::size_t last, BoxType part )
+    {
+      for ( std::size_t i = first; i < last; ++i )
+      {
+        part.grow ( a[i] );
+      }
+      return part;
+    },
+    [] ( BoxType b1, const BoxType &b2 )
+    {
+      if ( true == b2.valid() )
+      {
+        b1.grow ( b2 );
+      }
+      return b1;
+    } );
+
+  if ( true == answer.valid() )
+  {
+    box.grow ( answer );
+  }
+}
+
+
+} // namespace Math
+} // namespace Usul
+
+
+#endif // _USUL_JOBS_SEQUENCE_FUNCTIONS_H_
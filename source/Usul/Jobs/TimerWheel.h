@@ -0,0 +1,342 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Copyright (c) 2020, Perry L Miller IV
+//  All rights reserved.
+//  MIT License: https://opensource.org/licenses/mit-license.html
+//
+///////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Hierarchical timer wheel. Each level has 64 slots, and each slot of a
+//  level spans all 64 slots of the level below it. An item goes in the
+//  lowest level that can tell its tick apart from the current tick, and
+//  moves down a level when the wheel gets to its slot. Adding is constant
+//  time, and so is finding the next tick when something happens, so the
+//  thread that turns the wheel only wakes up when it has to.
+//
+//  Not thread safe. The ticks are whatever unit the caller wants.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef _USUL_JOBS_TIMER_WHEEL_CLASS_H_
+#define _USUL_JOBS_TIMER_WHEEL_CLASS_H_
+
+#include "Usul/Tools/NoCopying.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+
+namespace Usul {
+namespace Jobs {
+
+
+template < class T >
+class TimerWheel : public Usul::Tools::NoCopying
+{
+public:
+
+  typedef std::uint64_t Tick;
+  typedef std::pair < Tick, T > Item;
+  typedef std::vector < Item > Items;
+  typedef std::size_t size_type;
+
+  /////////////////////////////////////////////////////////////////////////////
+  //
+  //  Constructor.
+  //
+  /////////////////////////////////////////////////////////////////////////////
+
+  explicit TimerWheel ( Tick now = 0 ) :
+    _slots(),
+    _occupied(),
+    _due(),
+    _now ( now ),
+    _size ( 0 )
+  {
+    for ( unsigned int level = 0; level < NUM_LEVELS; ++level )
+    {
+      _occupied[level] = 0;
+    }
+  }
+
+  /////////////////////////////////////////////////////////////////////////////
+  //
+  //  Add the item. If the tick has already gone by then it's due now.
+  //
+  /////////////////////////////////////////////////////////////////////////////
+
+  void add ( Tick tick, const T &value )
+  {
+    this->_place ( Item ( tick, value ) );
+    ++_size;
+  }
+
+  /////////////////////////////////////////////////////////////////////////////
+  //
+  //  Turn the wheel to the given tick and append the items that are due to
+  //  the given container.
+  //
+  /////////////////////////////////////////////////////////////////////////////
+
+  void advance ( Tick now, Items &due )
+  {
+    this->_takeDue ( due );
+
+    while ( true )
+    {
+      const Tick tick = this->next();
+      if ( tick > now )
+      {
+        break;
+      }
+
+      _now = tick;
+      this->_turn ( due );
+    }
+
+    if ( now > _now )
+    {
+      _now = now;
+    }
+  }
+
+  /////////////////////////////////////////////////////////////////////////////
+  //
+  //  Take all the items out and append them to the given container.
+  //
+  /////////////////////////////////////////////////////////////////////////////
+
+  void clear ( Items &removed )
+  {
+    this->_takeDue ( removed );
+
+    for ( unsigned int level = 0; level < NUM_LEVELS; ++level )
+    {
+      for ( unsigned int slot = 0; slot < NUM_SLOTS; ++slot )
+      {
+        this->_takeSlot ( level, slot, removed );
+      }
+    }
+  }
+
+  /////////////////////////////////////////////////////////////////////////////
+  //
+  //  Is the wheel empty?
+  //
+  /////////////////////////////////////////////////////////////////////////////
+
+  bool empty() const
+  {
+    return ( 0 == _size );
+  }
+
+  /////////////////////////////////////////////////////////////////////////////
+  //
+  //  Return the next tick when an item may be due. Items that are further
+  //  away move down a level at that tick, so nothing may be due yet. Returns
+  //  the max tick if the wheel is empty.
+  //
+  /////////////////////////////////////////////////////////////////////////////
+
+  Tick next() const
+  {
+    if ( false == _due.empty() )
+    {
+      return _now;
+    }
+
+    // The first slot found is the soonest, because every slot of a level
+    // comes before the next slot of the level above it.
+    for ( unsigned int level = 0; level < NUM_LEVELS; ++level )
+    {
+      const unsigned int shift = level * BITS;
+      const unsigned int current = static_cast < unsigned int > ( ( _now >> shift ) & MASK );
+      const unsigned int slot = TimerWheel::_findSlotAfter ( _occupied[level], current );
+      if ( slot < NUM_SLOTS )
+      {
+        const Tick above = ( ( shift + BITS ) < 64 ) ? ( ( _now >> ( shift + BITS ) ) << ( shift + BITS ) ) : 0;
+        return ( above | ( static_cast < Tick > ( slot ) << shift ) );
+      }
+    }
+
+    return std::numeric_limits < Tick >::max();
+  }
+
+  /////////////////////////////////////////////////////////////////////////////
+  //
+  //  Return the tick that the wheel is at.
+  //
+  /////////////////////////////////////////////////////////////////////////////
+
+  Tick now() const
+  {
+    return _now;
+  }
+
+  /////////////////////////////////////////////////////////////////////////////
+  //
+  //  Return the number of items.
+  //
+  /////////////////////////////////////////////////////////////////////////////
+
+  size_type size() const
+  {
+    return _size;
+  }
+
+private:
+
+  // Eleven levels of six bits covers every 64-bit tick.
+  enum
+  {
+    BITS = 6,
+    NUM_SLOTS = 64,
+    MASK = 63,
+    NUM_LEVELS = 11
+  };
+
+  /////////////////////////////////////////////////////////////////////////////
+  //
+  //  Return the first slot after the given one that has items in it, or
+  //  the number of slots if there is none.
+  //
+  /////////////////////////////////////////////////////////////////////////////
+
+  static unsigned int _findSlotAfter ( std::uint64_t occupied, unsigned int slot )
+  {
+    if ( slot >= MASK )
+    {
+      return NUM_SLOTS;
+    }
+
+    occupied >>= ( slot + 1 );
+    if ( 0 == occupied )
+    {
+      return NUM_SLOTS;
+    }
+
+    while ( 0 == ( occupied & 1 ) )
+    {
+      occupied >>= 1;
+      ++slot;
+    }
+    return ( slot + 1 );
+  }
+
+  /////////////////////////////////////////////////////////////////////////////
+  //
+  //  Put the item in the lowest level that can tell its tick apart from
+  //  the current tick. That is the highest group of bits where they differ.
+  //
+  /////////////////////////////////////////////////////////////////////////////
+
+  void _place ( Item &&item )
+  {
+    if ( item.first <= _now )
+    {
+      _due.push_back ( std::move ( item ) );
+      return;
+    }
+
+    const Tick differ = ( item.first ^ _now );
+    unsigned int level = 0;
+    while ( ( ( level + 1 ) < NUM_LEVELS ) && ( 0 != ( differ >> ( ( level + 1 ) * BITS ) ) ) )
+    {
+      ++level;
+    }
+
+    const unsigned int slot = static_cast < unsigned int > ( ( item.first >> ( level * BITS ) ) & MASK );
+    _slots[level][slot].push_back ( std::move ( item ) );
+    _occupied[level] |= ( static_cast < std::uint64_t > ( 1 ) << slot );
+  }
+
+  /////////////////////////////////////////////////////////////////////////////
+  //
+  //  The wheel is now at a tick where something happens. Move the items in
+  //  the higher levels down, from the top, and then take the due ones.
+  //
+  /////////////////////////////////////////////////////////////////////////////
+
+  void _turn ( Items &due )
+  {
+    unsigned int top = 0;
+    while ( ( ( top + 1 ) < NUM_LEVELS ) && ( 0 == ( _now & ( ( static_cast < Tick > ( 1 ) << ( ( top + 1 ) * BITS ) ) - 1 ) ) ) )
+    {
+      ++top;
+    }
+
+    Items items;
+    for ( unsigned int level = top; level > 0; --level )
+    {
+      const unsigned int slot = static_cast < unsigned int > ( ( _now >> ( level * BITS ) ) & MASK );
+      this->_takeSlot ( level, slot, items );
+
+      // Taking them counted them as gone, but they are still in the wheel.
+      _size += items.size();
+      for ( auto i = items.begin(); i != items.end(); ++i )
+      {
+        this->_place ( std::move ( *i ) );
+      }
+      items.clear();
+    }
+
+    this->_takeDue ( due );
+    this->_takeSlot ( 0, static_cast < unsigned int > ( _now & MASK ), due );
+  }
+
+  /////////////////////////////////////////////////////////////////////////////
+  //
+  //  Take the items out of the slot and append them to the container.
+  //
+  /////////////////////////////////////////////////////////////////////////////
+
+  void _takeSlot ( unsigned int level, unsigned int slot, Items &items )
+  {
+    Items &from = _slots[level][slot];
+    if ( true == from.empty() )
+    {
+      return;
+    }
+
+    _size -= from.size();
+    items.insert ( items.end(), std::make_move_iterator ( from.begin() ), std::make_move_iterator ( from.end() ) );
+    from.clear();
+    _occupied[level] &= ~( static_cast < std::uint64_t > ( 1 ) << slot );
+  }
+
+  /////////////////////////////////////////////////////////////////////////////
+  //
+  //  Take the items that are due and append them to the container.
+  //
+  /////////////////////////////////////////////////////////////////////////////
+
+  void _takeDue ( Items &items )
+  {
+    if ( true == _due.empty() )
+    {
+      return;
+    }
+
+    _size -= _due.size();
+    items.insert ( items.end(), std::make_move_iterator ( _due.begin() ), std::make_move_iterator ( _due.end() ) );
+    _due.clear();
+  }
+
+  Items _slots[NUM_LEVELS][NUM_SLOTS];
+  std::uint64_t _occupied[NUM_LEVELS];
+  Items _due;
+  Tick _now;
+  size_type _size;
+};
+
+
+} // namespace Jobs
+} // namespace Usul
+
+
+#endif // _USUL_JOBS_TIMER_WHEEL_CLASS_H_
@@ -0,0 +1,312 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Copyright (c) 2020, Perry L Miller IV
+//  All rights reserved.
+//  MIT License: https://opensource.org/licenses/mit-license.html
+//
+///////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Trace of what the job manager's threads do.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "Usul/Jobs/Trace.h"
+#include "Usul/Strings/Format.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <ostream>
+
+
+namespace Usul {
+namespace Jobs {
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Helper functions and variables.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+namespace { namespace Details
+{
+  // Each trace gets its own number, so that a thread's cached buffer is
+  // never used with another trace that has the same address.
+  std::atomic < std::uint64_t > nextTraceID ( 1 );
+
+  // The name of the calling thread.
+  thread_local std::string threadName;
+
+  // Write the string with the characters that JSON needs escaped.
+  inline void writeString ( std::ostream &out, const std::string &s )
+  {
+    out << '"';
+    for ( auto i = s.begin(); i != s.end(); ++i )
+    {
+      const unsigned char c = static_cast < unsigned char > ( *i );
+      if ( ( '"' == c ) || ( '\\' == c ) )
+      {
+        out << '\\' << *i;
+      }
+      else if ( c < 0x20 )
+      {
+        out << "\\u" << std::hex << std::setw ( 4 ) << std::setfill ( '0' ) << static_cast < unsigned int > ( c ) << std::dec << std::setfill ( ' ' );
+      }
+      else
+      {
+        out << *i;
+      }
+    }
+    out << '"';
+  }
+
+  // Write the members that all events have.
+  inline void writeStart ( std::ostream &out, const char *phase, const char *category, const std::string &name, unsigned int thread, std::uint64_t time )
+  {
+    out << ",\n{\"ph\":\"" << phase << "\",\"cat\":\"" << category << "\",\"name\":";
+    Details::writeString ( out, name );
+    out << ",\"pid\":1,\"tid\":" << thread << ",\"ts\":" << time;
+  }
+} }
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Constructor and destructor.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+Trace::Trace ( size_type capacityPerThread ) :
+  _id ( Details::nextTraceID++ ),
+  _capacity ( std::max < size_type > ( 1, capacityPerThread ) ),
+  _mutex(),
+  _buffers(),
+  _start ( Clock::now().time_since_epoch().count() )
+{
+}
+Trace::~Trace()
+{
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Remove the events.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void Trace::clear()
+{
+  std::lock_guard < std::mutex > guard ( _mutex );
+
+  for ( auto i = _buffers.begin(); i != _buffers.end(); ++i )
+  {
+    Buffer &buffer = **i;
+    std::lock_guard < std::mutex > bufferGuard ( buffer.mutex );
+    buffer.events.clear();
+    buffer.numEvents = 0;
+  }
+
+  _start = Clock::now().time_since_epoch().count();
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Return the number of events kept.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+Trace::size_type Trace::getNumEvents() const
+{
+  std::lock_guard < std::mutex > guard ( _mutex );
+
+  size_type num = 0;
+  for ( auto i = _buffers.begin(); i != _buffers.end(); ++i )
+  {
+    const Buffer &buffer = **i;
+    std::lock_guard < std::mutex > bufferGuard ( buffer.mutex );
+    num += buffer.events.size();
+  }
+  return num;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Record an event in the calling thread's ring.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void Trace::record ( Type type, unsigned long id, const std::string &name, std::uint64_t duration )
+{
+  typedef std::chrono::microseconds Microseconds;
+
+  const Clock::duration elapsed = Clock::now().time_since_epoch() - Clock::duration ( _start.load() );
+  const Microseconds::rep time = std::chrono::duration_cast < Microseconds > ( elapsed ).count();
+
+  Buffer &buffer = this->_getBuffer();
+  std::lock_guard < std::mutex > guard ( buffer.mutex );
+
+  // The ring grows to its size and then the oldest one is replaced. The
+  // string is assigned to, so it does not allocate once it's big enough.
+  if ( buffer.events.size() < _capacity )
+  {
+    buffer.events.push_back ( Event() );
+  }
+  Event &e = buffer.events.at ( static_cast < size_type > ( buffer.numEvents % _capacity ) );
+  ++buffer.numEvents;
+
+  e.time = static_cast < std::uint64_t > ( ( time > 0 ) ? time : 0 );
+  e.duration = duration;
+  e.id = id;
+  e.name = name;
+  e.type = type;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Set the name of the calling thread.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void Trace::setThreadName ( const std::string &name )
+{
+  Details::threadName = name;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Return the calling thread's buffer, making it the first time.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+Trace::Buffer &Trace::_getBuffer()
+{
+  // The last one this thread used.
+  thread_local std::uint64_t cachedID = 0;
+  thread_local Buffer *cachedBuffer = nullptr;
+
+  if ( ( _id == cachedID ) && ( nullptr != cachedBuffer ) )
+  {
+    return *cachedBuffer;
+  }
+
+  std::lock_guard < std::mutex > guard ( _mutex );
+
+  // A new thread can have the id of one that's gone, but if it has a
+  // different name then it gets its own row.
+  const std::thread::id thread = std::this_thread::get_id();
+  const std::string &name = Details::threadName;
+  auto i = std::find_if ( _buffers.begin(), _buffers.end(), [ &thread, &name ] ( const BufferPtr &b )
+  {
+    return ( ( thread == b->thread ) && ( ( true == name.empty() ) || ( name == b->name ) ) );
+  } );
+
+  Buffer *buffer = nullptr;
+  if ( _buffers.end() != i )
+  {
+    buffer = i->get();
+  }
+  else
+  {
+    const unsigned int index = static_cast < unsigned int > ( _buffers.size() );
+    const std::string n ( ( true == name.empty() ) ? Usul::Strings::format ( "thread ", index ) : name );
+    _buffers.push_back ( BufferPtr ( new Buffer ( index, thread, n ) ) );
+    buffer = _buffers.back().get();
+  }
+
+  cachedID = _id;
+  cachedBuffer = buffer;
+  return *buffer;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Write the events as Chrome trace-event JSON. The jobs are slices on the
+//  rows of the threads that ran them, with arrows from where they were
+//  queued. See the "Trace Event Format" document for the details.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void Trace::write ( std::ostream &out ) const
+{
+  std::lock_guard < std::mutex > guard ( _mutex );
+
+  out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+  out << "{\"ph\":\"M\",\"name\":\"process_name\",\"pid\":1,\"args\":{\"name\":\"Usul job manager\"}}";
+
+  for ( auto i = _buffers.begin(); i != _buffers.end(); ++i )
+  {
+    const Buffer &buffer = **i;
+    std::lock_guard < std::mutex > bufferGuard ( buffer.mutex );
+
+    out << ",\n{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":" << buffer.index << ",\"args\":{\"name\":";
+    Details::writeString ( out, buffer.name );
+    out << "}}";
+
+    // Oldest first. When the ring has wrapped, that's the next one to go.
+    const size_type size = buffer.events.size();
+    const size_type first = ( ( buffer.numEvents > size ) ? static_cast < size_type > ( buffer.numEvents % size ) : 0 );
+    for ( size_type j = 0; j < size; ++j )
+    {
+      const Event &e = buffer.events.at ( ( first + j ) % size );
+      const unsigned int tid = buffer.index;
+
+      switch ( e.type )
+      {
+        case ENQUEUE:
+          Details::writeStart ( out, "i", "enqueue", e.name, tid, e.time );
+          out << ",\"s\":\"t\",\"args\":{\"id\":" << e.id << "}}";
+          Details::writeStart ( out, "s", "job", e.name, tid, e.time );
+          out << ",\"id\":" << e.id << "}";
+          break;
+        case WAIT:
+          Details::writeStart ( out, "i", "wait", e.name, tid, e.time );
+          out << ",\"s\":\"t\",\"args\":{\"id\":" << e.id << "}}";
+          break;
+        case DEQUEUE:
+          Details::writeStart ( out, "i", "dequeue", e.name, tid, e.time );
+          out << ",\"s\":\"t\",\"args\":{\"id\":" << e.id << "}}";
+          break;
+        case START:
+          Details::writeStart ( out, "B", "job", e.name, tid, e.time );
+          out << ",\"args\":{\"id\":" << e.id << "}}";
+          Details::writeStart ( out, "f", "job", e.name, tid, e.time );
+          out << ",\"bp\":\"e\",\"id\":" << e.id << "}";
+          break;
+        case FINISH:
+          Details::writeStart ( out, "E", "job", e.name, tid, e.time );
+          out << "}";
+          break;
+        case CANCEL:
+          Details::writeStart ( out, "i", "cancel", e.name, tid, e.time );
+          out << ",\"s\":\"t\",\"args\":{\"id\":" << e.id << "}}";
+          break;
+        case BEGIN:
+          Details::writeStart ( out, "B", "thread", e.name, tid, e.time );
+          out << "}";
+          break;
+        case END:
+          Details::writeStart ( out, "E", "thread", e.name, tid, e.time );
+          out << "}";
+          break;
+        case LOCK:
+          Details::writeStart ( out, "X", "lock", e.name, tid, ( ( e.time > e.duration ) ? ( e.time - e.duration ) : 0 ) );
+          out << ",\"dur\":" << e.duration << "}";
+          break;
+      }
+    }
+  }
+
+  out << "\n]}\n";
+}
+
+
+} // namespace Jobs
+} // namespace Usul
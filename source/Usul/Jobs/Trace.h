@@ -0,0 +1,125 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Copyright (c) 2020, Perry L Miller IV
+//  All rights reserved.
+//  MIT License: https://opensource.org/licenses/mit-license.html
+//
+///////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Trace of what the job manager's threads do. Each thread records into its
+//  own ring of events, so threads do not wait for each other, and when a
+//  ring is full the oldest events are replaced. The events are written as
+//  Chrome trace-event JSON, which Perfetto and chrome://tracing can open.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef _USUL_JOBS_TRACE_CLASS_H_
+#define _USUL_JOBS_TRACE_CLASS_H_
+
+#include "Usul/Export.h"
+#include "Usul/Config.h" // Ignore the 4251 warning.
+#include "Usul/Tools/NoCopying.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+namespace Usul {
+namespace Jobs {
+
+
+class USUL_EXPORT Trace : public Usul::Tools::NoCopying
+{
+public:
+
+  typedef std::chrono::steady_clock Clock;
+  typedef Clock::time_point TimePoint;
+  typedef std::size_t size_type;
+
+  // What happened.
+  enum Type
+  {
+    ENQUEUE = 0, // The job is in a queue, ready to run.
+    WAIT = 1,    // The job is waiting for other jobs or a timer.
+    DEQUEUE = 2, // A thread took the job from a queue.
+    START = 3,   // The job started running.
+    FINISH = 4,  // The job finished running.
+    CANCEL = 5,  // The job was cancelled, cleared, or skipped.
+    BEGIN = 6,   // The thread started doing the named thing, like waiting.
+    END = 7,     // The thread stopped doing it.
+    LOCK = 8     // The thread waited for a lock for the duration.
+  };
+
+  // The number of events each thread keeps.
+  enum { DEFAULT_CAPACITY = 8192 };
+
+  explicit Trace ( size_type capacityPerThread = DEFAULT_CAPACITY );
+  ~Trace();
+
+  // Remove the events. The times start over from now.
+  void clear();
+
+  // Return the number of events kept.
+  size_type getNumEvents() const;
+
+  // Record an event in the calling thread's ring. The duration is in
+  // microseconds and is only used by the lock event.
+  void record ( Type, unsigned long id, const std::string &name, std::uint64_t duration = 0 );
+
+  // Set the name of the calling thread, for the threads it records in.
+  static void setThreadName ( const std::string & );
+
+  // Write the events as Chrome trace-event JSON.
+  void write ( std::ostream & ) const;
+
+private:
+
+  struct Event
+  {
+    std::uint64_t time; // Microseconds since the start.
+    std::uint64_t duration;
+    unsigned long id;
+    std::string name;
+    Type type;
+  };
+
+  // The events of one thread. The mutex is only locked by that thread and
+  // by the one that writes the trace, so it's almost never waited for.
+  struct Buffer : public Usul::Tools::NoCopying
+  {
+    Buffer ( unsigned int i, std::thread::id t, const std::string &n ) : index ( i ), thread ( t ), name ( n ), mutex(), events(), numEvents ( 0 ) {}
+    const unsigned int index;
+    const std::thread::id thread;
+    const std::string name;
+    mutable std::mutex mutex;
+    std::vector < Event > events;
+    std::uint64_t numEvents; // All of them, including the ones replaced.
+  };
+  typedef std::unique_ptr < Buffer > BufferPtr;
+  typedef std::vector < BufferPtr > Buffers;
+
+  Buffer &_getBuffer();
+
+  const std::uint64_t _id;
+  const size_type _capacity;
+  mutable std::mutex _mutex;
+  Buffers _buffers; // Only added to, so the threads can keep pointers.
+  std::atomic < Clock::rep > _start;
+};
+
+
+} // namespace Jobs
+} // namespace Usul
+
+
+#endif // _USUL_JOBS_TRACE_CLASS_H_
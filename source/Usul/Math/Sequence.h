@@ -16,6 +16,7 @@
 #ifndef _USUL_MATH_SEQUENCE_FUNCTIONS_H_
 #define _USUL_MATH_SEQUENCE_FUNCTIONS_H_
 
+#include "Usul/Math/Box.h"
 #include "Usul/Math/Matrix44.h"
 #include "Usul/Math/Vector3.h"
 
@@ -100,6 +101,22 @@ inline void normalize ( std::vector < Vector3 < T, I > > &a )
 }
 
 
+/////////////////////////////////////////////////////////////////////////////
+//
+//  Grow the box by the sequence of vec3 elements.
+//
+/////////////////////////////////////////////////////////////////////////////
+
+template < class T, class I >
+inline void grow ( Box < T, I > &box, const std::vector < Vector3 < T, I > > &a )
+{
+  for ( auto i = a.begin(); i != a.end(); ++i )
+  {
+    box.grow ( *i );
+  }
+}
+
+
 } // namespace Math
 } // namespace Usul
 
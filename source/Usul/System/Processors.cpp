@@ -0,0 +1,499 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Copyright (c) 2020, Perry L Miller IV
+//  All rights reserved.
+//  MIT License: https://opensource.org/licenses/mit-license.html
+//
+///////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Functions for the processors that this process can use.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "Usul/System/Processors.h"
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#ifdef _WIN32
+# define NOMINMAX
+# define VC_EXTRALEAN
+# define WIN32_LEAN_AND_MEAN
+# include <windows.h> // For GetThreadTimes()
+#else
+# include <time.h>    // For clock_gettime()
+#endif
+
+#ifdef __linux__
+# include <pthread.h> // For pthread_setaffinity_np()
+# include <sched.h>   // For sched_getaffinity()
+#endif
+
+
+namespace Usul {
+namespace System {
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Return the number of processors that the cgroup's CPU quota allows, or
+//  zero if there is no quota.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifdef __linux__
+
+namespace { namespace Details
+{
+  inline unsigned int getNumFromQuota ( double quota, double period )
+  {
+    if ( ( quota <= 0 ) || ( period <= 0 ) )
+    {
+      return 0;
+    }
+
+    // A quota of one and a half processors can keep two of them busy.
+    const double num = quota / period;
+    const unsigned int whole = static_cast < unsigned int > ( num );
+    return ( ( static_cast < double > ( whole ) < num ) ? ( whole + 1 ) : whole );
+  }
+
+  // Return the smaller number, where zero means there is no limit.
+  inline unsigned int getSmaller ( unsigned int a, unsigned int b )
+  {
+    return ( ( 0 == a ) ? b : ( ( 0 == b ) ? a : std::min ( a, b ) ) );
+  }
+
+  // Version 2 has one file with "quota period", where the quota may be
+  // the word "max".
+  inline unsigned int getNumFromCpuMax ( const std::string &dir )
+  {
+    std::ifstream in ( ( dir + "/cpu.max" ).c_str() );
+    std::string quota;
+    double period = 0;
+    if ( in >> quota >> period )
+    {
+      return ( ( "max" == quota ) ? 0 : getNumFromQuota ( std::stod ( quota ), period ) );
+    }
+    return 0;
+  }
+
+  // Version 1 has two files, and the quota is -1 when there is none.
+  inline unsigned int getNumFromCfs ( const std::string &dir )
+  {
+    std::ifstream inQuota ( ( dir + "/cpu.cfs_quota_us" ).c_str() );
+    std::ifstream inPeriod ( ( dir + "/cpu.cfs_period_us" ).c_str() );
+    double quota = 0, period = 0;
+    if ( ( inQuota >> quota ) && ( inPeriod >> period ) )
+    {
+      return getNumFromQuota ( quota, period );
+    }
+    return 0;
+  }
+
+  // Is the name in the comma-separated list?
+  inline bool isInList ( const std::string &list, const std::string &name )
+  {
+    std::istringstream items ( list );
+    std::string item;
+    while ( std::getline ( items, item, ',' ) )
+    {
+      if ( name == item )
+      {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // Get this process's cgroup paths from lines like "0::/a/b" for version
+  // 2 and "4:cpu,cpuacct:/a/b" for version 1.
+  inline void getCgroupPaths ( std::string &v2, std::string &v1 )
+  {
+    std::ifstream in ( "/proc/self/cgroup" );
+    std::string line;
+    while ( std::getline ( in, line ) )
+    {
+      const std::string::size_type first = line.find ( ':' );
+      const std::string::size_type second = ( ( std::string::npos == first ) ? first : line.find ( ':', first + 1 ) );
+      if ( std::string::npos == second )
+      {
+        continue;
+      }
+      const std::string id = line.substr ( 0, first );
+      const std::string controllers = line.substr ( first + 1, second - first - 1 );
+      const std::string path = line.substr ( second + 1 );
+      if ( ( "0" == id ) && ( true == controllers.empty() ) )
+      {
+        v2 = path;
+      }
+      else if ( true == isInList ( controllers, "cpu" ) )
+      {
+        v1 = path;
+      }
+    }
+  }
+
+  // Find where the cgroup hierarchy is mounted, and the cgroup path that is
+  // its root, from /proc/self/mountinfo. Each line is "id parent major:minor
+  // root mount options [optional fields] - type source super-options".
+  inline bool getCgroupMount ( bool v2, std::string &mount, std::string &root )
+  {
+    std::ifstream in ( "/proc/self/mountinfo" );
+    std::string line;
+    while ( std::getline ( in, line ) )
+    {
+      std::istringstream fields ( line );
+      std::string id, parent, device, r, m, field;
+      if ( !( fields >> id >> parent >> device >> r >> m ) )
+      {
+        continue;
+      }
+      while ( ( fields >> field ) && ( "-" != field ) )
+      {
+      }
+      std::string type, source, options;
+      if ( !( fields >> type >> source >> options ) )
+      {
+        continue;
+      }
+      if ( ( true == v2 ) ? ( "cgroup2" == type ) : ( ( "cgroup" == type ) && ( true == isInList ( options, "cpu" ) ) ) )
+      {
+        mount = m;
+        root = r;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // Return the smallest quota of the cgroup and its parents, because each
+  // of them limits the ones below it.
+  template < class Reader >
+  inline unsigned int getNumFromHierarchy ( const std::string &mount, const std::string &root, std::string path, Reader reader )
+  {
+    // The path is relative to the root of the cgroup namespace, which may
+    // be below the root of the hierarchy. The root has to match whole
+    // names, so "/a" is not taken off of "/ab".
+    const bool underRoot = ( ( 0 == path.compare ( 0, root.size(), root ) ) &&
+      ( ( path.size() == root.size() ) || ( '/' == path[root.size()] ) ) );
+    if ( ( "/" != root ) && ( true == underRoot ) )
+    {
+      path = ( ( path.size() == root.size() ) ? std::string ( "/" ) : path.substr ( root.size() ) );
+    }
+
+    unsigned int num = 0;
+    while ( false == path.empty() )
+    {
+      num = getSmaller ( num, reader ( ( "/" == path ) ? mount : ( mount + path ) ) );
+      if ( "/" == path )
+      {
+        break;
+      }
+      const std::string::size_type slash = path.find_last_of ( '/' );
+      path = ( ( ( std::string::npos == slash ) || ( 0 == slash ) ) ? std::string ( "/" ) : path.substr ( 0, slash ) );
+    }
+    return num;
+  }
+
+  inline unsigned int getNumFromCgroup()
+  {
+    std::string v2, v1;
+    getCgroupPaths ( v2, v1 );
+
+    std::string mount, root;
+    unsigned int num = 0;
+
+    // Version 2, and version 1 with the cpu controller, which is often
+    // mounted with another one, like "cpu,cpuacct". A process can have
+    // both when the hierarchies are mixed.
+    if ( ( false == v2.empty() ) && ( true == getCgroupMount ( true, mount, root ) ) )
+    {
+      num = getSmaller ( num, getNumFromHierarchy ( mount, root, v2, getNumFromCpuMax ) );
+    }
+    if ( ( false == v1.empty() ) && ( true == getCgroupMount ( false, mount, root ) ) )
+    {
+      num = getSmaller ( num, getNumFromHierarchy ( mount, root, v1, getNumFromCfs ) );
+    }
+
+    // Without those files, look where they usually are.
+    if ( 0 == num )
+    {
+      num = getSmaller ( getNumFromCpuMax ( "/sys/fs/cgroup" ), getNumFromCfs ( "/sys/fs/cgroup/cpu" ) );
+    }
+
+    return num;
+  }
+
+  // Read a list like "0-3,8,10-11" from the file. Returns false if the
+  // file is not there.
+  inline bool readList ( const std::string &file, Usul::System::Processors::Indices &indices )
+  {
+    std::ifstream in ( file.c_str() );
+    std::string line;
+    if ( !std::getline ( in, line ) )
+    {
+      return false;
+    }
+
+    std::istringstream items ( line );
+    std::string item;
+    while ( std::getline ( items, item, ',' ) )
+    {
+      if ( true == item.empty() )
+      {
+        continue;
+      }
+      const std::string::size_type dash = item.find ( '-' );
+      const unsigned long first = std::stoul ( item.substr ( 0, dash ) );
+      const unsigned long last = ( ( std::string::npos == dash ) ? first : std::stoul ( item.substr ( dash + 1 ) ) );
+      for ( unsigned long i = first; i <= last; ++i )
+      {
+        indices.push_back ( static_cast < unsigned int > ( i ) );
+      }
+    }
+    return true;
+  }
+} }
+
+#endif
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Return the processors that the calling thread can run on.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+Processors::Indices Processors::getAvailable()
+{
+  Indices indices;
+
+  #ifdef __linux__
+
+    cpu_set_t set;
+    CPU_ZERO ( &set );
+    if ( 0 == ::sched_getaffinity ( 0, sizeof ( set ), &set ) )
+    {
+      for ( unsigned int i = 0; i < CPU_SETSIZE; ++i )
+      {
+        if ( CPU_ISSET ( i, &set ) )
+        {
+          indices.push_back ( i );
+        }
+      }
+      return indices;
+    }
+
+  #endif
+
+  const unsigned int num = std::max ( 1u, std::thread::hardware_concurrency() );
+  for ( unsigned int i = 0; i < num; ++i )
+  {
+    indices.push_back ( i );
+  }
+  return indices;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Return the number of processors that this process can use.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+unsigned int Processors::getNumAvailable()
+{
+  // This is how many threads the hardware can run at the same time.
+  unsigned int num = std::thread::hardware_concurrency();
+
+  #ifdef __linux__
+
+    // The process may only be allowed to run on some of them.
+    cpu_set_t set;
+    CPU_ZERO ( &set );
+    if ( 0 == ::sched_getaffinity ( 0, sizeof ( set ), &set ) )
+    {
+      const unsigned int numInSet = static_cast < unsigned int > ( CPU_COUNT ( &set ) );
+      num = ( ( 0 == num ) ? numInSet : std::min ( num, numInSet ) );
+    }
+
+    // The container may only be allowed some of their time.
+    try
+    {
+      const unsigned int numInQuota = Details::getNumFromCgroup();
+      if ( numInQuota > 0 )
+      {
+        num = ( ( 0 == num ) ? numInQuota : std::min ( num, numInQuota ) );
+      }
+    }
+    catch ( ... )
+    {
+      // A file that does not parse means there is no quota we can use.
+    }
+
+  #endif
+
+  return std::max ( 1u, num );
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Return the number of NUMA nodes.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+unsigned int Processors::getNumNodes()
+{
+  #ifdef __linux__
+
+    // The nodes are numbered from zero, but there can be gaps.
+    try
+    {
+      Indices nodes;
+      if ( ( true == Details::readList ( "/sys/devices/system/node/online", nodes ) ) && ( false == nodes.empty() ) )
+      {
+        return ( *std::max_element ( nodes.begin(), nodes.end() ) + 1 );
+      }
+    }
+    catch ( ... )
+    {
+      // A file that does not parse means we do not know about the nodes.
+    }
+
+  #endif
+
+  return 1;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Return the processors of the node that the calling thread can run on.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+Processors::Indices Processors::getNodeProcessors ( unsigned int node )
+{
+  const Indices available = Processors::getAvailable();
+
+  #ifdef __linux__
+
+    try
+    {
+      Indices indices;
+      std::ostringstream file;
+      file << "/sys/devices/system/node/node" << node << "/cpulist";
+      if ( true == Details::readList ( file.str(), indices ) )
+      {
+        Indices both;
+        for ( auto i = indices.begin(); i != indices.end(); ++i )
+        {
+          if ( available.end() != std::find ( available.begin(), available.end(), *i ) )
+          {
+            both.push_back ( *i );
+          }
+        }
+        return both;
+      }
+    }
+    catch ( ... )
+    {
+      // A file that does not parse means we do not know about the nodes.
+    }
+
+  #endif
+
+  // Without NUMA the only node has all of them.
+  return ( ( 0 == node ) ? available : Indices() );
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Return the processor time used by the calling thread in microseconds.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+std::uint64_t Processors::getThreadTime()
+{
+  #ifdef _WIN32
+
+    // These are in units of 100 nanoseconds.
+    FILETIME created, exited, kernel, user;
+    if ( FALSE == ::GetThreadTimes ( ::GetCurrentThread(), &created, &exited, &kernel, &user ) )
+    {
+      return 0;
+    }
+    const std::uint64_t k = ( static_cast < std::uint64_t > ( kernel.dwHighDateTime ) << 32 ) | kernel.dwLowDateTime;
+    const std::uint64_t u = ( static_cast < std::uint64_t > ( user.dwHighDateTime ) << 32 ) | user.dwLowDateTime;
+    return ( ( k + u ) / 10 );
+
+  #else
+
+    struct timespec t;
+    if ( 0 != ::clock_gettime ( CLOCK_THREAD_CPUTIME_ID, &t ) )
+    {
+      return 0;
+    }
+    return ( static_cast < std::uint64_t > ( t.tv_sec ) * 1000000 + static_cast < std::uint64_t > ( t.tv_nsec ) / 1000 );
+
+  #endif
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Make the calling thread only run on the given processors.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+bool Processors::setThreadAffinity ( const Indices &indices )
+{
+  if ( true == indices.empty() )
+  {
+    return false;
+  }
+
+  #if defined ( __linux__ )
+
+    cpu_set_t set;
+    CPU_ZERO ( &set );
+    for ( auto i = indices.begin(); i != indices.end(); ++i )
+    {
+      if ( *i < CPU_SETSIZE )
+      {
+        CPU_SET ( *i, &set );
+      }
+    }
+    return ( 0 == ::pthread_setaffinity_np ( ::pthread_self(), sizeof ( set ), &set ) );
+
+  #elif defined ( _WIN32 )
+
+    // Only the first group of 64 processors.
+    DWORD_PTR mask = 0;
+    for ( auto i = indices.begin(); i != indices.end(); ++i )
+    {
+      if ( *i < 64 )
+      {
+        mask |= ( static_cast < DWORD_PTR > ( 1 ) << *i );
+      }
+    }
+    return ( ( 0 != mask ) && ( 0 != ::SetThreadAffinityMask ( ::GetCurrentThread(), mask ) ) );
+
+  #else
+
+    return false;
+
+  #endif
+}
+
+
+} // namespace System
+} // namespace Usul
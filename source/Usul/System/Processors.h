@@ -0,0 +1,64 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Copyright (c) 2020, Perry L Miller IV
+//  All rights reserved.
+//  MIT License: https://opensource.org/licenses/mit-license.html
+//
+///////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Functions for the processors that this process can use.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef _USUL_SYSTEM_PROCESSORS_H_
+#define _USUL_SYSTEM_PROCESSORS_H_
+
+#include "Usul/Export.h"
+
+#include <cstdint>
+#include <vector>
+
+
+namespace Usul {
+namespace System {
+
+
+struct USUL_EXPORT Processors
+{
+  typedef std::vector < unsigned int > Indices;
+
+  // Return the processors that the calling thread can run on.
+  static Indices getAvailable();
+
+  // Return the number of processors that this process can use. On Linux
+  // this is the smallest of the hardware threads, the processors in the
+  // affinity mask, and the CPU quotas of the process's cgroup and its
+  // parents rounded up, so that it's right in a container. Both cgroup
+  // versions are read. Always returns at least one. It reads files, so
+  // do not call it often.
+  static unsigned int getNumAvailable();
+
+  // Return the number of NUMA nodes, and the processors of the given node
+  // that the calling thread can run on. Memory is usually placed on the
+  // node of the thread that first touches it. Without NUMA there is one
+  // node with all the processors.
+  static unsigned int getNumNodes();
+  static Indices      getNodeProcessors ( unsigned int node );
+
+  // Return the processor time used by the calling thread in microseconds,
+  // or zero if it can not be found.
+  static std::uint64_t getThreadTime();
+
+  // Make the calling thread only run on the given processors. Returns false
+  // if it can not, or if there are none.
+  static bool setThreadAffinity ( const Indices & );
+};
+
+
+} // namespace System
+} // namespace Usul
+
+
+#endif // _USUL_SYSTEM_PROCESSORS_H_
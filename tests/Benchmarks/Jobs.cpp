@@ -0,0 +1,604 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Copyright (c) 2020, Perry L Miller IV
+//  All rights reserved.
+//  MIT License: https://opensource.org/licenses/mit-license.html
+//
+////////////////////////////////////////////////////////////////////////////////
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Benchmark the job manager. The results are written as JSON so that runs
+//  before and after a change can be compared by a script.
+//
+//  usul_bench_jobs [--threads n] [--jobs n] [--samples n] [--producers n]
+//                  [--depth n] [--output file]
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "Usul/Jobs/Histogram.h"
+#include "Usul/Jobs/Manager.h"
+#include "Usul/System/Processors.h"
+#include "Usul/Version.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Count the heap allocations in the whole program.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+namespace Details
+{
+  std::atomic < unsigned long > numAllocations ( 0 );
+}
+
+void *operator new ( std::size_t size )
+{
+  Details::numAllocations.fetch_add ( 1, std::memory_order_relaxed );
+  void *p = std::malloc ( ( 0 == size ) ? 1 : size );
+  if ( nullptr == p )
+  {
+    throw std::bad_alloc();
+  }
+  return p;
+}
+void operator delete ( void *p ) noexcept
+{
+  std::free ( p );
+}
+void operator delete ( void *p, std::size_t ) noexcept
+{
+  std::free ( p );
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Helper types and functions.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+namespace Details
+{
+  typedef Usul::Jobs::Manager Manager;
+  typedef Manager::JobPtr JobPtr;
+  typedef Usul::Jobs::Histogram Histogram;
+  typedef Usul::Jobs::AtomicHistogram AtomicHistogram;
+  typedef std::chrono::steady_clock Clock;
+  typedef std::chrono::nanoseconds Nanoseconds;
+  typedef std::atomic < unsigned int > AtomicUnsignedInt;
+  typedef std::map < std::string, unsigned int > Options;
+
+  // Return the nanoseconds between the two times.
+  inline Histogram::Value nanoseconds ( Clock::time_point start, Clock::time_point finish )
+  {
+    const Nanoseconds::rep ns = std::chrono::duration_cast < Nanoseconds > ( finish - start ).count();
+    return static_cast < Histogram::Value > ( ( ns > 0 ) ? ns : 0 );
+  }
+
+  // Return the seconds since the start.
+  inline double secondsSince ( Clock::time_point start )
+  {
+    return std::chrono::duration < double > ( Clock::now() - start ).count();
+  }
+
+  // Return the number per second.
+  inline double perSecond ( unsigned int num, double seconds )
+  {
+    return ( ( seconds > 0 ) ? ( static_cast < double > ( num ) / seconds ) : 0.0 );
+  }
+
+  // Return the names of the settings.
+  inline const char *getName ( Manager::ThreadModel model )
+  {
+    return ( ( Manager::THREAD_POOL == model ) ? "thread pool" : "thread per job" );
+  }
+  inline const char *getName ( Manager::WakeModel model )
+  {
+    return ( ( Manager::WAKE_BY_POLLING == model ) ? "polling" : "events" );
+  }
+  inline const char *getName ( Manager::Scheduler scheduler )
+  {
+    return ( ( Manager::SCHEDULER_WORK_STEALING == scheduler ) ? "work stealing" : "shared queue" );
+  }
+
+  // Write the histogram of nanoseconds.
+  inline void write ( std::ostream &out, const Histogram &h )
+  {
+    out << "{\"count\":" << h.getCount()
+        << ",\"mean_ns\":" << h.getMean()
+        << ",\"min_ns\":" << h.getMin()
+        << ",\"p50_ns\":" << h.getPercentile ( 0.50 )
+        << ",\"p90_ns\":" << h.getPercentile ( 0.90 )
+        << ",\"p99_ns\":" << h.getPercentile ( 0.99 )
+        << ",\"max_ns\":" << h.getMax() << "}";
+  }
+
+  // Write the separator before all but the first item.
+  inline void separate ( std::ostream &out, bool &first )
+  {
+    out << ( ( true == first ) ? "\n    " : ",\n    " );
+    first = false;
+  }
+
+  // Make a manager with the number of threads and the settings.
+  typedef std::unique_ptr < Manager > ManagerPtr;
+  inline ManagerPtr makeManager ( unsigned int numThreads, Manager::ThreadModel model, Manager::WakeModel wake, Manager::Scheduler scheduler )
+  {
+    ManagerPtr manager ( new Manager() );
+    manager->setMaxNumThreadsAllowed ( numThreads );
+    manager->setNumMillisecondsToSleep ( 1 );
+    manager->setThreadModel ( model );
+    manager->setWakeModel ( wake );
+    manager->setScheduler ( scheduler );
+    return manager;
+  }
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  How many empty jobs per second, added one at a time and in one batch.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void benchmarkThroughput ( std::ostream &out, const Details::Options &options )
+{
+  typedef Details::Manager Manager;
+
+  const Manager::ThreadModel models[] = { Manager::THREAD_PER_JOB, Manager::THREAD_POOL };
+  const Manager::Scheduler schedulers[] = { Manager::SCHEDULER_SHARED_QUEUE, Manager::SCHEDULER_WORK_STEALING };
+
+  out << "  \"throughput\": [";
+  bool first = true;
+
+  for ( Manager::ThreadModel model : models )
+  {
+    for ( Manager::Scheduler scheduler : schedulers )
+    {
+      // The scheduler only matters to the pool.
+      if ( ( Manager::THREAD_PER_JOB == model ) && ( Manager::SCHEDULER_WORK_STEALING == scheduler ) )
+      {
+        continue;
+      }
+
+      for ( unsigned int batch = 0; batch < 2; ++batch )
+      {
+        Details::ManagerPtr manager = Details::makeManager ( options.at ( "threads" ), model, Manager::WAKE_ON_EVENTS, scheduler );
+
+        // A thread for every job is slow, so it gets fewer of them.
+        const unsigned int numJobs = ( ( Manager::THREAD_PER_JOB == model ) ? std::max ( 1u, options.at ( "jobs" ) / 10 ) : options.at ( "jobs" ) );
+
+        Details::AtomicUnsignedInt count ( 0 );
+        const Manager::Callback cb = [ &count ] ( Details::JobPtr )
+        {
+          ++count;
+        };
+
+        const Details::Clock::time_point start = Details::Clock::now();
+        if ( 1 == batch )
+        {
+          manager->addJobs ( Manager::Callbacks ( numJobs, cb ) );
+        }
+        else
+        {
+          for ( unsigned int i = 0; i < numJobs; ++i )
+          {
+            manager->addJob ( cb );
+          }
+        }
+        manager->waitAll();
+        const double seconds = Details::secondsSince ( start );
+
+        if ( numJobs != count )
+        {
+          throw std::runtime_error ( "Not all of the jobs ran" );
+        }
+
+        Details::separate ( out, first );
+        out << "{\"thread_model\":\"" << Details::getName ( model )
+            << "\",\"scheduler\":\"" << Details::getName ( scheduler )
+            << "\",\"batch\":" << ( ( 1 == batch ) ? "true" : "false" )
+            << ",\"jobs\":" << numJobs
+            << ",\"seconds\":" << seconds
+            << ",\"jobs_per_second\":" << Details::perSecond ( numJobs, seconds ) << "}";
+      }
+    }
+  }
+
+  out << "\n  ]";
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  How long from adding a job to when it starts, and from when the last job
+//  finishes to when waitAll() returns. The jobs are added one at a time to
+//  an idle manager, so this is mostly the time it takes to wake a thread.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void benchmarkLatency ( std::ostream &out, const Details::Options &options )
+{
+  typedef Details::Manager Manager;
+  typedef std::atomic < Details::Clock::rep > AtomicRep;
+
+  const Manager::ThreadModel models[] = { Manager::THREAD_PER_JOB, Manager::THREAD_POOL };
+  const Manager::WakeModel wakes[] = { Manager::WAKE_ON_EVENTS, Manager::WAKE_BY_POLLING };
+
+  out << "  \"latency\": [";
+  bool first = true;
+
+  for ( Manager::ThreadModel model : models )
+  {
+    for ( Manager::WakeModel wake : wakes )
+    {
+      Details::ManagerPtr manager = Details::makeManager ( options.at ( "threads" ), model, wake, Manager::SCHEDULER_SHARED_QUEUE );
+
+      Details::Histogram submitToStart;
+      Details::Histogram waitAllWakeup;
+
+      const unsigned int numSamples = options.at ( "samples" );
+      for ( unsigned int i = 0; i < numSamples; ++i )
+      {
+        AtomicRep started ( 0 );
+        AtomicRep finished ( 0 );
+
+        const Details::Clock::time_point added = Details::Clock::now();
+        manager->addJob ( [ &started, &finished ] ( Details::JobPtr )
+        {
+          started = Details::Clock::now().time_since_epoch().count();
+          finished = Details::Clock::now().time_since_epoch().count();
+        } );
+        manager->waitAll();
+        const Details::Clock::time_point returned = Details::Clock::now();
+
+        submitToStart.add ( Details::nanoseconds ( added, Details::Clock::time_point ( Details::Clock::duration ( started.load() ) ) ) );
+        waitAllWakeup.add ( Details::nanoseconds ( Details::Clock::time_point ( Details::Clock::duration ( finished.load() ) ), returned ) );
+      }
+
+      Details::separate ( out, first );
+      out << "{\"thread_model\":\"" << Details::getName ( model )
+          << "\",\"wake_model\":\"" << Details::getName ( wake )
+          << "\",\"submit_to_start\":";
+      Details::write ( out, submitToStart );
+      out << ",\"wait_all_wakeup\":";
+      Details::write ( out, waitAllWakeup );
+      out << "}";
+    }
+  }
+
+  out << "\n  ]";
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  How the time to add a job and the number of jobs per second change with
+//  the number of threads adding them. They go 1, 2, 4, ... up to the most.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void benchmarkProducers ( std::ostream &out, const Details::Options &options )
+{
+  typedef Details::Manager Manager;
+
+  std::vector < unsigned int > numProducers;
+  const unsigned int maxNumProducers = std::max ( 1u, options.at ( "producers" ) );
+  for ( unsigned int num = 1; num < maxNumProducers; num *= 2 )
+  {
+    numProducers.push_back ( num );
+  }
+  numProducers.push_back ( maxNumProducers );
+
+  out << "  \"producers\": [";
+  bool first = true;
+
+  for ( unsigned int numThreads : numProducers )
+  {
+    Details::ManagerPtr manager = Details::makeManager ( options.at ( "threads" ), Manager::THREAD_POOL, Manager::WAKE_ON_EVENTS, Manager::SCHEDULER_SHARED_QUEUE );
+
+    const unsigned int numJobsEach = std::max ( 1u, options.at ( "jobs" ) / numThreads );
+    const unsigned int numJobs = numJobsEach * numThreads;
+
+    Details::AtomicUnsignedInt count ( 0 );
+    Details::AtomicHistogram addTimes;
+
+    const Details::Clock::time_point start = Details::Clock::now();
+
+    std::vector < std::thread > producers;
+    for ( unsigned int i = 0; i < numThreads; ++i )
+    {
+      producers.emplace_back ( [ &manager, &count, &addTimes, numJobsEach ] ()
+      {
+        for ( unsigned int j = 0; j < numJobsEach; ++j )
+        {
+          const Details::Clock::time_point before = Details::Clock::now();
+          manager->addJob ( [ &count ] ( Details::JobPtr ) { ++count; } );
+          addTimes.add ( Details::nanoseconds ( before, Details::Clock::now() ) );
+        }
+      } );
+    }
+    for ( auto i = producers.begin(); i != producers.end(); ++i )
+    {
+      i->join();
+    }
+
+    manager->waitAll();
+    const double seconds = Details::secondsSince ( start );
+
+    if ( numJobs != count )
+    {
+      throw std::runtime_error ( "Not all of the jobs ran" );
+    }
+
+    Details::separate ( out, first );
+    out << "{\"producers\":" << numThreads
+        << ",\"jobs\":" << numJobs
+        << ",\"seconds\":" << seconds
+        << ",\"jobs_per_second\":" << Details::perSecond ( numJobs, seconds )
+        << ",\"add_job\":";
+    Details::write ( out, addTimes.get() );
+    out << "}";
+  }
+
+  out << "\n  ]";
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  How the time of a recursive fork/join changes with its depth. Each job
+//  adds two more until the depth is reached, so there are 2^(d+1) - 1 jobs.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void benchmarkForkJoin ( std::ostream &out, const Details::Options &options )
+{
+  typedef Details::Manager Manager;
+  typedef std::function < void ( unsigned int ) > Split;
+
+  const Manager::Scheduler schedulers[] = { Manager::SCHEDULER_SHARED_QUEUE, Manager::SCHEDULER_WORK_STEALING };
+
+  out << "  \"fork_join\": [";
+  bool first = true;
+
+  for ( Manager::Scheduler scheduler : schedulers )
+  {
+    Details::ManagerPtr manager = Details::makeManager ( options.at ( "threads" ), Manager::THREAD_POOL, Manager::WAKE_ON_EVENTS, scheduler );
+    Manager &m = *manager;
+
+    for ( unsigned int depth = 1; depth <= options.at ( "depth" ); ++depth )
+    {
+      Details::AtomicUnsignedInt numLeaves ( 0 );
+      Split split;
+      split = [ &m, &numLeaves, &split, depth ] ( unsigned int level )
+      {
+        if ( level == depth )
+        {
+          ++numLeaves;
+          return;
+        }
+
+        m.addJob ( [ &split, level ] ( Details::JobPtr ) { split ( level + 1 ); } );
+        m.addJob ( [ &split, level ] ( Details::JobPtr ) { split ( level + 1 ); } );
+      };
+
+      const Details::Clock::time_point start = Details::Clock::now();
+      m.addJob ( [ &split ] ( Details::JobPtr ) { split ( 0 ); } );
+      m.waitAll();
+      const double seconds = Details::secondsSince ( start );
+
+      if ( ( 1u << depth ) != numLeaves )
+      {
+        throw std::runtime_error ( "Not all of the leaves were reached" );
+      }
+
+      const unsigned int numJobs = ( 2u << depth ) - 1;
+
+      Details::separate ( out, first );
+      out << "{\"scheduler\":\"" << Details::getName ( scheduler )
+          << "\",\"depth\":" << depth
+          << ",\"jobs\":" << numJobs
+          << ",\"seconds\":" << seconds
+          << ",\"jobs_per_second\":" << Details::perSecond ( numJobs, seconds ) << "}";
+    }
+  }
+
+  out << "\n  ]";
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  How many heap allocations there are per submitted job, once the job
+//  allocator has enough blocks. It should be close to zero.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void benchmarkAllocations ( std::ostream &out, const Details::Options &options )
+{
+  typedef Details::Manager Manager;
+
+  const Manager::Scheduler schedulers[] = { Manager::SCHEDULER_SHARED_QUEUE, Manager::SCHEDULER_WORK_STEALING };
+
+  out << "  \"allocations\": [";
+  bool first = true;
+
+  for ( Manager::Scheduler scheduler : schedulers )
+  {
+    Details::ManagerPtr manager = Details::makeManager ( options.at ( "threads" ), Manager::THREAD_POOL, Manager::WAKE_ON_EVENTS, scheduler );
+
+    const unsigned int numJobs = options.at ( "jobs" );
+    Details::AtomicUnsignedInt count ( 0 );
+
+    auto run = [ &manager, &count, numJobs ] ()
+    {
+      for ( unsigned int i = 0; i < numJobs; ++i )
+      {
+        manager->submit ( [ &count ] () { ++count; } );
+      }
+      manager->waitAll();
+    };
+
+    // Each thread keeps some of the blocks it frees before it shares them,
+    // so the first few times fill the pool and grow the containers.
+    run();
+    run();
+    run();
+
+    const unsigned long before = Details::numAllocations;
+    run();
+    const unsigned long numAllocations = Details::numAllocations - before;
+
+    if ( ( 4 * numJobs ) != count )
+    {
+      throw std::runtime_error ( "Not all of the jobs ran" );
+    }
+
+    Details::separate ( out, first );
+    out << "{\"scheduler\":\"" << Details::getName ( scheduler )
+        << "\",\"jobs\":" << numJobs
+        << ",\"heap_allocations\":" << numAllocations
+        << ",\"heap_allocations_per_job\":" << ( static_cast < double > ( numAllocations ) / numJobs ) << "}";
+  }
+
+  out << "\n  ]";
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Run the benchmarks and write the results.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void run ( std::ostream &out, const Details::Options &options )
+{
+  out << "{\n";
+  out << "  \"version\": \"" << Usul::Version::STRING << "\",\n";
+  out << "  \"processors\": " << Usul::System::Processors::getNumAvailable() << ",\n";
+  out << "  \"options\": {";
+  for ( auto i = options.begin(); i != options.end(); ++i )
+  {
+    out << ( ( options.begin() == i ) ? "" : ", " ) << '"' << i->first << "\": " << i->second;
+  }
+  out << "},\n";
+
+  benchmarkThroughput ( out, options );
+  out << ",\n";
+  benchmarkLatency ( out, options );
+  out << ",\n";
+  benchmarkProducers ( out, options );
+  out << ",\n";
+  benchmarkForkJoin ( out, options );
+  out << ",\n";
+  benchmarkAllocations ( out, options );
+  out << "\n}\n";
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Main function.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+int main ( int argc, char **argv )
+{
+  const std::string usage ( "Usage: usul_bench_jobs [--threads n] [--jobs n] [--samples n] [--producers n] [--depth n] [--output file]" );
+
+  try
+  {
+    const unsigned int numProcessors = Usul::System::Processors::getNumAvailable();
+
+    Details::Options options;
+    options["threads"] = numProcessors;
+    options["jobs"] = 100000;
+    options["samples"] = 1000;
+    options["producers"] = 2 * numProcessors;
+    options["depth"] = 16;
+
+    std::string output;
+
+    for ( int i = 1; i < argc; ++i )
+    {
+      const std::string arg ( argv[i] );
+      if ( ( "--help" == arg ) || ( "-h" == arg ) )
+      {
+        std::cout << usage << std::endl;
+        return 0;
+      }
+
+      if ( ( arg.size() < 3 ) || ( 0 != arg.compare ( 0, 2, "--" ) ) || ( i + 1 >= argc ) )
+      {
+        throw std::invalid_argument ( "Invalid argument '" + arg + "'" );
+      }
+
+      const std::string name ( arg.substr ( 2 ) );
+      const std::string value ( argv[++i] );
+
+      if ( "output" == name )
+      {
+        output = value;
+      }
+      else if ( options.end() != options.find ( name ) )
+      {
+        const unsigned long num = std::stoul ( value );
+        if ( ( 0 == num ) || ( num > 1000000000ul ) || ( ( "depth" == name ) && ( num > 24 ) ) )
+        {
+          throw std::out_of_range ( "Value of '" + arg + "' is out of range" );
+        }
+        options[name] = static_cast < unsigned int > ( num );
+      }
+      else
+      {
+        throw std::invalid_argument ( "Unknown option '" + arg + "'" );
+      }
+    }
+
+    if ( true == output.empty() )
+    {
+      run ( std::cout, options );
+    }
+    else
+    {
+      std::ofstream out ( output.c_str() );
+      if ( false == out.is_open() )
+      {
+        throw std::runtime_error ( "Failed to open file '" + output + "'" );
+      }
+      run ( out, options );
+    }
+
+    return 0;
+  }
+
+  catch ( const std::exception &e )
+  {
+    std::cerr << "Standard exception caught: " << e.what() << '\n' << usage << std::endl;
+  }
+
+  catch ( ... )
+  {
+    std::cerr << "Unknown exception caught" << std::endl;
+  }
+
+  return 1;
+}
@@ -0,0 +1,95 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Copyright (c) 2020, Perry L Miller IV
+//  All rights reserved.
+//  MIT License: https://opensource.org/licenses/mit-license.html
+//
+////////////////////////////////////////////////////////////////////////////////
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Test the sphere sub-division functions.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "Usul/Algorithms/Sphere.h"
+#include "Usul/Algorithms/SphereJobs.h"
+#include "Usul/Jobs/Manager.h"
+
+#include "catch2/catch.hpp"
+
+#include <array>
+#include <atomic>
+#include <stdexcept>
+#include <vector>
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Test the sphere sub-division functions.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+TEMPLATE_TEST_CASE ( "Functions for sphere sub-division", "",
+  float, double )
+{
+  namespace Sphere = Usul::Algorithms::Sphere;
+  typedef std::array < TestType, 9 > Triangle;
+  typedef std::vector < Triangle > Triangles;
+
+  // Put each triangle where its first index says, so that the parallel
+  // version does not need a lock. The indices are checked after, because
+  // the jobs can not use the test macros.
+  std::atomic < bool > consecutive ( true );
+  auto make = [ &consecutive ] ( Triangles &triangles )
+  {
+    return [ &triangles, &consecutive ] (
+      TestType x1, TestType y1, TestType z1,
+      TestType x2, TestType y2, TestType z2,
+      TestType x3, TestType y3, TestType z3,
+      unsigned int i1, unsigned int i2, unsigned int i3 )
+    {
+      if ( ( ( i1 + 1 ) != i2 ) || ( ( i2 + 1 ) != i3 ) )
+      {
+        consecutive = false;
+      }
+      triangles.at ( i1 / 3 ) = Triangle { { x1, y1, z1, x2, y2, z2, x3, y3, z3 } };
+    };
+  };
+
+  SECTION ( "Jobs make the same triangles" )
+  {
+    Usul::Jobs::Manager manager;
+    manager.setMaxNumThreadsAllowed ( 2 );
+
+    for ( unsigned int n = 0; n < 7; ++n )
+    {
+      const std::size_t size = ( std::size_t ( 20 ) << ( 2 * n ) );
+
+      Triangles serial ( size );
+      Sphere::generate < TestType > ( n, make ( serial ) );
+
+      Triangles parallel ( size );
+      Sphere::generate < TestType > ( manager, n, make ( parallel ) );
+
+      REQUIRE ( serial == parallel );
+      REQUIRE ( true == consecutive );
+    }
+  }
+
+  SECTION ( "Errors in the jobs are thrown" )
+  {
+    Usul::Jobs::Manager manager;
+    manager.setMaxNumThreadsAllowed ( 2 );
+
+    REQUIRE_THROWS_AS ( Sphere::generate < TestType > ( manager, 6, [] (
+      TestType, TestType, TestType, TestType, TestType, TestType, TestType, TestType, TestType,
+      unsigned int i1, unsigned int, unsigned int )
+    {
+      if ( 3000 == i1 )
+      {
+        throw std::runtime_error ( "Error in the callback" );
+      }
+    } ), std::runtime_error );
+  }
+}
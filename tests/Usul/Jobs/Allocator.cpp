@@ -0,0 +1,179 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Copyright (c) 2020, Perry L Miller IV
+//  All rights reserved.
+//  MIT License: https://opensource.org/licenses/mit-license.html
+//
+////////////////////////////////////////////////////////////////////////////////
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Test the allocator for jobs, and count the heap allocations per job.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "Usul/Jobs/Allocator.h"
+#include "Usul/Jobs/Manager.h"
+
+#include "catch2/catch.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <thread>
+#include <vector>
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Count the heap allocations in the whole program.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+namespace Details
+{
+  std::atomic < unsigned long > numAllocations ( 0 );
+}
+
+void *operator new ( std::size_t size )
+{
+  ++Details::numAllocations;
+  void *p = std::malloc ( ( 0 == size ) ? 1 : size );
+  if ( nullptr == p )
+  {
+    throw std::bad_alloc();
+  }
+  return p;
+}
+void operator delete ( void *p ) noexcept
+{
+  std::free ( p );
+}
+void operator delete ( void *p, std::size_t ) noexcept
+{
+  std::free ( p );
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Test the allocator for jobs.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+TEST_CASE ( "Job allocator" )
+{
+  typedef Usul::Jobs::MemoryPool MemoryPool;
+  typedef Usul::Jobs::Manager Manager;
+
+  SECTION ( "Freed blocks are used again" )
+  {
+    void *a = MemoryPool::allocate ( 100 );
+    MemoryPool::deallocate ( a, 100 );
+
+    // The same size step gets the same block without the heap.
+    const unsigned long before = Details::numAllocations;
+    void *b = MemoryPool::allocate ( 120 );
+    REQUIRE ( ( a == b ) );
+    REQUIRE ( ( before == Details::numAllocations ) );
+    MemoryPool::deallocate ( b, 120 );
+
+    // Big ones use the heap.
+    void *c = MemoryPool::allocate ( MemoryPool::MAX_BLOCK_SIZE + 1 );
+    REQUIRE ( ( ( before + 1 ) == Details::numAllocations ) );
+    MemoryPool::deallocate ( c, MemoryPool::MAX_BLOCK_SIZE + 1 );
+  }
+
+  SECTION ( "Blocks freed by another thread are used again" )
+  {
+    const unsigned int numBlocks = 200;
+    std::vector < void * > blocks ( numBlocks, nullptr );
+    for ( unsigned int i = 0; i < numBlocks; ++i )
+    {
+      blocks[i] = MemoryPool::allocate ( 200 );
+    }
+
+    // The thread gives its blocks to the others when it ends.
+    std::thread ( [ &blocks ] ()
+    {
+      for ( auto i = blocks.begin(); i != blocks.end(); ++i )
+      {
+        MemoryPool::deallocate ( *i, 200 );
+      }
+    } ).join();
+    REQUIRE ( ( MemoryPool::getNumFreeBlocks() >= numBlocks ) );
+
+    const unsigned long before = Details::numAllocations;
+    for ( unsigned int i = 0; i < numBlocks; ++i )
+    {
+      blocks[i] = MemoryPool::allocate ( 200 );
+    }
+    REQUIRE ( ( before == Details::numAllocations ) );
+
+    for ( auto i = blocks.begin(); i != blocks.end(); ++i )
+    {
+      MemoryPool::deallocate ( *i, 200 );
+    }
+  }
+
+  SECTION ( "Over-aligned types get aligned memory" )
+  {
+    struct alignas ( 64 ) Aligned
+    {
+      char data[64];
+    };
+
+    Usul::Jobs::Allocator < Aligned > allocator;
+    std::vector < Aligned * > objects;
+    for ( unsigned int i = 0; i < 10; ++i )
+    {
+      objects.push_back ( allocator.allocate ( 1 ) );
+      REQUIRE ( ( 0 == ( reinterpret_cast < std::uintptr_t > ( objects.back() ) % alignof ( Aligned ) ) ) );
+    }
+    for ( auto i = objects.begin(); i != objects.end(); ++i )
+    {
+      allocator.deallocate ( *i, 1 );
+    }
+  }
+
+  SECTION ( "Submitting a small function rarely uses the heap" )
+  {
+    Manager manager;
+    manager.setThreadModel ( Manager::THREAD_POOL );
+
+    const Manager::Scheduler scheduler = GENERATE ( Manager::SCHEDULER_SHARED_QUEUE, Manager::SCHEDULER_WORK_STEALING );
+    manager.setScheduler ( scheduler );
+
+    std::atomic < unsigned int > count ( 0 );
+    const unsigned int numJobs = 1000;
+
+    auto run = [ & ] ()
+    {
+      for ( unsigned int i = 0; i < numJobs; ++i )
+      {
+        manager.submit ( [ &count ] () { ++count; } );
+      }
+      manager.waitAll();
+    };
+
+    // Each thread keeps some of the blocks it frees before it shares them,
+    // so the first few times fill the pool and grow the containers.
+    run();
+    run();
+    run();
+
+    // After that, the pool may need another block if more jobs are alive at
+    // once than before, but that should be rare.
+    const unsigned int numRuns = 10;
+    const unsigned long before = Details::numAllocations;
+    for ( unsigned int i = 0; i < numRuns; ++i )
+    {
+      run();
+    }
+    const unsigned long numAllocations = Details::numAllocations - before;
+
+    REQUIRE ( ( ( ( 3 + numRuns ) * numJobs ) == count ) );
+    REQUIRE ( ( ( 100 * numAllocations ) < ( numRuns * numJobs ) ) );
+  }
+}
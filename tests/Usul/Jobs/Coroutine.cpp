@@ -0,0 +1,159 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Copyright (c) 2020, Perry L Miller IV
+//  All rights reserved.
+//  MIT License: https://opensource.org/licenses/mit-license.html
+//
+////////////////////////////////////////////////////////////////////////////////
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Test the coroutines that run on the job manager.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "Usul/Jobs/Manager.h"
+
+#ifdef USUL_HAS_COROUTINES
+
+#include "catch2/catch.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Coroutines used below.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+namespace Details
+{
+  typedef Usul::Jobs::Manager Manager;
+  template < class R > using Future = Usul::Jobs::Future < R >;
+
+  // Return the thread that it runs on after the first co_await.
+  inline Future < std::thread::id > getPoolThreadID ( Manager &manager )
+  {
+    co_await manager.schedule();
+    co_return std::this_thread::get_id();
+  }
+
+  // Pretend to read a file on a thread in the pool.
+  inline Future < std::string > readFile ( Manager &manager, std::string name )
+  {
+    co_await manager.schedule();
+    std::this_thread::sleep_for ( std::chrono::milliseconds ( 1 ) );
+    co_return ( "contents of " + name );
+  }
+
+  // Read the file and return its size.
+  inline Future < std::size_t > getFileSize ( Manager &manager, std::string name )
+  {
+    const std::string contents = co_await readFile ( manager, name );
+    co_return contents.size();
+  }
+
+  // Throws after the first co_await.
+  inline Future < void > throwSomething ( Manager &manager )
+  {
+    co_await manager.schedule();
+    throw std::runtime_error ( "Something" );
+  }
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Test the coroutines that run on the job manager.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+TEST_CASE ( "Job coroutines" )
+{
+  typedef Usul::Jobs::Manager Manager;
+
+  Manager manager;
+
+  // One thread shows that waiting for a future does not block it.
+  manager.setMaxNumThreadsAllowed ( 1 );
+
+  SECTION ( "Move to a thread in the pool" )
+  {
+    REQUIRE ( ( std::this_thread::get_id() != Details::getPoolThreadID ( manager ).get() ) );
+  }
+
+  SECTION ( "Wait for other coroutines without blocking the thread" )
+  {
+    std::vector < Details::Future < std::size_t > > sizes;
+    for ( unsigned int i = 0; i < 10; ++i )
+    {
+      sizes.push_back ( Details::getFileSize ( manager, "file" + std::to_string ( i ) ) );
+    }
+
+    for ( auto i = sizes.begin(); i != sizes.end(); ++i )
+    {
+      REQUIRE ( ( std::string ( "contents of file0" ).size() == i->get() ) );
+    }
+  }
+
+  SECTION ( "Wait for a future in a coroutine that runs in the pool" )
+  {
+    // With one thread, this would never finish if the thread waited.
+    auto outer = [] ( Manager &m ) -> Details::Future < int >
+    {
+      co_await m.schedule();
+      const int inner = co_await m.submit ( [] () { return 20; } );
+      co_return inner + 1;
+    };
+    REQUIRE ( ( 21 == outer ( manager ).get() ) );
+  }
+
+  SECTION ( "Exceptions go to the future" )
+  {
+    auto f = Details::throwSomething ( manager );
+    REQUIRE_THROWS_AS ( f.get(), std::runtime_error );
+
+    // Also when waiting for a future that throws.
+    auto g = [] ( Manager &m ) -> Details::Future < int >
+    {
+      co_return co_await m.submit ( [] () -> int { throw std::runtime_error ( "No value" ); } );
+    };
+    REQUIRE_THROWS_AS ( g ( manager ).get(), std::runtime_error );
+  }
+
+  SECTION ( "A coroutine whose job is cleared still finishes" )
+  {
+    // This job keeps the only thread busy.
+    std::atomic < bool > finish ( false );
+    manager.addJob ( [ &finish ] ( Manager::JobPtr )
+    {
+      while ( false == finish )
+      {
+        std::this_thread::sleep_for ( std::chrono::milliseconds ( 1 ) );
+      }
+    } );
+    while ( 0 == manager.getNumJobsRunning() )
+    {
+      std::this_thread::yield();
+    }
+
+    auto f = Details::getPoolThreadID ( manager );
+    REQUIRE ( ( false == f.isReady() ) );
+
+    manager.clearQueuedJobs();
+    REQUIRE ( ( true == f.isReady() ) );
+    REQUIRE_THROWS_AS ( f.get(), std::runtime_error );
+
+    finish = true;
+    manager.waitAll();
+  }
+}
+
+
+#endif // USUL_HAS_COROUTINES
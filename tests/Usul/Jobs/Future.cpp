@@ -0,0 +1,167 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Copyright (c) 2020, Perry L Miller IV
+//  All rights reserved.
+//  MIT License: https://opensource.org/licenses/mit-license.html
+//
+////////////////////////////////////////////////////////////////////////////////
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Test the jobs that return values.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "Usul/Jobs/Future.h"
+
+#include "catch2/catch.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Test the jobs that return values.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+TEST_CASE ( "Job futures" )
+{
+  typedef Usul::Jobs::Manager Manager;
+
+  Manager manager;
+  manager.setMaxNumThreadsAllowed ( 4 );
+
+  // Run all the sections with both thread models.
+  const Manager::ThreadModel model = GENERATE ( Manager::THREAD_PER_JOB, Manager::THREAD_POOL );
+  manager.setThreadModel ( model );
+
+  SECTION ( "Get the value" )
+  {
+    Usul::Jobs::Future < int > f = manager.submit ( [] () { return 42; } );
+    REQUIRE ( ( true == f.valid() ) );
+    REQUIRE ( ( 42 == f.get() ) );
+    REQUIRE ( ( true == f.isReady() ) );
+
+    // It can be called again.
+    REQUIRE ( ( 42 == f.get() ) );
+  }
+
+  SECTION ( "Functions that return nothing" )
+  {
+    std::atomic < bool > ran ( false );
+    Usul::Jobs::Future < void > f = manager.submit ( [ &ran ] () { ran = true; } );
+    f.get();
+    REQUIRE ( ( true == ran ) );
+  }
+
+  SECTION ( "Values that can only be moved" )
+  {
+    auto f = manager.submit ( [] () { return std::unique_ptr < std::string > ( new std::string ( "hello" ) ); } );
+    REQUIRE ( ( "hello" == *f.get() ) );
+  }
+
+  SECTION ( "The exception is thrown by get()" )
+  {
+    // The error handler does not get the exception.
+    std::atomic < unsigned int > numErrors ( 0 );
+    manager.setErrorHandler ( [ &numErrors ] ( Manager::JobPtr, const std::exception & )
+    {
+      ++numErrors;
+    } );
+
+    auto f = manager.submit ( [] () -> int { throw std::runtime_error ( "No value" ); } );
+    f.wait();
+    REQUIRE ( ( true == f.isReady() ) );
+    REQUIRE_THROWS_WITH ( f.get(), "No value" );
+
+    manager.waitAll();
+    REQUIRE ( ( 0 == numErrors ) );
+  }
+
+  SECTION ( "An empty future throws" )
+  {
+    Usul::Jobs::Future < int > f;
+    REQUIRE ( ( false == f.valid() ) );
+    REQUIRE_THROWS ( f.get() );
+  }
+
+  SECTION ( "Continuations run when the job is done" )
+  {
+    std::atomic < bool > finish ( false );
+    auto f1 = manager.submit ( [ &finish ] ()
+    {
+      while ( false == finish )
+      {
+        std::this_thread::sleep_for ( std::chrono::milliseconds ( 1 ) );
+      }
+      return 2;
+    } );
+
+    auto f2 = f1.then ( [] ( const Usul::Jobs::Future < int > &f ) { return f.get() * 10; } );
+    auto f3 = f2.then ( [] ( const Usul::Jobs::Future < int > &f ) { return std::to_string ( f.get() ); } );
+
+    // Nothing is done yet but all of them are counted.
+    REQUIRE ( ( false == f3.waitFor ( 10 ) ) );
+    REQUIRE ( ( 3 == manager.getNumJobs() ) );
+
+    finish = true;
+    REQUIRE ( ( "20" == f3.get() ) );
+
+    // Add one to a job that is already done.
+    auto f4 = f1.then ( [] ( const Usul::Jobs::Future < int > &f ) { return f.get() + 1; } );
+    REQUIRE ( ( 3 == f4.get() ) );
+
+    // This waits for the continuations too.
+    manager.waitAll();
+    REQUIRE ( ( 0 == manager.getNumJobs() ) );
+  }
+
+  SECTION ( "Exceptions go to the continuation" )
+  {
+    auto f1 = manager.submit ( [] () -> int { throw std::runtime_error ( "First" ); } );
+    auto f2 = f1.then ( [] ( const Usul::Jobs::Future < int > &f )
+    {
+      try
+      {
+        return f.get();
+      }
+      catch ( const std::exception &e )
+      {
+        return static_cast < int > ( std::string ( e.what() ).size() );
+      }
+    } );
+    REQUIRE ( ( 5 == f2.get() ) );
+  }
+
+  SECTION ( "Cleared jobs and their continuations are done without values" )
+  {
+    // Keep the threads busy so that the next jobs stay queued.
+    std::atomic < bool > finish ( false );
+    for ( unsigned int i = 0; i < manager.getMaxNumThreadsAllowed(); ++i )
+    {
+      manager.addJob ( [ &finish ] ( Manager::JobPtr )
+      {
+        while ( false == finish )
+        {
+          std::this_thread::sleep_for ( std::chrono::milliseconds ( 1 ) );
+        }
+      } );
+    }
+
+    auto f1 = manager.submit ( [] () { return 1; } );
+    auto f2 = f1.then ( [] ( const Usul::Jobs::Future < int > &f ) { return f.get(); } );
+
+    manager.reset();
+    finish = true;
+
+    REQUIRE_THROWS ( f1.get() );
+    REQUIRE_THROWS ( f2.get() );
+    REQUIRE ( ( 0 == manager.getNumJobs() ) );
+  }
+}
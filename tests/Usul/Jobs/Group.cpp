@@ -0,0 +1,222 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Copyright (c) 2020, Perry L Miller IV
+//  All rights reserved.
+//  MIT License: https://opensource.org/licenses/mit-license.html
+//
+////////////////////////////////////////////////////////////////////////////////
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Test the groups of jobs.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "Usul/Jobs/Manager.h"
+
+#include "catch2/catch.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Test the groups of jobs.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+TEST_CASE ( "Job groups" )
+{
+  typedef Usul::Jobs::Manager Manager;
+  typedef Usul::Jobs::Group Group;
+  typedef Usul::Jobs::Job Job;
+
+  Manager manager;
+
+  // Run all the sections with both thread models.
+  const Manager::ThreadModel model = GENERATE ( Manager::THREAD_PER_JOB, Manager::THREAD_POOL );
+  manager.setThreadModel ( model );
+
+  // One thread so that the jobs after the first one stay queued.
+  manager.setMaxNumThreadsAllowed ( 1 );
+
+  // Make a job in the group that runs until it's told to stop.
+  std::atomic < bool > release ( false );
+  std::atomic < bool > started ( false );
+  auto makeBlocker = [ &release, &started ] ( Group::Ptr group )
+  {
+    Manager::JobPtr job ( new Job ( [ &release, &started ] ( Manager::JobPtr me )
+    {
+      started = true;
+      while ( ( false == release ) && ( false == me->isCancelled() ) )
+      {
+        std::this_thread::sleep_for ( std::chrono::milliseconds ( 1 ) );
+      }
+    } ) );
+    job->setGroup ( group );
+    return job;
+  };
+
+  // Make a job in the group that counts when it runs.
+  std::atomic < unsigned int > count ( 0 );
+  auto makeCounter = [ &count ] ( Group::Ptr group )
+  {
+    Manager::JobPtr job ( new Job ( [ &count ] ( Manager::JobPtr ) { ++count; } ) );
+    job->setGroup ( group );
+    return job;
+  };
+
+  auto waitForStart = [ &started ] ()
+  {
+    while ( false == started )
+    {
+      std::this_thread::sleep_for ( std::chrono::milliseconds ( 1 ) );
+    }
+  };
+
+  SECTION ( "A job can only be in one group" )
+  {
+    Group::Ptr group ( new Group );
+    Manager::JobPtr job = makeCounter ( group );
+    REQUIRE ( group == job->getGroup() );
+    REQUIRE_THROWS_AS ( job->setGroup ( Group::Ptr ( new Group ) ), std::runtime_error );
+    REQUIRE_THROWS_AS ( Manager::JobPtr ( new Job ) ->setGroup ( Group::Ptr() ), std::invalid_argument );
+
+    // It was never added so the group is not done.
+    REQUIRE ( 1 == group->getNumJobs() );
+    REQUIRE ( false == group->waitFor ( 1 ) );
+    job->done();
+    REQUIRE ( 0 == group->getNumJobs() );
+    group->wait();
+  }
+
+  SECTION ( "Wait for one group while another is busy" )
+  {
+    Group::Ptr busy ( new Group );
+    Group::Ptr group ( new Group );
+
+    manager.setMaxNumThreadsAllowed ( 2 );
+    manager.addJob ( makeBlocker ( busy ) );
+    waitForStart();
+
+    for ( unsigned int i = 0; i < 10; ++i )
+    {
+      manager.addJob ( makeCounter ( group ) );
+    }
+
+    group->wait();
+    REQUIRE ( 10 == count );
+    REQUIRE ( 0 == group->getNumJobs() );
+    REQUIRE ( 1 == busy->getNumJobsRunning() );
+    REQUIRE ( false == busy->waitFor ( 1 ) );
+
+    release = true;
+    busy->wait();
+    manager.waitAll();
+  }
+
+  SECTION ( "Clear the queued jobs in a group" )
+  {
+    Group::Ptr group ( new Group );
+    Group::Ptr other ( new Group );
+
+    manager.addJob ( makeBlocker ( group ) );
+    waitForStart();
+
+    Manager::Jobs jobs;
+    for ( unsigned int i = 0; i < 10; ++i )
+    {
+      jobs.push_back ( makeCounter ( group ) );
+      manager.addJob ( jobs.back() );
+      manager.addJob ( makeCounter ( other ) );
+    }
+    REQUIRE ( 10 == group->getNumJobsQueued() );
+    REQUIRE ( 1 == group->getNumJobsRunning() );
+    REQUIRE ( 10 == other->getNumJobsQueued() );
+
+    group->clear();
+    REQUIRE ( 0 == group->getNumJobsQueued() );
+    REQUIRE ( 1 == group->getNumJobsRunning() );
+    REQUIRE ( 10 == other->getNumJobsQueued() );
+
+    // Clearing does not cancel the running job.
+    REQUIRE ( false == group->waitFor ( 10 ) );
+    release = true;
+    group->wait();
+
+    // Only the other group's jobs run, and the cleared ones are done.
+    other->wait();
+    manager.waitAll();
+    REQUIRE ( 10 == count );
+    for ( auto i = jobs.begin(); i != jobs.end(); ++i )
+    {
+      REQUIRE ( true == ( *i )->isDone() );
+    }
+
+    // Jobs added after the clear run.
+    manager.addJob ( makeCounter ( group ) );
+    group->wait();
+    manager.waitAll();
+    REQUIRE ( 11 == count );
+  }
+
+  SECTION ( "Cancel a group" )
+  {
+    Group::Ptr group ( new Group );
+    Group::Ptr other ( new Group );
+
+    Manager::JobPtr blocker = makeBlocker ( group );
+    manager.addJob ( blocker );
+    waitForStart();
+
+    for ( unsigned int i = 0; i < 10; ++i )
+    {
+      manager.addJob ( makeCounter ( group ) );
+      manager.addJob ( makeCounter ( other ) );
+    }
+
+    // The running job sees that it's cancelled and returns.
+    group->cancel();
+    REQUIRE ( true == blocker->isCancelled() );
+    group->wait();
+    other->wait();
+    manager.waitAll();
+    REQUIRE ( 10 == count );
+
+    // Jobs added after the cancel are not cancelled.
+    Manager::JobPtr job = makeCounter ( group );
+    REQUIRE ( false == job->isCancelled() );
+    manager.addJob ( job );
+    group->wait();
+    manager.waitAll();
+    REQUIRE ( 11 == count );
+  }
+
+  SECTION ( "A removed job is done and leaves the group" )
+  {
+    Group::Ptr group ( new Group );
+
+    manager.addJob ( makeBlocker ( group ) );
+    waitForStart();
+
+    Manager::JobPtr job = makeCounter ( group );
+    manager.addJob ( job );
+    REQUIRE ( 2 == group->getNumJobs() );
+
+    // Like a cleared job, it's done and waiting for it returns.
+    REQUIRE ( true == manager.removeQueuedJob ( job ) );
+    REQUIRE ( false == manager.removeQueuedJob ( job ) );
+    REQUIRE ( true == job->isDone() );
+    REQUIRE ( false == job->hasStarted() );
+    REQUIRE ( 1 == group->getNumJobs() );
+    job->wait();
+
+    release = true;
+    group->wait();
+    manager.waitAll();
+    REQUIRE ( 0 == count );
+  }
+}
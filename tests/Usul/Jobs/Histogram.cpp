@@ -0,0 +1,164 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Copyright (c) 2020, Perry L Miller IV
+//  All rights reserved.
+//  MIT License: https://opensource.org/licenses/mit-license.html
+//
+////////////////////////////////////////////////////////////////////////////////
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Test the histograms.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "Usul/Jobs/Histogram.h"
+
+#include "catch2/catch.hpp"
+
+#include <cstdint>
+#include <limits>
+#include <thread>
+#include <vector>
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Test the histograms.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+TEST_CASE ( "Histogram" )
+{
+  typedef Usul::Jobs::Histogram Histogram;
+  typedef Usul::Jobs::AtomicHistogram AtomicHistogram;
+  typedef Histogram::Value Value;
+
+  SECTION ( "Values go in the right buckets" )
+  {
+    REQUIRE ( ( 0 == Histogram::getBucket ( 0 ) ) );
+    REQUIRE ( ( 1 == Histogram::getBucket ( 1 ) ) );
+    REQUIRE ( ( 15 == Histogram::getBucket ( 15 ) ) );
+    REQUIRE ( ( 16 == Histogram::getBucket ( 16 ) ) );
+    REQUIRE ( ( 31 == Histogram::getBucket ( 31 ) ) );
+    REQUIRE ( ( 32 == Histogram::getBucket ( 32 ) ) );
+    REQUIRE ( ( 32 == Histogram::getBucket ( 33 ) ) );
+    REQUIRE ( ( 33 == Histogram::getBucket ( 34 ) ) );
+    REQUIRE ( ( 111 == Histogram::getBucket ( 1000 ) ) );
+    REQUIRE ( ( ( Histogram::NUM_BUCKETS - 1 ) == Histogram::getBucket ( std::numeric_limits < Value >::max() ) ) );
+    REQUIRE ( ( std::numeric_limits < Value >::max() == Histogram::getBucketLimit ( Histogram::NUM_BUCKETS - 1 ) ) );
+
+    // Each value is no more than the limit of its bucket, and the limit is
+    // less than 1/16 more than the value.
+    auto check = [] ( Value v )
+    {
+      const unsigned int bucket = Histogram::getBucket ( v );
+      REQUIRE ( ( bucket < Histogram::NUM_BUCKETS ) );
+      REQUIRE ( ( v <= Histogram::getBucketLimit ( bucket ) ) );
+      REQUIRE ( ( ( Histogram::getBucketLimit ( bucket ) - v ) <= ( v / 16 ) ) );
+      if ( bucket > 0 )
+      {
+        REQUIRE ( ( v > Histogram::getBucketLimit ( bucket - 1 ) ) );
+      }
+    };
+    for ( Value v = 0; v < 5000; ++v )
+    {
+      check ( v );
+    }
+    for ( unsigned int i = 5; i < 64; ++i )
+    {
+      const Value power = static_cast < Value > ( 1 ) << i;
+      check ( power - 1 );
+      check ( power );
+      check ( power + power / 3 );
+    }
+  }
+
+  SECTION ( "An empty histogram is all zeros" )
+  {
+    const Histogram h;
+    REQUIRE ( ( 0 == h.getCount() ) );
+    REQUIRE ( ( 0 == h.getMin() ) );
+    REQUIRE ( ( 0 == h.getMax() ) );
+    REQUIRE ( ( 0 == h.getPercentile ( 0.5 ) ) );
+    REQUIRE ( ( 0.0 == h.getMean() ) );
+    REQUIRE ( ( 0 == AtomicHistogram().get().getMin() ) );
+  }
+
+  SECTION ( "Statistics and percentiles" )
+  {
+    Histogram h;
+    for ( Value v = 1; v <= 1000; ++v )
+    {
+      h.add ( v );
+    }
+
+    REQUIRE ( ( 1000 == h.getCount() ) );
+    REQUIRE ( ( 500500 == h.getSum() ) );
+    REQUIRE ( ( 1 == h.getMin() ) );
+    REQUIRE ( ( 1000 == h.getMax() ) );
+    REQUIRE ( ( 500.5 == h.getMean() ) );
+
+    // The percentiles are within 1/16, and never past the ends.
+    const Value median = h.getPercentile ( 0.5 );
+    REQUIRE ( ( median >= 500 ) );
+    REQUIRE ( ( median <= 531 ) );
+    const Value p90 = h.getPercentile ( 0.9 );
+    REQUIRE ( ( p90 >= 900 ) );
+    REQUIRE ( ( p90 <= 956 ) );
+    const Value p99 = h.getPercentile ( 0.99 );
+    REQUIRE ( ( p99 >= 990 ) );
+    REQUIRE ( ( p99 <= 1000 ) );
+    REQUIRE ( ( 1000 == h.getPercentile ( 1.0 ) ) );
+    REQUIRE ( ( 1 == h.getPercentile ( 0.0 ) ) );
+
+    // Merging adds the counts.
+    Histogram other;
+    other.add ( 5000 );
+    h.add ( other );
+    REQUIRE ( ( 1001 == h.getCount() ) );
+    REQUIRE ( ( 5000 == h.getMax() ) );
+    REQUIRE ( ( 1 == h.getMin() ) );
+  }
+
+  SECTION ( "Many threads can add to the atomic one" )
+  {
+    const unsigned int numThreads = 4;
+    const unsigned int numValues = 10000;
+
+    AtomicHistogram h;
+    std::vector < std::thread > threads;
+    for ( unsigned int i = 0; i < numThreads; ++i )
+    {
+      threads.push_back ( std::thread ( [ &h, i ] ()
+      {
+        for ( unsigned int j = 0; j < numValues; ++j )
+        {
+          h.add ( i * numValues + j );
+        }
+      } ) );
+    }
+    for ( auto i = threads.begin(); i != threads.end(); ++i )
+    {
+      i->join();
+    }
+
+    const Value n = numThreads * numValues;
+    const Histogram copy = h.get();
+    REQUIRE ( ( n == copy.getCount() ) );
+    REQUIRE ( ( ( n * ( n - 1 ) / 2 ) == copy.getSum() ) );
+    REQUIRE ( ( 0 == copy.getMin() ) );
+    REQUIRE ( ( ( n - 1 ) == copy.getMax() ) );
+
+    Value total = 0;
+    for ( unsigned int i = 0; i < Histogram::NUM_BUCKETS; ++i )
+    {
+      total += copy.getBucketCount ( i );
+    }
+    REQUIRE ( ( n == total ) );
+
+    h.clear();
+    REQUIRE ( ( 0 == h.get().getCount() ) );
+    REQUIRE ( ( 0 == h.get().getMax() ) );
+  }
+}
@@ -13,15 +13,29 @@
 //
 ////////////////////////////////////////////////////////////////////////////////
 
+#include "Usul/Jobs/Future.h"
+#include "Usul/Jobs/Group.h"
+#include "Usul/Jobs/Job.h"
 #include "Usul/Jobs/Manager.h"
 #include "Usul/Strings/Format.h"
+#include "Usul/System/Processors.h"
 #include "Usul/Tools/ScopedCall.h"
 
 #include "catch2/catch.hpp"
 
+#include <algorithm>
 #include <atomic>
+#include <chrono>
+#include <functional>
 #include <iostream>
+#include <limits>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
 #include <type_traits>
+#include <vector>
 
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -43,6 +57,15 @@ TEST_CASE ( "Job manager" )
   // Make the singleton.
   Manager &manager = Manager::instance();
 
+  // Run all the sections with both thread models.
+  const Manager::ThreadModel original = manager.getThreadModel();
+  const Manager::ThreadModel model = GENERATE ( Manager::THREAD_PER_JOB, Manager::THREAD_POOL );
+  manager.setThreadModel ( model );
+  USUL_SCOPED_CALL ( ( [ &manager, original ] ()
+  {
+    manager.setThreadModel ( original );
+  } ) );
+
   // Reset the singleton.
   USUL_SCOPED_CALL ( [ &manager ] ()
   {
@@ -52,6 +75,7 @@ TEST_CASE ( "Job manager" )
   SECTION ( "Number of jobs" )
   {
     std::cout << "Job manager is using " << manager.getMaxNumThreadsAllowed() << " threads" << std::endl;
+    REQUIRE ( ( model == manager.getThreadModel() ) );
     REQUIRE ( ( 0 == manager.getNumJobsQueued() ) );
     REQUIRE ( ( 0 == manager.getNumJobsRunning() ) );
     REQUIRE ( ( 0 == manager.getNumJobs() ) );
@@ -128,157 +152,1598 @@ TEST_CASE ( "Job manager" )
     REQUIRE ( ( numJobs == count ) );
   }
 
-  SECTION ( "Add many fast jobs and do not wait for them" )
+  SECTION ( "Jobs start without waiting for the threads to poll" )
   {
-    // How many jobs to add.
-    const unsigned int numJobs = 100;
+    // Make the threads sleep a long time if they are polling.
+    const unsigned int ms = manager.getNumMillisecondsToSleep();
+    manager.setNumMillisecondsToSleep ( 60000 );
+    USUL_SCOPED_CALL ( ( [ &manager, ms ] () { manager.setNumMillisecondsToSleep ( ms ); } ) );
+    REQUIRE ( ( Manager::WAKE_ON_EVENTS == manager.getWakeModel() ) );
 
-    // Count the jobs.
-    AtomicUnsignedInt count ( 0 );
+    const unsigned int numJobs = 10;
 
-    // Add jobs to the manager.
     for ( unsigned int i = 0; i < numJobs; ++i )
     {
-      manager.addJob ( JobPtr ( new Job ( [ &count ] ( JobPtr )
+      // Add a job that says when it started.
+      std::atomic < bool > started ( false );
+      manager.addJob ( [ &started ] ( JobPtr )
       {
-        // Increment the count.
-        ++count;
+        started = true;
+      } );
 
-        // Sleep some to simulate a short task.
-        std::this_thread::sleep_for ( std::chrono::milliseconds ( 5 ) );
-      } ) ) );
+      // It should start long before the threads would have polled.
+      for ( unsigned int j = 0; ( j < 5000 ) && ( false == started ); ++j )
+      {
+        std::this_thread::sleep_for ( std::chrono::milliseconds ( 1 ) );
+      }
+      REQUIRE ( ( true == started ) );
+
+      // Make sure the job is no longer running before we add the next one.
+      while ( manager.getNumJobs() > 0 )
+      {
+        std::this_thread::yield();
+      }
     }
+  }
 
-    // Make sure we have jobs. Note: Some of the jobs may have finished already.
-    REQUIRE ( ( manager.getNumJobs() > 0 ) );
+  SECTION ( "Wait for individual jobs" )
+  {
+    // Make a job that takes a while.
+    std::atomic < bool > finish ( false );
+    JobPtr job = manager.addJob ( [ &finish ] ( JobPtr )
+    {
+      while ( false == finish )
+      {
+        std::this_thread::sleep_for ( std::chrono::milliseconds ( 1 ) );
+      }
+    } );
 
-    // This clears the queue, cancels the running jobs (which is just a hint),
-    // and waits for the running jobs to finish.
-    manager.reset();
+    // It should not be done yet.
+    REQUIRE ( ( false == job->waitFor ( 10 ) ) );
+    REQUIRE ( ( false == job->isDone() ) );
 
-    // We should not have completed all the jobs.
-    REQUIRE ( ( count < numJobs ) );
+    // Let it finish and wait for it.
+    finish = true;
+    job->wait();
+    REQUIRE ( ( true == job->isDone() ) );
+    REQUIRE ( ( true == job->waitFor ( 0 ) ) );
   }
 
-  SECTION ( "Add jobs with just lambda expression" )
+  SECTION ( "Many threads wait for the same job" )
   {
-    // The jobs will increment this.
-    AtomicUnsignedInt count ( 0 );
+    std::atomic < bool > finish ( false );
+    JobPtr job = manager.addJob ( [ &finish ] ( JobPtr )
+    {
+      while ( false == finish )
+      {
+        std::this_thread::sleep_for ( std::chrono::milliseconds ( 1 ) );
+      }
+    } );
 
-    // How many jobs to add.
-    const unsigned int numJobs = 100;
+    // The callbacks are called in the order they were added.
+    std::vector < unsigned int > order;
+    job->whenDone ( [ &order ] () { order.push_back ( 1 ); } );
+    job->whenDone ( [ &order ] () { order.push_back ( 2 ); } );
 
-    // Add several jobs.
-    for ( unsigned int i = 0; i < numJobs; ++i )
+    std::atomic < unsigned int > numDone ( 0 );
+    std::vector < std::thread > waiters;
+    for ( unsigned int i = 0; i < 8; ++i )
     {
-      Usul::Jobs::Manager::instance().addJob ( [ &count ] ( JobPtr )
+      waiters.emplace_back ( [ &job, &numDone ] ()
       {
-        ++count;
+        job->wait();
+        ++numDone;
       } );
     }
 
-    // Wait for all the jobs to finish.
-    Usul::Jobs::Manager::instance().waitAll();
+    REQUIRE ( ( false == job->waitFor ( 10 ) ) );
+    REQUIRE ( ( 0 == numDone ) );
 
-    // This should be true.
-    REQUIRE ( ( numJobs == count ) );
+    finish = true;
+    for ( auto i = waiters.begin(); i != waiters.end(); ++i )
+    {
+      i->join();
+    }
+    REQUIRE ( ( 8 == numDone ) );
+    REQUIRE ( ( true == job->hasStarted() ) );
+
+    // The callbacks are called after the job is marked done.
+    manager.waitAll();
+    REQUIRE ( ( std::vector < unsigned int > { 1, 2 } == order ) );
+
+    // This one is called now.
+    job->whenDone ( [ &order ] () { order.push_back ( 3 ); } );
+    REQUIRE ( ( 3 == order.size() ) );
   }
 
-  SECTION ( "Add jobs that throw exceptions and call error handler" )
+  SECTION ( "Waiting for a cleared job returns" )
   {
-    // The jobs will increment this.
+    // Only allow one job at a time.
+    const unsigned int maxNumThreads = manager.getMaxNumThreadsAllowed();
+    manager.setMaxNumThreadsAllowed ( 1 );
+    USUL_SCOPED_CALL ( ( [ &manager, maxNumThreads ] () { manager.setMaxNumThreadsAllowed ( maxNumThreads ); } ) );
+
+    // This job keeps the only thread busy.
+    std::atomic < bool > finish ( false );
+    JobPtr busy = manager.addJob ( [ &finish ] ( JobPtr )
+    {
+      while ( false == finish )
+      {
+        std::this_thread::sleep_for ( std::chrono::milliseconds ( 1 ) );
+      }
+    } );
+
+    // Wait for it to start.
+    while ( 0 == manager.getNumJobsRunning() )
+    {
+      std::this_thread::yield();
+    }
+
+    // This job stays in the queue until we clear it.
+    JobPtr queued = manager.addJob ( [] ( JobPtr ) {} );
+    REQUIRE ( ( 1 == manager.getNumJobsQueued() ) );
+    manager.clearQueuedJobs();
+    queued->wait();
+    REQUIRE ( ( true == queued->isDone() ) );
+
+    finish = true;
+    busy->wait();
+  }
+
+  SECTION ( "Adding a queued job again throws" )
+  {
+    // Only allow one job at a time.
+    const unsigned int maxNumThreads = manager.getMaxNumThreadsAllowed();
+    manager.setMaxNumThreadsAllowed ( 1 );
+    USUL_SCOPED_CALL ( ( [ &manager, maxNumThreads ] () { manager.setMaxNumThreadsAllowed ( maxNumThreads ); } ) );
+
+    // This job keeps the only thread busy, so nothing moves the next one
+    // from the ring to the queue.
+    std::atomic < bool > finish ( false );
+    JobPtr busy = manager.addJob ( [ &finish ] ( JobPtr )
+    {
+      while ( false == finish )
+      {
+        std::this_thread::sleep_for ( std::chrono::milliseconds ( 1 ) );
+      }
+    } );
+    while ( 0 == manager.getNumJobsRunning() )
+    {
+      std::this_thread::yield();
+    }
+
     AtomicUnsignedInt count ( 0 );
+    JobPtr job = manager.addJob ( [ &count ] ( JobPtr ) { ++count; } );
+    REQUIRE_THROWS_AS ( manager.addJob ( job ), std::runtime_error );
+    REQUIRE_THROWS_AS ( manager.addJobs ( Manager::Jobs ( 1, job ) ), std::runtime_error );
 
-    // How many jobs to add.
-    const unsigned int numJobs = 100;
+    // It still runs once.
+    finish = true;
+    manager.waitAll();
+    REQUIRE ( 1 == count );
+  }
 
-    // Save the original error handler (which is probably null) and always restore it.
-    Manager::ErrorHandler original = manager.getErrorHandler();
-    USUL_SCOPED_CALL ( ( [ &manager, original ] () { manager.setErrorHandler ( original ); } ) );
+  SECTION ( "Removing a job that others wait for" )
+  {
+    // Only allow one job at a time.
+    const unsigned int maxNumThreads = manager.getMaxNumThreadsAllowed();
+    manager.setMaxNumThreadsAllowed ( 1 );
+    USUL_SCOPED_CALL ( ( [ &manager, maxNumThreads ] () { manager.setMaxNumThreadsAllowed ( maxNumThreads ); } ) );
 
-    // The exception message.
-    const std::string message ( "Throwing exception from inside job" );
+    // This job keeps the only thread busy.
+    std::atomic < bool > finish ( false );
+    JobPtr busy = manager.addJob ( [ &finish ] ( JobPtr )
+    {
+      while ( false == finish )
+      {
+        std::this_thread::sleep_for ( std::chrono::milliseconds ( 1 ) );
+      }
+    } );
 
-    // Set the error handler.
-    manager.setErrorHandler ( [ &count, &message ] ( Manager::JobPtr, const std::exception &e )
+    // Wait for it to start.
+    while ( 0 == manager.getNumJobsRunning() )
     {
-      ++count;
-      REQUIRE ( ( message == e.what() ) );
+      std::this_thread::yield();
+    }
+
+    // The second job waits for the first, which stays in the queue.
+    AtomicUnsignedInt count ( 0 );
+    JobPtr first = manager.addJob ( [ &count ] ( JobPtr ) { ++count; } );
+    JobPtr second = manager.addJob ( [ &count ] ( JobPtr ) { ++count; }, Manager::Jobs ( 1, first ) );
+    REQUIRE ( ( 1 == manager.getNumJobsQueued() ) );
+
+    // Removing the first is the same as clearing it, so the second is
+    // queued and waiting for all of them returns.
+    REQUIRE ( true == manager.removeQueuedJob ( first ) );
+    REQUIRE ( true == first->isDone() );
+
+    finish = true;
+    manager.waitAll();
+    REQUIRE ( true == second->isDone() );
+    REQUIRE ( 1 == count );
+    REQUIRE ( ( 0 == manager.getNumJobs() ) );
+  }
+
+  SECTION ( "Limit the number of queued jobs" )
+  {
+    // Only allow one job at a time.
+    const unsigned int maxNumThreads = manager.getMaxNumThreadsAllowed();
+    manager.setMaxNumThreadsAllowed ( 1 );
+    USUL_SCOPED_CALL ( ( [ &manager, maxNumThreads ] () { manager.setMaxNumThreadsAllowed ( maxNumThreads ); } ) );
+
+    REQUIRE_THROWS_AS ( manager.setMaxNumJobsQueued ( 0 ), std::invalid_argument );
+    manager.setMaxNumJobsQueued ( 2 );
+    USUL_SCOPED_CALL ( ( [ &manager ] () { manager.setMaxNumJobsQueued ( std::numeric_limits < unsigned int >::max() ); } ) );
+
+    // This job keeps the only thread busy.
+    std::atomic < bool > finish ( false );
+    JobPtr busy = manager.addJob ( [ &finish ] ( JobPtr )
+    {
+      while ( false == finish )
+      {
+        std::this_thread::sleep_for ( std::chrono::milliseconds ( 1 ) );
+      }
+    } );
+    while ( 0 == manager.getNumJobsRunning() )
+    {
+      std::this_thread::yield();
+    }
+
+    // Make sure it does not block forever if a test fails.
+    USUL_SCOPED_CALL ( [ &finish ] ()
+    {
+      finish = true;
     } );
 
-    // Add several jobs.
-    for ( unsigned int i = 0; i < numJobs; ++i )
+    // Fill the queue.
+    std::atomic < unsigned int > count ( 0 );
+    auto makeJob = [ &count ] () { return JobPtr ( new Usul::Jobs::Job ( [ &count ] ( JobPtr ) { ++count; } ) ); };
+    REQUIRE ( ( true == manager.tryAddJob ( makeJob() ) ) );
+    REQUIRE ( ( true == manager.tryAddJob ( makeJob() ) ) );
+    REQUIRE ( ( 2 == manager.getNumJobsQueued() ) );
+
+    // There is no room for more, and a job that's not added is not traced.
+    manager.setTracing ( true );
+    manager.clearTrace();
+    USUL_SCOPED_CALL ( [ &manager ] ()
     {
-      manager.addJob ( [ &count, &message ] ( JobPtr )
+      manager.setTracing ( false );
+      manager.clearTrace();
+    } );
+    REQUIRE ( ( false == manager.tryAddJob ( JobPtr ( new Usul::Jobs::Job ( "refused", [] ( JobPtr ) {} ) ) ) ) );
+    REQUIRE ( ( false == manager.tryAddJobFor ( JobPtr ( new Usul::Jobs::Job ( "refused", [] ( JobPtr ) {} ) ), 10 ) ) );
+    {
+      std::ostringstream out;
+      manager.writeTrace ( out );
+      REQUIRE ( ( std::string::npos == out.str().find ( "refused" ) ) );
+    }
+    REQUIRE_THROWS_AS ( manager.addJobs ( Manager::Jobs { makeJob(), makeJob(), makeJob() } ), std::invalid_argument );
+    REQUIRE ( ( 2 == manager.getNumJobsQueued() ) );
+
+    // This waits until the busy job is done.
+    std::thread producer ( [ &manager, &makeJob ] ()
+    {
+      manager.addJob ( makeJob() );
+    } );
+    std::this_thread::sleep_for ( std::chrono::milliseconds ( 10 ) );
+    REQUIRE ( ( 2 == manager.getNumJobsQueued() ) );
+
+    finish = true;
+    producer.join();
+    manager.waitAll();
+    REQUIRE ( ( 3 == count ) );
+  }
+
+  SECTION ( "Queued jobs run in the order of the policy" )
+  {
+    typedef Job::Clock Clock;
+
+    // Only allow one job at a time.
+    const unsigned int maxNumThreads = manager.getMaxNumThreadsAllowed();
+    manager.setMaxNumThreadsAllowed ( 1 );
+    USUL_SCOPED_CALL ( ( [ &manager, maxNumThreads ] () { manager.setMaxNumThreadsAllowed ( maxNumThreads ); } ) );
+
+    REQUIRE ( ( Usul::Jobs::Queue::POLICY_PRIORITY == manager.getQueuePolicy() ) );
+    manager.setQueuePolicy ( Usul::Jobs::Queue::POLICY_DEADLINE );
+    USUL_SCOPED_CALL ( [ &manager ] () { manager.setQueuePolicy ( Usul::Jobs::Queue::POLICY_PRIORITY ); } );
+    REQUIRE ( ( Usul::Jobs::Queue::POLICY_DEADLINE == manager.getQueuePolicy() ) );
+
+    // This job keeps the only thread busy.
+    std::atomic < bool > finish ( false );
+    manager.addJob ( [ &finish ] ( JobPtr )
+    {
+      while ( false == finish )
       {
-        // Every other one we throw an exception.
-        if ( 0 == ( count % 2 ) )
-        {
-          throw std::runtime_error ( message );
-        }
+        std::this_thread::sleep_for ( std::chrono::milliseconds ( 1 ) );
+      }
+    } );
+    while ( 0 == manager.getNumJobsRunning() )
+    {
+      std::this_thread::yield();
+    }
 
-        // If we get this far then increment the count.
+    // The background job has the highest priority but no deadline.
+    std::mutex mutex;
+    std::vector < std::string > order;
+    auto makeJob = [ &mutex, &order ] ( const std::string &name, double priority, unsigned int ms )
+    {
+      JobPtr job ( new Job ( name, priority, [ &mutex, &order ] ( JobPtr j )
+      {
+        std::lock_guard < std::mutex > guard ( mutex );
+        order.push_back ( j->getName() );
+      } ) );
+      if ( ms > 0 )
+      {
+        job->setDeadline ( Clock::now() + std::chrono::milliseconds ( ms ) );
+      }
+      return job;
+    };
+    manager.addJob ( makeJob ( "background", 10, 0 ) );
+    manager.addJob ( makeJob ( "later", 0, 500 ) );
+    manager.addJob ( makeJob ( "sooner", 0, 100 ) );
+
+    finish = true;
+    manager.waitAll();
+    REQUIRE ( ( std::vector < std::string > { "sooner", "later", "background" } == order ) );
+
+    manager.setAgingRate ( 5 );
+    REQUIRE ( ( 5 == manager.getAgingRate() ) );
+    manager.setAgingRate ( 1 );
+  }
+
+  SECTION ( "Waiting for all jobs returns when the last one is done" )
+  {
+    // Make the threads sleep a long time if they are polling.
+    const unsigned int ms = manager.getNumMillisecondsToSleep();
+    manager.setNumMillisecondsToSleep ( 60000 );
+    USUL_SCOPED_CALL ( ( [ &manager, ms ] () { manager.setNumMillisecondsToSleep ( ms ); } ) );
+
+    typedef std::chrono::steady_clock Clock;
+    AtomicUnsignedInt count ( 0 );
+    const unsigned int numJobs = 10;
+
+    const Clock::time_point start = Clock::now();
+    for ( unsigned int i = 0; i < numJobs; ++i )
+    {
+      manager.addJob ( [ &count ] ( JobPtr )
+      {
+        std::this_thread::sleep_for ( std::chrono::milliseconds ( 1 ) );
         ++count;
       } );
     }
-
-    // Wait for all the jobs to finish.
     manager.waitAll();
+    const double seconds = std::chrono::duration < double > ( Clock::now() - start ).count();
 
-    // This should be true.
     REQUIRE ( ( numJobs == count ) );
+    REQUIRE ( ( 0 == manager.getNumJobs() ) );
+    REQUIRE ( ( seconds < 10 ) );
   }
 
-  SECTION ( "Remove all jobs from inside error handler" )
+  SECTION ( "Count the jobs while another thread has the mutex" )
   {
-    // Save the original error handler (which is probably null) and always restore it.
-    Manager::ErrorHandler original = manager.getErrorHandler();
-    USUL_SCOPED_CALL ( ( [ &manager, original ] () { manager.setErrorHandler ( original ); } ) );
+    typedef std::atomic < bool > AtomicBool;
+    AtomicBool releaseJob ( false );
+    AtomicBool releaseMutex ( false );
+    AtomicBool hasMutex ( false );
 
-    // The exception message.
-    const std::string message ( "Throwing exception from inside job" );
+    // Make sure everything is released if a check fails.
+    std::thread holder;
+    USUL_SCOPED_CALL ( ( [ &releaseJob, &releaseMutex, &holder ] ()
+    {
+      releaseMutex = true;
+      releaseJob = true;
+      if ( true == holder.joinable() )
+      {
+        holder.join();
+      }
+    } ) );
 
-    // Set the error handler.
-    manager.setErrorHandler ( [ &manager ] ( Manager::JobPtr job, const std::exception & )
+    manager.addJob ( [ &releaseJob ] ( JobPtr )
     {
-      std::cout << Usul::Strings::format ( "Job ", job->getID(), " deliberately had an error, cancelling all jobs", '\n' ) << std::flush;
+      while ( false == releaseJob )
+      {
+        std::this_thread::sleep_for ( std::chrono::milliseconds ( 1 ) );
+      }
+    } );
 
-      // Clears the queue of jobs that are still waiting to execute.
-      manager.clearQueuedJobs();
+    // Wait for it to start.
+    for ( unsigned int i = 0; ( i < 5000 ) && ( 0 == manager.getNumJobsRunning() ); ++i )
+    {
+      std::this_thread::sleep_for ( std::chrono::milliseconds ( 1 ) );
+    }
 
-      // Cancel any other running jobs (which is just a hint).
-      manager.cancelRunningJobs();
+    holder = std::thread ( [ &manager, &releaseMutex, &hasMutex ] ()
+    {
+      std::lock_guard < Manager::Mutex > guard ( manager.mutex() );
+      hasMutex = true;
+      while ( false == releaseMutex )
+      {
+        std::this_thread::sleep_for ( std::chrono::milliseconds ( 1 ) );
+      }
+    } );
+    while ( false == hasMutex )
+    {
+      std::this_thread::yield();
+    }
 
-      // Note: Do not call manager.destroy() in here because it causes a dead-lock.
+    // These do not wait for the mutex.
+    REQUIRE ( ( 1 == manager.getNumJobs() ) );
+    REQUIRE ( ( 1 == manager.getNumJobsRunning() ) );
+    REQUIRE ( ( 0 == manager.getNumJobsQueued() ) );
+
+    releaseMutex = true;
+    holder.join();
+    releaseJob = true;
+    manager.waitAll();
+    REQUIRE ( ( 0 == manager.getNumJobs() ) );
+  }
+
+  SECTION ( "Add many jobs all at once" )
+  {
+    // Count the jobs.
+    AtomicUnsignedInt count ( 0 );
+
+    // Add a batch of callbacks.
+    Manager::Callbacks callbacks ( 500, [ &count ] ( JobPtr )
+    {
+      ++count;
     } );
+    const Manager::Jobs jobs = manager.addJobs ( callbacks );
+    REQUIRE ( ( callbacks.size() == jobs.size() ) );
 
-    // Add several jobs that spin until they are cancelled.
-    for ( unsigned int i = 0; i < ( manager.getMaxNumThreadsAllowed() - 1 ); ++i )
+    // Add a batch of jobs with different priorities.
+    Manager::Jobs more;
+    for ( unsigned int i = 0; i < 500; ++i )
     {
-      manager.addJob ( [] ( JobPtr job )
+      more.push_back ( JobPtr ( new Job ( "", i, [ &count ] ( JobPtr ) { ++count; } ) ) );
+    }
+    manager.addJobs ( more );
+
+    // Adding nothing is fine.
+    manager.addJobs ( Manager::Jobs() );
+
+    // If one is null then none of them are added.
+    Manager::Jobs bad ( 2, JobPtr ( new Job ( [ &count ] ( JobPtr ) { ++count; } ) ) );
+    bad.push_back ( JobPtr() );
+    REQUIRE_THROWS ( manager.addJobs ( bad ) );
+
+    manager.waitAll();
+
+    REQUIRE ( ( 1000 == count ) );
+    REQUIRE ( ( 0 == manager.getNumJobs() ) );
+    REQUIRE ( ( true == std::all_of ( jobs.begin(), jobs.end(), [] ( JobPtr job ) { return job->isDone(); } ) ) );
+    REQUIRE ( ( false == bad.front()->isDone() ) );
+  }
+
+  SECTION ( "Jobs that wait for other jobs" )
+  {
+    // Each stage of each item records when it ran.
+    const unsigned int numItems = 20;
+    const unsigned int numStages = 4;
+    AtomicUnsignedInt clock ( 0 );
+    std::vector < std::vector < unsigned int > > when ( numItems, std::vector < unsigned int > ( numStages, 0 ) );
+
+    // Build the stages backwards to make sure that waiting jobs are not run
+    // before the jobs they wait for are even added.
+    std::vector < Manager::Jobs > stages ( numStages );
+    for ( unsigned int s = 0; s < numStages; ++s )
+    {
+      for ( unsigned int i = 0; i < numItems; ++i )
       {
-        while ( false == job->isCancelled() )
+        stages[s].push_back ( JobPtr ( new Job ( [ &clock, &when, i, s ] ( JobPtr )
         {
-          // Sleep some to simulate a lengthy task.
-          std::this_thread::sleep_for ( std::chrono::milliseconds ( 50 ) );
+          when[i][s] = ++clock;
+        } ) ) );
+      }
+    }
+    for ( unsigned int s = numStages - 1; s > 0; --s )
+    {
+      for ( unsigned int i = 0; i < numItems; ++i )
+      {
+        manager.addJob ( stages[s][i], Manager::Jobs ( 1, stages[s - 1][i] ) );
+      }
+    }
 
-          std::cout << Usul::Strings::format ( "Job ", job->getID(), " is doing work", '\n' ) << std::flush;
-        }
+    // A final job waits for all the items.
+    std::atomic < unsigned int > last ( 0 );
+    manager.addJob ( [ &clock, &last ] ( JobPtr ) { last = ++clock; }, stages.back() );
 
-        std::cout << Usul::Strings::format ( "Job ", job->getID(), " has been cancelled", '\n' ) << std::flush;
-      } );
+    // Nothing can run yet but they are all counted.
+    REQUIRE ( ( ( numItems * ( numStages - 1 ) + 1 ) == manager.getNumJobs() ) );
+    REQUIRE_THROWS ( manager.addJob ( stages[1][0], Manager::Jobs ( 1, stages[0][0] ) ) );
+
+    manager.addJobs ( stages.front() );
+    manager.waitAll();
+
+    for ( unsigned int i = 0; i < numItems; ++i )
+    {
+      for ( unsigned int s = 1; s < numStages; ++s )
+      {
+        REQUIRE ( ( when[i][s - 1] > 0 ) );
+        REQUIRE ( ( when[i][s - 1] < when[i][s] ) );
+      }
     }
+    REQUIRE ( ( numItems * numStages + 1 == last ) );
 
-    // Let the above jobs get started.
-    std::this_thread::sleep_for ( std::chrono::milliseconds ( 100 ) );
+    // Waiting for jobs that are done already adds it now.
+    JobPtr job = manager.addJob ( [] ( JobPtr ) {}, stages.front() );
+    job->wait();
+  }
 
-    // Add one more job that will throw an exception.
-    manager.addJob ( [] ( JobPtr job )
+  SECTION ( "Only one thread can make a job wait for others" )
+  {
+    const unsigned int numTries = 100;
+    AtomicUnsignedInt numRan ( 0 );
+    AtomicUnsignedInt numThrown ( 0 );
+    Manager::Jobs gates;
+
+    for ( unsigned int i = 0; i < numTries; ++i )
     {
-      throw std::runtime_error ( Usul::Strings::format ( "Job ", job->getID(), " is throwing an exception" ) );
-    } );
+      // The job waits for the gate, which is not added until the end.
+      JobPtr gate ( new Job ( [] ( JobPtr ) {} ) );
+      JobPtr job ( new Job ( [ &numRan ] ( JobPtr ) { ++numRan; } ) );
+      gates.push_back ( gate );
 
-    // Wait for all the jobs to finish.
+      auto add = [ &manager, &numThrown, job, gate ] ()
+      {
+        try
+        {
+          manager.addJob ( job, Manager::Jobs ( 1, gate ) );
+        }
+        catch ( const std::exception & )
+        {
+          ++numThrown;
+        }
+      };
+      std::thread a ( add );
+      std::thread b ( add );
+      a.join();
+      b.join();
+    }
+
+    REQUIRE ( ( numTries == numThrown ) );
+    REQUIRE ( ( numTries == manager.getNumJobs() ) );
+
+    manager.addJobs ( gates );
     manager.waitAll();
+    REQUIRE ( ( numTries == numRan ) );
+    REQUIRE ( ( 0 == manager.getNumJobs() ) );
   }
+
+  SECTION ( "Delayed and periodic jobs" )
+  {
+    typedef Manager::Clock Clock;
+    typedef std::chrono::milliseconds Milliseconds;
+
+    // Make sure delayed jobs do not use threads while they wait.
+    const unsigned int numDelayed = manager.getMaxNumThreadsAllowed() * 4;
+    const Clock::time_point start = Clock::now();
+    AtomicUnsignedInt numRan ( 0 );
+    std::atomic < bool > early ( false );
+    for ( unsigned int i = 0; i < numDelayed; ++i )
+    {
+      manager.addJobAfter ( [ &numRan, &early, start ] ( JobPtr )
+      {
+        if ( ( Clock::now() - start ) < Milliseconds ( 50 ) )
+        {
+          early = true;
+        }
+        ++numRan;
+      }, 50 );
+    }
+
+    // They are counted but none are running.
+    REQUIRE ( ( numDelayed == manager.getNumJobs() ) );
+    REQUIRE ( ( 0 == manager.getNumJobsRunning() ) );
+
+    // A job added now runs before them.
+    JobPtr now = manager.addJob ( [] ( JobPtr ) {} );
+    now->wait();
+    REQUIRE ( ( 0 == numRan ) );
+
+    manager.waitAll();
+    REQUIRE ( ( numDelayed == numRan ) );
+    REQUIRE ( ( false == early ) );
+
+    // A job at a time in the past is queued now.
+    JobPtr past = manager.addJobAt ( [] ( JobPtr ) {}, start );
+    past->wait();
+
+    // A job can only wait for one thing at a time.
+    JobPtr later = manager.addJobAfter ( [] ( JobPtr ) {}, 10000 );
+    REQUIRE_THROWS ( manager.addJobAfter ( later, 10 ) );
+    REQUIRE_THROWS ( manager.addJob ( later, Manager::Jobs ( 1, now ) ) );
+
+    // Clearing the queue clears the timed jobs too.
+    manager.clearQueuedJobs();
+    REQUIRE ( ( true == later->isDone() ) );
+    REQUIRE ( ( false == later->hasStarted() ) );
+    manager.waitAll();
+
+    // A periodic job runs until it's cancelled.
+    AtomicUnsignedInt numTimes ( 0 );
+    JobPtr periodic = manager.addPeriodicJob ( [ &numTimes ] ( JobPtr ) { ++numTimes; }, 5 );
+    REQUIRE_THROWS_AS ( manager.addPeriodicJob ( [] ( JobPtr ) {}, 0 ), std::invalid_argument );
+    while ( numTimes < 3 )
+    {
+      std::this_thread::sleep_for ( Milliseconds ( 1 ) );
+    }
+    REQUIRE ( ( false == periodic->isDone() ) );
+    periodic->cancel();
+    periodic->wait();
+    manager.waitAll();
+    const unsigned int numAfterCancel = numTimes;
+    std::this_thread::sleep_for ( Milliseconds ( 20 ) );
+    REQUIRE ( ( numAfterCancel == numTimes ) );
+
+    // Resetting stops it too.
+    JobPtr another = manager.addPeriodicJob ( [] ( JobPtr ) {}, 1000 );
+    manager.reset();
+    REQUIRE ( ( true == another->isDone() ) );
+  }
+
+  SECTION ( "Record the times of the jobs" )
+  {
+    typedef std::chrono::milliseconds Milliseconds;
+
+    manager.setRecordingJobTimes ( true );
+    manager.clearJobTimes();
+    USUL_SCOPED_CALL ( [ &manager ] ()
+    {
+      manager.setRecordingJobTimes ( false );
+      manager.clearJobTimes();
+    } );
+    REQUIRE ( ( true == manager.isRecordingJobTimes() ) );
+
+    for ( unsigned int i = 0; i < 10; ++i )
+    {
+      manager.addJob ( JobPtr ( new Job ( "sleepy", [] ( JobPtr )
+      {
+        std::this_thread::sleep_for ( Milliseconds ( 2 ) );
+      } ) ) );
+    }
+    for ( unsigned int i = 0; i < 5; ++i )
+    {
+      manager.addJob ( JobPtr ( new Job ( "quick", [] ( JobPtr ) {} ) ) );
+    }
+    JobPtr late ( new Job ( "late", [] ( JobPtr ) {} ) );
+    manager.addJobAfter ( late, 20 );
+    manager.waitAll();
+
+    const Manager::JobTimes all = manager.getJobTimes();
+    REQUIRE ( ( 16 == all.queued.getCount() ) );
+    REQUIRE ( ( 16 == all.running.getCount() ) );
+    REQUIRE ( ( 16 == all.total.getCount() ) );
+
+    const Manager::JobTimesByName byName = manager.getJobTimesByName();
+    REQUIRE ( ( 3 == byName.size() ) );
+    REQUIRE ( ( 10 == byName.at ( "sleepy" ).running.getCount() ) );
+    REQUIRE ( ( 5 == byName.at ( "quick" ).running.getCount() ) );
+    REQUIRE ( ( byName.at ( "sleepy" ).running.getMin() >= 1000 ) );
+
+    // The time waiting for the timer is not time in the queue.
+    const Manager::JobTimes &lateTimes = byName.at ( "late" );
+    REQUIRE ( ( lateTimes.total.getMin() >= 19000 ) );
+    REQUIRE ( ( lateTimes.queued.getMax() < lateTimes.total.getMin() ) );
+
+    // Nothing is recorded when it's off.
+    manager.setRecordingJobTimes ( false );
+    manager.addJob ( JobPtr ( new Job ( "quick", [] ( JobPtr ) {} ) ) );
+    manager.waitAll();
+    REQUIRE ( ( 16 == manager.getJobTimes().running.getCount() ) );
+
+    manager.clearJobTimes();
+    REQUIRE ( ( 0 == manager.getJobTimes().running.getCount() ) );
+    REQUIRE ( ( 0 == manager.getJobTimesByName().at ( "quick" ).running.getCount() ) );
+  }
+
+  SECTION ( "Trace what the threads do" )
+  {
+    manager.setTracing ( true );
+    manager.clearTrace();
+    USUL_SCOPED_CALL ( [ &manager ] ()
+    {
+      manager.setTracing ( false );
+      manager.clearTrace();
+    } );
+    REQUIRE ( ( true == manager.isTracing() ) );
+
+    for ( unsigned int i = 0; i < 10; ++i )
+    {
+      manager.addJob ( JobPtr ( new Job ( "traced", [] ( JobPtr )
+      {
+        std::this_thread::sleep_for ( std::chrono::milliseconds ( 1 ) );
+      } ) ) );
+    }
+    JobPtr late ( new Job ( "late \"one\"", [] ( JobPtr ) {} ) );
+    manager.addJobAfter ( late, 5 );
+    manager.waitAll();
+
+    std::ostringstream out;
+    manager.writeTrace ( out );
+    const std::string json ( out.str() );
+
+    REQUIRE ( ( 0 == json.find ( "{\"displayTimeUnit\"" ) ) );
+    REQUIRE ( ( std::string::npos != json.find ( "\"name\":\"traced\"" ) ) );
+    REQUIRE ( ( std::string::npos != json.find ( "\"name\":\"late \\\"one\\\"\"" ) ) );
+    REQUIRE ( ( std::string::npos != json.find ( "\"cat\":\"enqueue\"" ) ) );
+    REQUIRE ( ( std::string::npos != json.find ( "\"cat\":\"wait\"" ) ) );
+    REQUIRE ( ( std::string::npos != json.find ( "\"cat\":\"dequeue\"" ) ) );
+    REQUIRE ( ( std::string::npos != json.find ( "\"ph\":\"B\",\"cat\":\"job\"" ) ) );
+    REQUIRE ( ( std::string::npos != json.find ( "\"ph\":\"E\",\"cat\":\"job\"" ) ) );
+    REQUIRE ( ( std::string::npos != json.find ( "\"args\":{\"name\":\"timer\"}" ) ) );
+    REQUIRE ( ( std::string::npos != json.find ( ( Manager::THREAD_POOL == model ) ?
+      "\"args\":{\"name\":\"pool 0\"}" : "\"args\":{\"name\":\"worker\"}" ) ) );
+    REQUIRE ( ( json.size() > 2 ) );
+    REQUIRE ( ( "]}\n" == json.substr ( json.size() - 3 ) ) );
+
+    // Nothing is recorded when it's off.
+    manager.setTracing ( false );
+    manager.clearTrace();
+    manager.addJob ( JobPtr ( new Job ( "traced", [] ( JobPtr ) {} ) ) );
+    manager.waitAll();
+    std::ostringstream empty;
+    manager.writeTrace ( empty );
+    REQUIRE ( ( std::string::npos == empty.str().find ( "\"cat\":\"job\"" ) ) );
+  }
+
+  SECTION ( "Add many fast jobs and do not wait for them" )
+  {
+    // How many jobs to add.
+    const unsigned int numJobs = 100;
+
+    // Count the jobs.
+    AtomicUnsignedInt count ( 0 );
+
+    // Add jobs to the manager.
+    for ( unsigned int i = 0; i < numJobs; ++i )
+    {
+      manager.addJob ( JobPtr ( new Job ( [ &count ] ( JobPtr )
+      {
+        // Increment the count.
+        ++count;
+
+        // Sleep some to simulate a short task.
+        std::this_thread::sleep_for ( std::chrono::milliseconds ( 5 ) );
+      } ) ) );
+    }
+
+    // Make sure we have jobs. Note: Some of the jobs may have finished already.
+    REQUIRE ( ( manager.getNumJobs() > 0 ) );
+
+    // This clears the queue, cancels the running jobs (which is just a hint),
+    // and waits for the running jobs to finish.
+    manager.reset();
+
+    // We should not have completed all the jobs.
+    REQUIRE ( ( count < numJobs ) );
+  }
+
+  SECTION ( "Add jobs with just lambda expression" )
+  {
+    // The jobs will increment this.
+    AtomicUnsignedInt count ( 0 );
+
+    // How many jobs to add.
+    const unsigned int numJobs = 100;
+
+    // Add several jobs.
+    for ( unsigned int i = 0; i < numJobs; ++i )
+    {
+      Usul::Jobs::Manager::instance().addJob ( [ &count ] ( JobPtr )
+      {
+        ++count;
+      } );
+    }
+
+    // Wait for all the jobs to finish.
+    Usul::Jobs::Manager::instance().waitAll();
+
+    // This should be true.
+    REQUIRE ( ( numJobs == count ) );
+  }
+
+  SECTION ( "Add jobs that throw exceptions and call error handler" )
+  {
+    // The jobs will increment this.
+    AtomicUnsignedInt count ( 0 );
+
+    // How many jobs to add.
+    const unsigned int numJobs = 100;
+
+    // Save the original error handler (which is probably null) and always restore it.
+    Manager::ErrorHandler original = manager.getErrorHandler();
+    USUL_SCOPED_CALL ( ( [ &manager, original ] () { manager.setErrorHandler ( original ); } ) );
+
+    // The exception message.
+    const std::string message ( "Throwing exception from inside job" );
+
+    // Set the error handler.
+    manager.setErrorHandler ( [ &count, &message ] ( Manager::JobPtr, const std::exception &e )
+    {
+      ++count;
+      REQUIRE ( ( message == e.what() ) );
+    } );
+
+    // Add several jobs.
+    for ( unsigned int i = 0; i < numJobs; ++i )
+    {
+      manager.addJob ( [ &count, &message ] ( JobPtr )
+      {
+        // Every other one we throw an exception.
+        if ( 0 == ( count % 2 ) )
+        {
+          throw std::runtime_error ( message );
+        }
+
+        // If we get this far then increment the count.
+        ++count;
+      } );
+    }
+
+    // Wait for all the jobs to finish.
+    manager.waitAll();
+
+    // This should be true.
+    REQUIRE ( ( numJobs == count ) );
+  }
+
+  SECTION ( "Remove all jobs from inside error handler" )
+  {
+    // Save the original error handler (which is probably null) and always restore it.
+    Manager::ErrorHandler original = manager.getErrorHandler();
+    USUL_SCOPED_CALL ( ( [ &manager, original ] () { manager.setErrorHandler ( original ); } ) );
+
+    // The exception message.
+    const std::string message ( "Throwing exception from inside job" );
+
+    // Set the error handler.
+    manager.setErrorHandler ( [ &manager ] ( Manager::JobPtr job, const std::exception & )
+    {
+      std::cout << Usul::Strings::format ( "Job ", job->getID(), " deliberately had an error, cancelling all jobs", '\n' ) << std::flush;
+
+      // Clears the queue of jobs that are still waiting to execute.
+      manager.clearQueuedJobs();
+
+      // Cancel any other running jobs (which is just a hint).
+      manager.cancelRunningJobs();
+
+      // Note: Do not call manager.destroy() in here because it causes a dead-lock.
+    } );
+
+    // Add several jobs that spin until they are cancelled.
+    for ( unsigned int i = 0; i < ( manager.getMaxNumThreadsAllowed() - 1 ); ++i )
+    {
+      manager.addJob ( [] ( JobPtr job )
+      {
+        while ( false == job->isCancelled() )
+        {
+          // Sleep some to simulate a lengthy task.
+          std::this_thread::sleep_for ( std::chrono::milliseconds ( 50 ) );
+
+          std::cout << Usul::Strings::format ( "Job ", job->getID(), " is doing work", '\n' ) << std::flush;
+        }
+
+        std::cout << Usul::Strings::format ( "Job ", job->getID(), " has been cancelled", '\n' ) << std::flush;
+      } );
+    }
+
+    // Let the above jobs get started.
+    std::this_thread::sleep_for ( std::chrono::milliseconds ( 100 ) );
+
+    // Add one more job that will throw an exception.
+    manager.addJob ( [] ( JobPtr job )
+    {
+      throw std::runtime_error ( Usul::Strings::format ( "Job ", job->getID(), " is throwing an exception" ) );
+    } );
+
+    // Wait for all the jobs to finish.
+    manager.waitAll();
+  }
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Test the lanes that have their own queues and threads.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+TEST_CASE ( "Job manager lanes" )
+{
+  typedef Usul::Jobs::Manager Manager;
+  typedef Usul::Jobs::Job Job;
+  typedef Manager::JobPtr JobPtr;
+  typedef std::atomic < unsigned int > AtomicUnsignedInt;
+  typedef std::chrono::milliseconds Milliseconds;
+
+  Manager manager;
+  manager.setMaxNumThreadsAllowed ( 1 );
+
+  const Manager::Lane io = manager.addLane ( "io", 4 );
+  REQUIRE ( ( 2 == manager.getNumLanes() ) );
+  REQUIRE ( ( io == manager.getLane ( "io" ) ) );
+  REQUIRE ( ( Manager::DEFAULT_LANE == manager.getLane ( "default" ) ) );
+  REQUIRE ( ( "io" == manager.getLaneName ( io ) ) );
+  REQUIRE ( ( 4 == manager.getMaxNumThreadsAllowed ( io ) ) );
+  REQUIRE ( ( 1 == manager.getMaxNumThreadsAllowed ( Manager::DEFAULT_LANE ) ) );
+  REQUIRE_THROWS ( manager.addLane ( "io", 1 ) );
+  REQUIRE_THROWS ( manager.addLane ( "default", 1 ) );
+  REQUIRE_THROWS_AS ( manager.getLane ( "nope" ), std::invalid_argument );
+  REQUIRE_THROWS_AS ( manager.addJob ( io + 1, [] ( JobPtr ) {} ), std::invalid_argument );
+
+  // Jobs in the lane block until this is true.
+  std::atomic < bool > release ( false );
+  auto block = [ &release ] ()
+  {
+    while ( false == release )
+    {
+      std::this_thread::sleep_for ( Milliseconds ( 1 ) );
+    }
+  };
+
+  // Make sure they do not block forever if a test fails.
+  USUL_SCOPED_CALL ( [ &release ] ()
+  {
+    release = true;
+  } );
+
+  SECTION ( "Blocking jobs in a lane do not starve the other jobs" )
+  {
+    AtomicUnsignedInt numBlocked ( 0 );
+    for ( unsigned int i = 0; i < 4; ++i )
+    {
+      manager.addJob ( io, [ &numBlocked, &block ] ( JobPtr )
+      {
+        ++numBlocked;
+        block();
+      } );
+    }
+
+    // They all run at once even though the pool has one thread.
+    while ( numBlocked < 4 )
+    {
+      std::this_thread::sleep_for ( Milliseconds ( 1 ) );
+    }
+
+    // The pool still runs jobs.
+    JobPtr compute = manager.addJob ( [] ( JobPtr ) {} );
+    compute->wait();
+    REQUIRE ( ( manager.getNumJobsRunning() >= 4 ) );
+
+    release = true;
+    manager.waitAll();
+  }
+
+  SECTION ( "A lane uses no more threads than it's allowed" )
+  {
+    manager.setMaxNumThreadsAllowed ( io, 2 );
+
+    AtomicUnsignedInt numRunning ( 0 );
+    AtomicUnsignedInt maxNumRunning ( 0 );
+    std::vector < JobPtr > jobs;
+    for ( unsigned int i = 0; i < 20; ++i )
+    {
+      JobPtr job ( new Job ( [ &numRunning, &maxNumRunning ] ( JobPtr )
+      {
+        const unsigned int num = ++numRunning;
+        unsigned int max = maxNumRunning;
+        while ( ( num > max ) && ( false == maxNumRunning.compare_exchange_weak ( max, num ) ) ) {}
+        std::this_thread::sleep_for ( Milliseconds ( 1 ) );
+        --numRunning;
+      } ) );
+      job->setLane ( io );
+      jobs.push_back ( job );
+    }
+    manager.addJobs ( jobs );
+    manager.waitAll();
+
+    REQUIRE ( ( maxNumRunning <= 2 ) );
+    REQUIRE ( ( std::all_of ( jobs.begin(), jobs.end(), [] ( const JobPtr &job ) { return job->hasStarted(); } ) ) );
+  }
+
+  SECTION ( "A lane with a smaller maximum still runs new jobs" )
+  {
+    // Start all four of the lane's threads.
+    AtomicUnsignedInt numStarted ( 0 );
+    for ( unsigned int i = 0; i < 4; ++i )
+    {
+      manager.addJob ( io, [ &numStarted, &block ] ( JobPtr )
+      {
+        ++numStarted;
+        block();
+      } );
+    }
+    while ( numStarted < 4 )
+    {
+      std::this_thread::sleep_for ( Milliseconds ( 1 ) );
+    }
+    release = true;
+    manager.waitAll();
+
+    // The threads beyond the new maximum must not take the wake-ups.
+    manager.setMaxNumThreadsAllowed ( io, 1 );
+    for ( unsigned int i = 0; i < 20; ++i )
+    {
+      JobPtr job = manager.addJob ( io, [] ( JobPtr ) {} );
+      for ( unsigned int j = 0; ( j < 5000 ) && ( false == job->isDone() ); ++j )
+      {
+        std::this_thread::sleep_for ( Milliseconds ( 1 ) );
+      }
+      REQUIRE ( ( true == job->isDone() ) );
+    }
+  }
+
+  SECTION ( "A list with jobs in a lane adds none of them if it throws" )
+  {
+    JobPtr inLane ( new Job ( [] ( JobPtr ) {} ) );
+    inLane->setLane ( io );
+    JobPtr inPool ( new Job ( [] ( JobPtr ) {} ) );
+    JobPtr another ( new Job ( [] ( JobPtr ) {} ) );
+
+    // The same job twice.
+    Manager::Jobs jobs;
+    jobs.push_back ( inLane );
+    jobs.push_back ( inPool );
+    jobs.push_back ( inPool );
+    REQUIRE_THROWS ( manager.addJobs ( jobs ) );
+    REQUIRE ( ( 0 == manager.getNumJobs() ) );
+
+    // More jobs for the pool than the queue can hold.
+    manager.setMaxNumJobsQueued ( 1 );
+    jobs.back() = another;
+    REQUIRE_THROWS_AS ( manager.addJobs ( jobs ), std::invalid_argument );
+    REQUIRE ( ( 0 == manager.getNumJobs() ) );
+
+    std::this_thread::sleep_for ( Milliseconds ( 10 ) );
+    REQUIRE ( ( false == inLane->hasStarted() ) );
+    REQUIRE ( ( false == inPool->hasStarted() ) );
+
+    // They can be added after that, and each is traced once.
+    manager.setMaxNumJobsQueued ( 10 );
+    manager.setTracing ( true );
+    manager.addJobs ( jobs );
+    manager.waitAll();
+    REQUIRE ( ( true == inLane->hasStarted() ) );
+    REQUIRE ( ( true == another->hasStarted() ) );
+
+    std::ostringstream out;
+    manager.writeTrace ( out );
+    const std::string json ( out.str() );
+    unsigned int numEnqueued = 0;
+    for ( std::size_t i = json.find ( "\"cat\":\"enqueue\"" ); std::string::npos != i; i = json.find ( "\"cat\":\"enqueue\"", i + 1 ) )
+    {
+      ++numEnqueued;
+    }
+    REQUIRE ( ( 3 == numEnqueued ) );
+  }
+
+  SECTION ( "Jobs in a lane can wait for other jobs and be cleared" )
+  {
+    manager.setMaxNumThreadsAllowed ( io, 1 );
+
+    // The lane's only thread is busy with this one.
+    std::atomic < bool > started ( false );
+    JobPtr first = manager.addJob ( io, [ &started, &block ] ( JobPtr )
+    {
+      started = true;
+      block();
+    } );
+    while ( false == started )
+    {
+      std::this_thread::sleep_for ( Milliseconds ( 1 ) );
+    }
+
+    // This one waits for a job in the pool.
+    JobPtr second ( new Job ( [] ( JobPtr ) {} ) );
+    second->setLane ( io );
+    JobPtr before = manager.addJob ( [] ( JobPtr ) {} );
+    manager.addJob ( second, Manager::Jobs ( 1, before ) );
+
+    // Then it's in the lane's queue.
+    before->wait();
+    while ( 0 == manager.getNumJobsQueued() )
+    {
+      std::this_thread::sleep_for ( Milliseconds ( 1 ) );
+    }
+    REQUIRE ( ( 1 == manager.getQueuedJobNames().size() ) );
+
+    manager.clearQueuedJobs();
+    REQUIRE ( ( true == second->isDone() ) );
+    REQUIRE ( ( false == second->hasStarted() ) );
+
+    release = true;
+    manager.waitAll();
+    REQUIRE ( ( true == first->isDone() ) );
+  }
+
+  SECTION ( "Removing a job from a lane marks it done" )
+  {
+    manager.setMaxNumThreadsAllowed ( io, 1 );
+
+    // The lane's only thread is busy with this one.
+    std::atomic < bool > started ( false );
+    JobPtr first = manager.addJob ( io, [ &started, &block ] ( JobPtr )
+    {
+      started = true;
+      block();
+    } );
+    while ( false == started )
+    {
+      std::this_thread::sleep_for ( Milliseconds ( 1 ) );
+    }
+
+    // This one stays in the lane's queue, and a job in the pool waits for it.
+    AtomicUnsignedInt count ( 0 );
+    JobPtr second = manager.addJob ( io, [ &count ] ( JobPtr ) { ++count; } );
+    JobPtr third = manager.addJob ( [ &count ] ( JobPtr ) { ++count; }, Manager::Jobs ( 1, second ) );
+    REQUIRE ( ( 1 == manager.getNumJobsQueued() ) );
+
+    REQUIRE ( ( true == manager.removeQueuedJob ( second ) ) );
+    REQUIRE ( ( false == manager.removeQueuedJob ( second ) ) );
+    second->wait();
+    REQUIRE ( ( false == second->hasStarted() ) );
+
+    release = true;
+    manager.waitAll();
+    REQUIRE ( ( true == third->isDone() ) );
+    REQUIRE ( ( 1 == count ) );
+    REQUIRE ( ( 0 == manager.getNumJobs() ) );
+  }
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Test where the threads run.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+TEST_CASE ( "Job manager affinity" )
+{
+  typedef Usul::Jobs::Manager Manager;
+  typedef Manager::JobPtr JobPtr;
+  typedef Usul::System::Processors Processors;
+
+  Manager manager;
+  manager.setMaxNumThreadsAllowed ( 2 );
+  REQUIRE ( ( Manager::AFFINITY_NONE == manager.getAffinity() ) );
+
+  const Processors::Indices available = Processors::getAvailable();
+
+  // Return the processors that a job in the lane can run on.
+  auto getProcessors = [ &manager ] ( Manager::Lane lane )
+  {
+    Processors::Indices processors;
+    manager.addJob ( lane, [ &processors ] ( JobPtr )
+    {
+      processors = Processors::getAvailable();
+    } )->wait();
+    return processors;
+  };
+
+  SECTION ( "Threads in the pool run anywhere by default" )
+  {
+    REQUIRE ( ( available == getProcessors ( Manager::DEFAULT_LANE ) ) );
+  }
+
+  #ifdef __linux__
+
+  SECTION ( "Threads in the pool can be pinned and unpinned" )
+  {
+    manager.setAffinity ( Manager::AFFINITY_PROCESSOR );
+    REQUIRE ( ( Manager::AFFINITY_PROCESSOR == manager.getAffinity() ) );
+    REQUIRE ( ( 1 == getProcessors ( Manager::DEFAULT_LANE ).size() ) );
+
+    manager.setAffinity ( Manager::AFFINITY_NODE );
+    const Processors::Indices processors = getProcessors ( Manager::DEFAULT_LANE );
+    REQUIRE ( ( false == processors.empty() ) );
+    REQUIRE ( ( processors.size() <= available.size() ) );
+
+    manager.setAffinity ( Manager::AFFINITY_NONE );
+    REQUIRE ( ( available == getProcessors ( Manager::DEFAULT_LANE ) ) );
+  }
+
+  #endif
+
+  SECTION ( "Jobs in a node's lane run on that node" )
+  {
+    const Manager::Lane lane = manager.getNodeLane ( 0 );
+    REQUIRE ( ( lane == manager.getNodeLane ( 0 ) ) );
+    REQUIRE ( ( "node 0" == manager.getLaneName ( lane ) ) );
+    REQUIRE ( ( manager.getMaxNumThreadsAllowed ( lane ) >= 1 ) );
+    REQUIRE ( ( manager.getMaxNumThreadsAllowed ( lane ) <= Processors::getNodeProcessors ( 0 ).size() ) );
+    REQUIRE ( ( manager.getMaxNumThreadsAllowed ( lane ) <= manager.getMaxNumThreadsAllowed() ) );
+    REQUIRE_THROWS_AS ( manager.getNodeLane ( Processors::getNumNodes() ), std::invalid_argument );
+
+    #ifdef __linux__
+    REQUIRE ( ( Processors::getNodeProcessors ( 0 ) == getProcessors ( lane ) ) );
+    #endif
+  }
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Test adapting the number of threads.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+TEST_CASE ( "Job manager adapts the number of threads" )
+{
+  typedef Usul::Jobs::Manager Manager;
+  typedef Manager::JobPtr JobPtr;
+  typedef std::chrono::milliseconds Milliseconds;
+
+  Manager manager;
+  manager.setMaxNumThreadsAllowed ( 1 );
+
+  REQUIRE ( ( false == manager.isAdaptingNumThreads() ) );
+  REQUIRE_THROWS_AS ( manager.adaptNumThreads ( 0, 4 ), std::invalid_argument );
+  REQUIRE_THROWS_AS ( manager.adaptNumThreads ( 4, 2 ), std::invalid_argument );
+  REQUIRE_THROWS_AS ( manager.adaptNumThreads ( 1, 4, 0 ), std::invalid_argument );
+  REQUIRE ( ( false == manager.isAdaptingNumThreads() ) );
+
+  // Poll until the maximum number of threads is what we want.
+  auto waitForMax = [ &manager ] ( std::function < bool ( unsigned int ) > done )
+  {
+    for ( unsigned int i = 0; i < 5000; ++i )
+    {
+      if ( true == done ( manager.getMaxNumThreadsAllowed() ) )
+      {
+        return true;
+      }
+      std::this_thread::sleep_for ( Milliseconds ( 1 ) );
+    }
+    return false;
+  };
+
+  SECTION ( "Starts within the bounds" )
+  {
+    manager.adaptNumThreads ( 3, 5, 1000 );
+    REQUIRE ( ( true == manager.isAdaptingNumThreads() ) );
+    REQUIRE ( ( 3 == manager.getMaxNumThreadsAllowed() ) );
+
+    manager.stopAdaptingNumThreads();
+    REQUIRE ( ( false == manager.isAdaptingNumThreads() ) );
+  }
+
+  SECTION ( "Grows for jobs that block and shrinks when they are done" )
+  {
+    manager.adaptNumThreads ( 1, 8, 10 );
+
+    // These jobs spend all their time sleeping, so more threads help.
+    for ( unsigned int i = 0; i < 200; ++i )
+    {
+      manager.addJob ( [] ( JobPtr )
+      {
+        std::this_thread::sleep_for ( Milliseconds ( 5 ) );
+      } );
+    }
+
+    REQUIRE ( ( true == waitForMax ( [] ( unsigned int num ) { return ( num > 1 ); } ) ) );
+
+    manager.waitAll();
+    REQUIRE ( ( manager.getMaxNumThreadsAllowed() <= 8 ) );
+
+    // Clearing the jobs does not stop it.
+    manager.clearQueuedJobs();
+    REQUIRE ( ( true == manager.isAdaptingNumThreads() ) );
+
+    REQUIRE ( ( true == waitForMax ( [] ( unsigned int num ) { return ( 1 == num ); } ) ) );
+  }
+
+  SECTION ( "Stopping keeps the number it has" )
+  {
+    manager.adaptNumThreads ( 2, 2, 1 );
+    manager.stopAdaptingNumThreads();
+    manager.setMaxNumThreadsAllowed ( 6 );
+    std::this_thread::sleep_for ( Milliseconds ( 20 ) );
+    REQUIRE ( ( 6 == manager.getMaxNumThreadsAllowed() ) );
+  }
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Run many jobs with the thread models, and from many adding threads.
+//  How fast they run is measured by usul_bench_jobs.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+TEST_CASE ( "Job manager runs many jobs" )
+{
+  typedef Usul::Jobs::Manager Manager;
+  typedef Manager::JobPtr JobPtr;
+  typedef std::atomic < unsigned int > AtomicUnsignedInt;
+
+  Manager manager;
+  manager.setNumMillisecondsToSleep ( 1 );
+
+  // Run this many empty jobs with the given thread model.
+  auto run = [ &manager ] ( Manager::ThreadModel model, unsigned int numJobs, bool batch )
+  {
+    manager.setThreadModel ( model );
+
+    AtomicUnsignedInt count ( 0 );
+
+    const Manager::Callback cb = [ &count ] ( JobPtr )
+    {
+      ++count;
+    };
+
+    if ( true == batch )
+    {
+      manager.addJobs ( Manager::Callbacks ( numJobs, cb ) );
+    }
+    else
+    {
+      for ( unsigned int i = 0; i < numJobs; ++i )
+      {
+        manager.addJob ( cb );
+      }
+    }
+
+    manager.waitAll();
+
+    REQUIRE ( ( numJobs == count ) );
+  };
+
+  const unsigned int numJobs = 500;
+  run ( Manager::THREAD_PER_JOB, numJobs, false );
+  run ( Manager::THREAD_POOL, numJobs, false );
+  run ( Manager::THREAD_POOL, numJobs, true );
+
+  // Many threads adding jobs at once.
+  manager.setThreadModel ( Manager::THREAD_POOL );
+  const unsigned int numProducers[] = { 1, 4, 32 };
+  for ( unsigned int numThreads : numProducers )
+  {
+    AtomicUnsignedInt count ( 0 );
+    const unsigned int numJobsEach = 200;
+
+    std::vector < std::thread > producers;
+    for ( unsigned int i = 0; i < numThreads; ++i )
+    {
+      producers.emplace_back ( [ &manager, &count ] ()
+      {
+        for ( unsigned int j = 0; j < numJobsEach; ++j )
+        {
+          manager.addJob ( [ &count ] ( JobPtr ) { ++count; } );
+        }
+      } );
+    }
+    for ( auto i = producers.begin(); i != producers.end(); ++i )
+    {
+      i->join();
+    }
+
+    manager.waitAll();
+    REQUIRE ( ( ( numThreads * numJobsEach ) == count ) );
+  }
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Run a recursive fork/join workload with both schedulers. How fast it
+//  runs is measured by usul_bench_jobs.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+TEST_CASE ( "Job manager fork and join" )
+{
+  typedef Usul::Jobs::Manager Manager;
+  typedef Manager::JobPtr JobPtr;
+  typedef std::atomic < unsigned int > AtomicUnsignedInt;
+  typedef std::function < void ( unsigned int ) > Split;
+
+  const Manager::Scheduler scheduler = GENERATE ( Manager::SCHEDULER_SHARED_QUEUE, Manager::SCHEDULER_WORK_STEALING );
+
+  Manager manager;
+  manager.setMaxNumThreadsAllowed ( 4 );
+  manager.setScheduler ( scheduler );
+  REQUIRE ( ( scheduler == manager.getScheduler() ) );
+
+  // Each job splits in two until it reaches the bottom of the tree.
+  const unsigned int depth = 12;
+  AtomicUnsignedInt numLeaves ( 0 );
+  Split split;
+  split = [ &manager, &numLeaves, &split, depth ] ( unsigned int level )
+  {
+    if ( level == depth )
+    {
+      ++numLeaves;
+      return;
+    }
+
+    manager.addJob ( [ &split, level ] ( JobPtr ) { split ( level + 1 ); } );
+    manager.addJob ( [ &split, level ] ( JobPtr ) { split ( level + 1 ); } );
+  };
+
+  manager.addJob ( [ &split ] ( JobPtr ) { split ( 0 ); } );
+  manager.waitAll();
+
+  // The jobs in the deques are counted so waitAll() waits for all of them.
+  REQUIRE ( ( ( 1u << depth ) == numLeaves ) );
+  REQUIRE ( ( 0 == manager.getNumJobs() ) );
+
+  // The scheduler can not change when there are jobs.
+  std::atomic < bool > finish ( false );
+  manager.addJob ( [ &finish ] ( JobPtr )
+  {
+    while ( false == finish )
+    {
+      std::this_thread::sleep_for ( std::chrono::milliseconds ( 1 ) );
+    }
+  } );
+  REQUIRE_THROWS ( manager.setScheduler ( Manager::SCHEDULER_SHARED_QUEUE == scheduler ?
+    Manager::SCHEDULER_WORK_STEALING : Manager::SCHEDULER_SHARED_QUEUE ) );
+  finish = true;
+  manager.waitAll();
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Jobs that wait for the jobs they make, with fewer threads than levels.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+TEST_CASE ( "Job manager runs queued jobs while a pool thread waits" )
+{
+  typedef Usul::Jobs::Manager Manager;
+  typedef Usul::Jobs::Job Job;
+  typedef Usul::Jobs::Group Group;
+  typedef Manager::JobPtr JobPtr;
+  typedef std::atomic < unsigned int > AtomicUnsignedInt;
+  typedef std::function < void ( unsigned int ) > Split;
+
+  const Manager::Scheduler scheduler = GENERATE ( Manager::SCHEDULER_SHARED_QUEUE, Manager::SCHEDULER_WORK_STEALING );
+  const unsigned int numThreads = GENERATE ( 1u, 2u );
+
+  Manager manager;
+  manager.setMaxNumThreadsAllowed ( numThreads );
+  manager.setScheduler ( scheduler );
+
+  // The pool is started by the first job.
+  manager.addJob ( [] ( JobPtr ) {} );
+  manager.waitAll();
+
+  // Each job makes two more and waits for them, so without the waiting
+  // threads running them this would never finish.
+  const unsigned int depth = 8;
+  AtomicUnsignedInt numLeaves ( 0 );
+
+  SECTION ( "Outside of the pool there is nothing to help with" )
+  {
+    REQUIRE ( false == Manager::isPoolThread() );
+    REQUIRE ( false == Manager::runQueuedJob() );
+
+    bool inPool = false;
+    manager.addJob ( [ &inPool ] ( JobPtr ) { inPool = Manager::isPoolThread(); } );
+    manager.waitAll();
+    REQUIRE ( true == inPool );
+  }
+
+  SECTION ( "The jobs that a thread is running inside of are still running" )
+  {
+    // The only thread runs the inner job while the outer one waits for it.
+    manager.setMaxNumThreadsAllowed ( 1 );
+
+    std::atomic < bool > started ( false );
+    std::atomic < bool > release ( false );
+    USUL_SCOPED_CALL ( [ &release ] ()
+    {
+      release = true;
+    } );
+
+    JobPtr inner ( new Job ( "inner", [ &started, &release ] ( JobPtr )
+    {
+      started = true;
+      while ( false == release )
+      {
+        std::this_thread::sleep_for ( std::chrono::milliseconds ( 1 ) );
+      }
+    } ) );
+    JobPtr outer ( new Job ( "outer", [ &manager, inner ] ( JobPtr )
+    {
+      manager.addJob ( inner );
+      inner->wait();
+    } ) );
+    manager.addJob ( outer );
+
+    while ( false == started )
+    {
+      std::this_thread::sleep_for ( std::chrono::milliseconds ( 1 ) );
+    }
+
+    const Manager::Names names = manager.getRunningJobNames();
+    REQUIRE ( ( names.end() != std::find ( names.begin(), names.end(), "inner" ) ) );
+    REQUIRE ( ( names.end() != std::find ( names.begin(), names.end(), "outer" ) ) );
+
+    manager.cancelRunningJobs();
+    release = true;
+    manager.waitAll();
+    REQUIRE ( ( true == inner->isCancelled() ) );
+    REQUIRE ( ( true == outer->isCancelled() ) );
+  }
+
+  SECTION ( "Wait for the jobs" )
+  {
+    Split split;
+    split = [ &manager, &numLeaves, &split, depth ] ( unsigned int level )
+    {
+      if ( level == depth )
+      {
+        ++numLeaves;
+        return;
+      }
+
+      JobPtr a = manager.addJob ( [ &split, level ] ( JobPtr ) { split ( level + 1 ); } );
+      JobPtr b = manager.addJob ( [ &split, level ] ( JobPtr ) { split ( level + 1 ); } );
+      a->wait();
+      b->waitFor ( 60000 );
+    };
+
+    manager.addJob ( [ &split ] ( JobPtr ) { split ( 0 ); } );
+    manager.waitAll();
+
+    REQUIRE ( ( ( 1u << depth ) == numLeaves ) );
+  }
+
+  SECTION ( "Wait for a group of jobs" )
+  {
+    // A group has no one job to run first, so the waiting threads run the
+    // oldest queued jobs, across the tree. Keep it small enough that they
+    // do not go deeper than the limit.
+    const unsigned int groupDepth = 5;
+
+    Split split;
+    split = [ &manager, &numLeaves, &split, groupDepth ] ( unsigned int level )
+    {
+      if ( level == groupDepth )
+      {
+        ++numLeaves;
+        return;
+      }
+
+      Group::Ptr group ( new Group );
+      for ( unsigned int i = 0; i < 2; ++i )
+      {
+        JobPtr job ( new Job ( [ &split, level ] ( JobPtr ) { split ( level + 1 ); } ) );
+        job->setGroup ( group );
+        manager.addJob ( job );
+      }
+      group->wait();
+    };
+
+    manager.addJob ( [ &split ] ( JobPtr ) { split ( 0 ); } );
+    manager.waitAll();
+
+    REQUIRE ( ( ( 1u << groupDepth ) == numLeaves ) );
+  }
+
+  SECTION ( "Wait for the future values" )
+  {
+    std::function < unsigned int ( unsigned int ) > count;
+    count = [ &manager, &count, depth ] ( unsigned int level ) -> unsigned int
+    {
+      if ( level == depth )
+      {
+        return 1;
+      }
+
+      auto a = manager.submit ( [ &count, level ] () { return count ( level + 1 ); } );
+      auto b = manager.submit ( [ &count, level ] () { return count ( level + 1 ); } );
+      return a.get() + b.get();
+    };
+
+    REQUIRE ( ( ( 1u << depth ) == manager.submit ( [ &count ] () { return count ( 0 ); } ).get() ) );
+
+    // The value is ready before the manager is done with the job.
+    manager.waitAll();
+  }
+
+  REQUIRE ( ( 0 == manager.getNumJobs() ) );
 }
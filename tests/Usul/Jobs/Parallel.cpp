@@ -0,0 +1,188 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Copyright (c) 2020, Perry L Miller IV
+//  All rights reserved.
+//  MIT License: https://opensource.org/licenses/mit-license.html
+//
+////////////////////////////////////////////////////////////////////////////////
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Test the parallel algorithms.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "Usul/Jobs/Parallel.h"
+#include "Usul/Tools/ScopedCall.h"
+
+#include "catch2/catch.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Test the parallel algorithms.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+TEST_CASE ( "Parallel algorithms" )
+{
+  typedef Usul::Jobs::Manager Manager;
+  typedef Manager::JobPtr JobPtr;
+  typedef std::vector < unsigned int > Numbers;
+
+  Manager manager;
+  manager.setMaxNumThreadsAllowed ( 4 );
+
+  // Try different grains, including zero which picks one.
+  const unsigned int grain = GENERATE ( 0u, 1u, 7u, 100000u );
+
+  SECTION ( "Parallel for visits each index once" )
+  {
+    const unsigned int size = 10000;
+    std::vector < std::atomic < unsigned int > > counts ( size );
+
+    Usul::Jobs::parallelFor ( manager, 0u, size, grain, [ &counts ] ( unsigned int i )
+    {
+      ++counts[i];
+    } );
+
+    for ( unsigned int i = 0; i < size; ++i )
+    {
+      REQUIRE ( ( 1 == counts[i] ) );
+    }
+
+    // An empty range does nothing.
+    Usul::Jobs::parallelFor ( manager, 5u, 5u, grain, [] ( unsigned int )
+    {
+      throw std::runtime_error ( "Should not get here" );
+    } );
+  }
+
+  SECTION ( "Parallel reduce gives the same answer as a loop" )
+  {
+    Numbers numbers ( 12345 );
+    std::iota ( numbers.begin(), numbers.end(), 0u );
+
+    const unsigned long long answer = Usul::Jobs::parallelReduce ( manager, std::size_t ( 0 ), numbers.size(), std::size_t ( grain ), 0ull,
+      [ &numbers ] ( std::size_t first, std::size_t last, unsigned long long sum )
+      {
+        for ( std::size_t i = first; i < last; ++i )
+        {
+          sum += numbers[i];
+        }
+        return sum;
+      },
+      [] ( unsigned long long a, unsigned long long b )
+      {
+        return a + b;
+      } );
+
+    REQUIRE ( ( std::accumulate ( numbers.begin(), numbers.end(), 0ull ) == answer ) );
+  }
+
+  SECTION ( "Parallel transform in place" )
+  {
+    Numbers numbers ( 5000 );
+    std::iota ( numbers.begin(), numbers.end(), 0u );
+
+    Usul::Jobs::parallelTransform ( manager, numbers.begin(), numbers.end(), numbers.begin(), grain, [] ( unsigned int i )
+    {
+      return 2 * i;
+    } );
+
+    for ( unsigned int i = 0; i < numbers.size(); ++i )
+    {
+      REQUIRE ( ( 2 * i == numbers[i] ) );
+    }
+  }
+
+  SECTION ( "The first exception is thrown in the calling thread" )
+  {
+    REQUIRE_THROWS_WITH ( Usul::Jobs::parallelFor ( manager, 0u, 1000u, grain, [] ( unsigned int i )
+    {
+      if ( 500 == i )
+      {
+        throw std::runtime_error ( "Index 500" );
+      }
+    } ), "Index 500" );
+  }
+
+  SECTION ( "Parallel for works from inside a job" )
+  {
+    std::atomic < unsigned int > count ( 0 );
+
+    // Use every thread so that the calling jobs have to do the work.
+    for ( unsigned int i = 0; i < manager.getMaxNumThreadsAllowed(); ++i )
+    {
+      manager.addJob ( [ &manager, &count, grain ] ( JobPtr )
+      {
+        Usul::Jobs::parallelFor ( manager, 0u, 1000u, grain, [ &count ] ( unsigned int )
+        {
+          ++count;
+        } );
+      } );
+    }
+
+    manager.waitAll();
+    REQUIRE ( ( 4000 == count ) );
+  }
+
+  SECTION ( "Parallel for does not wait for room in a small or full queue" )
+  {
+    manager.setMaxNumJobsQueued ( 1 );
+    USUL_SCOPED_CALL ( [ &manager ] () { manager.setMaxNumJobsQueued ( std::numeric_limits < unsigned int >::max() ); } );
+
+    // There is room for fewer helpers than threads.
+    {
+      std::atomic < unsigned int > count ( 0 );
+      Usul::Jobs::parallelFor ( manager, 0u, 1000u, grain, [ &count ] ( unsigned int )
+      {
+        ++count;
+      } );
+      REQUIRE ( ( 1000 == count ) );
+    }
+
+    // Keep the only thread busy and fill the queue.
+    const unsigned int maxNumThreads = manager.getMaxNumThreadsAllowed();
+    manager.setMaxNumThreadsAllowed ( 1 );
+    USUL_SCOPED_CALL ( ( [ &manager, maxNumThreads ] () { manager.setMaxNumThreadsAllowed ( maxNumThreads ); } ) );
+
+    std::atomic < bool > finish ( false );
+    manager.addJob ( [ &finish ] ( JobPtr )
+    {
+      while ( false == finish )
+      {
+        std::this_thread::sleep_for ( std::chrono::milliseconds ( 1 ) );
+      }
+    } );
+    USUL_SCOPED_CALL ( [ &finish ] ()
+    {
+      finish = true;
+    } );
+    while ( 0 == manager.getNumJobsRunning() )
+    {
+      std::this_thread::yield();
+    }
+    manager.addJob ( [] ( JobPtr ) {} );
+    REQUIRE ( ( 1 == manager.getNumJobsQueued() ) );
+
+    // This thread does all the work.
+    std::atomic < unsigned int > count ( 0 );
+    Usul::Jobs::parallelFor ( manager, 0u, 1000u, grain, [ &count ] ( unsigned int )
+    {
+      ++count;
+    } );
+    REQUIRE ( ( 1000 == count ) );
+
+    finish = true;
+    manager.waitAll();
+  }
+}
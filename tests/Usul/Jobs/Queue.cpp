@@ -0,0 +1,245 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Copyright (c) 2020, Perry L Miller IV
+//  All rights reserved.
+//  MIT License: https://opensource.org/licenses/mit-license.html
+//
+////////////////////////////////////////////////////////////////////////////////
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Test the priority queue of jobs.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "Usul/Jobs/Queue.h"
+#include "Usul/Math/Random.h"
+
+#include "catch2/catch.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <limits>
+#include <thread>
+#include <vector>
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Test the priority queue of jobs.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+TEST_CASE ( "Job queue" )
+{
+  typedef Usul::Jobs::Queue Queue;
+  typedef Usul::Jobs::Job Job;
+  typedef Job::Ptr JobPtr;
+  typedef std::vector < JobPtr > Jobs;
+
+  Queue::Mutex mutex;
+  Queue queue ( mutex );
+
+  // Pop all the jobs and return them in the order they came out.
+  auto popAll = [ &queue ] ()
+  {
+    Jobs jobs;
+    while ( false == queue.empty() )
+    {
+      jobs.push_back ( queue.pop() );
+    }
+    return jobs;
+  };
+
+  SECTION ( "An empty queue returns null" )
+  {
+    REQUIRE ( ( true == queue.empty() ) );
+    REQUIRE ( ( 0 == queue.size() ) );
+    REQUIRE ( ( nullptr == queue.pop().get() ) );
+  }
+
+  SECTION ( "Jobs come out in priority order" )
+  {
+    for ( unsigned int i = 0; i < 1000; ++i )
+    {
+      const double priority = Usul::Math::random ( -1000.0, 1000.0 );
+      queue.push ( JobPtr ( new Job ( "", priority, Job::Callback() ) ) );
+    }
+    REQUIRE ( ( 1000 == queue.size() ) );
+
+    const Jobs jobs = popAll();
+    REQUIRE ( ( 1000 == jobs.size() ) );
+    REQUIRE ( ( true == std::is_sorted ( jobs.begin(), jobs.end(), [] ( JobPtr a, JobPtr b )
+    {
+      return ( a->getPriority() > b->getPriority() );
+    } ) ) );
+  }
+
+  SECTION ( "Jobs with the same priority come out in the order they went in" )
+  {
+    Jobs jobs;
+    for ( unsigned int i = 0; i < 100; ++i )
+    {
+      jobs.push_back ( JobPtr ( new Job ( "", ( i % 2 ), Job::Callback() ) ) );
+      queue.push ( jobs.back() );
+    }
+
+    const Jobs answer = popAll();
+    for ( unsigned int i = 0; i < 50; ++i )
+    {
+      REQUIRE ( ( jobs.at ( 2 * i + 1 ) == answer.at ( i ) ) );
+      REQUIRE ( ( jobs.at ( 2 * i ) == answer.at ( 50 + i ) ) );
+    }
+  }
+
+  SECTION ( "Changing the priority of a queued job moves it" )
+  {
+    Jobs jobs;
+    for ( unsigned int i = 0; i < 100; ++i )
+    {
+      jobs.push_back ( JobPtr ( new Job ( "", i, Job::Callback() ) ) );
+      queue.push ( jobs.back() );
+    }
+
+    // Move one to the front and one to the back.
+    jobs.at ( 10 )->setPriority ( 1000 );
+    jobs.at ( 90 )->setPriority ( -1000 );
+
+    const Jobs answer = popAll();
+    REQUIRE ( ( jobs.at ( 10 ) == answer.front() ) );
+    REQUIRE ( ( jobs.at ( 99 ) == answer.at ( 1 ) ) );
+    REQUIRE ( ( jobs.at ( 90 ) == answer.back() ) );
+
+    // Jobs that are no longer queued can still change.
+    jobs.at ( 10 )->setPriority ( 5 );
+    REQUIRE ( ( 5 == jobs.at ( 10 )->getPriority() ) );
+  }
+
+  SECTION ( "Remove jobs" )
+  {
+    JobPtr a ( new Job ( "a", 1, Job::Callback() ) );
+    JobPtr b ( new Job ( "b", 2, Job::Callback() ) );
+    JobPtr c ( new Job ( "c", 3, Job::Callback() ) );
+    queue.push ( a );
+    queue.push ( b );
+    queue.push ( c );
+
+    // A job can only be in the queue once.
+    REQUIRE_THROWS ( queue.push ( b ) );
+
+    REQUIRE ( ( true == queue.remove ( b ) ) );
+    REQUIRE ( ( false == queue.remove ( b ) ) );
+    REQUIRE ( ( 2 == queue.size() ) );
+
+    REQUIRE ( ( c == queue.pop() ) );
+    REQUIRE ( ( a == queue.pop() ) );
+
+    // Now it can go back in.
+    queue.push ( b );
+    REQUIRE ( ( b == queue.pop() ) );
+  }
+
+  SECTION ( "Clear the queue" )
+  {
+    for ( unsigned int i = 0; i < 10; ++i )
+    {
+      queue.push ( JobPtr ( new Job ( "", i, Job::Callback() ) ) );
+    }
+
+    Queue::Jobs removed;
+    queue.clear ( removed );
+    REQUIRE ( ( 10 == removed.size() ) );
+    REQUIRE ( ( true == queue.empty() ) );
+
+    // They are no longer in the queue.
+    REQUIRE ( ( false == queue.remove ( removed.front() ) ) );
+  }
+
+  SECTION ( "Rebuild the queue" )
+  {
+    for ( unsigned int i = 0; i < 100; ++i )
+    {
+      queue.push ( JobPtr ( new Job ( "", i, Job::Callback() ) ) );
+    }
+
+    queue.rebuild();
+
+    const Jobs jobs = popAll();
+    REQUIRE ( ( 99 == jobs.front()->getPriority() ) );
+    REQUIRE ( ( 0 == jobs.back()->getPriority() ) );
+  }
+
+  SECTION ( "Earliest deadline first" )
+  {
+    typedef Job::Clock Clock;
+    typedef std::chrono::milliseconds Milliseconds;
+
+    queue.setPolicy ( Queue::POLICY_DEADLINE );
+    REQUIRE ( ( Queue::POLICY_DEADLINE == queue.getPolicy() ) );
+
+    const Clock::time_point now = Clock::now();
+    JobPtr late ( new Job ( "late", 100, Job::Callback() ) );
+    JobPtr soon ( new Job ( "soon", 0, Job::Callback() ) );
+    JobPtr none ( new Job ( "none", 1000, Job::Callback() ) );
+    JobPtr later ( new Job ( "later", 0, Job::Callback() ) );
+    late->setDeadline ( now + Milliseconds ( 50 ) );
+    soon->setDeadline ( now + Milliseconds ( 10 ) );
+    later->setDeadline ( now + Milliseconds ( 90 ) );
+    REQUIRE ( ( true == late->hasDeadline() ) );
+    REQUIRE ( ( false == none->hasDeadline() ) );
+
+    queue.push ( Jobs { late, none, soon, later } );
+
+    // Moving the deadline of a queued job moves it.
+    later->setDeadline ( now + Milliseconds ( 1 ) );
+
+    // Jobs without a deadline come last.
+    REQUIRE ( ( Jobs { later, soon, late, none } == popAll() ) );
+
+    // Changing the policy reorders them.
+    queue.push ( Jobs { late, none, soon, later } );
+    queue.setPolicy ( Queue::POLICY_PRIORITY );
+    REQUIRE ( ( Jobs { none, late, soon, later } == popAll() ) );
+
+    later->clearDeadline();
+    REQUIRE ( ( false == later->hasDeadline() ) );
+  }
+
+  SECTION ( "First in, first out" )
+  {
+    queue.setPolicy ( Queue::POLICY_FIFO );
+
+    Jobs jobs;
+    for ( unsigned int i = 0; i < 100; ++i )
+    {
+      jobs.push_back ( JobPtr ( new Job ( "", Usul::Math::random ( -1000.0, 1000.0 ), Job::Callback() ) ) );
+      queue.push ( jobs.back() );
+    }
+
+    REQUIRE ( ( jobs == popAll() ) );
+  }
+
+  SECTION ( "Old jobs get ahead of new ones with higher priority" )
+  {
+    queue.setPolicy ( Queue::POLICY_AGING );
+    queue.setAgingRate ( 1000 );
+    REQUIRE ( ( 1000 == queue.getAgingRate() ) );
+    REQUIRE_THROWS ( queue.setAgingRate ( std::numeric_limits < double >::infinity() ) );
+
+    JobPtr old ( new Job ( "old", 0, Job::Callback() ) );
+    queue.push ( old );
+
+    std::this_thread::sleep_for ( std::chrono::milliseconds ( 20 ) );
+
+    // It has waited long enough to gain more than 10.
+    JobPtr young ( new Job ( "young", 10, Job::Callback() ) );
+    queue.push ( young );
+    REQUIRE ( ( Jobs { old, young } == popAll() ) );
+
+    // Without aging the priority wins.
+    queue.push ( old );
+    queue.push ( young );
+    queue.setAgingRate ( 0 );
+    REQUIRE ( ( Jobs { young, old } == popAll() ) );
+  }
+}
@@ -0,0 +1,121 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Copyright (c) 2020, Perry L Miller IV
+//  All rights reserved.
+//  MIT License: https://opensource.org/licenses/mit-license.html
+//
+////////////////////////////////////////////////////////////////////////////////
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Test the bounded ring.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "Usul/Jobs/Ring.h"
+
+#include "catch2/catch.hpp"
+
+#include <atomic>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Test the bounded ring.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+TEST_CASE ( "Bounded ring" )
+{
+  typedef Usul::Jobs::Ring < int > Ring;
+
+  SECTION ( "The capacity has to be a power of two" )
+  {
+    REQUIRE_THROWS_AS ( Ring ( 0 ), std::invalid_argument );
+    REQUIRE_THROWS_AS ( Ring ( 3 ), std::invalid_argument );
+    REQUIRE ( ( 8 == Ring ( 8 ).capacity() ) );
+  }
+
+  SECTION ( "Items come out in the order they went in" )
+  {
+    Ring ring ( 4 );
+    int items[5] = { 0, 1, 2, 3, 4 };
+
+    REQUIRE ( ( nullptr == ring.pop() ) );
+
+    for ( unsigned int i = 0; i < 4; ++i )
+    {
+      REQUIRE ( ( true == ring.push ( &items[i] ) ) );
+    }
+
+    // It's full.
+    REQUIRE ( ( false == ring.push ( &items[4] ) ) );
+
+    REQUIRE ( ( &items[0] == ring.pop() ) );
+    REQUIRE ( ( true == ring.push ( &items[4] ) ) );
+
+    for ( unsigned int i = 1; i < 5; ++i )
+    {
+      REQUIRE ( ( &items[i] == ring.pop() ) );
+    }
+    REQUIRE ( ( nullptr == ring.pop() ) );
+  }
+
+  SECTION ( "Many threads push and pop" )
+  {
+    Ring ring ( 64 );
+
+    const unsigned int numThreads = 4;
+    const unsigned int numEach = 10000;
+    std::vector < int > items ( numThreads * numEach, 0 );
+    std::atomic < unsigned int > numPopped ( 0 );
+    std::atomic < long > sum ( 0 );
+
+    std::vector < std::thread > threads;
+    for ( unsigned int t = 0; t < numThreads; ++t )
+    {
+      // A producer.
+      threads.emplace_back ( [ &ring, &items, t, numEach ] ()
+      {
+        for ( unsigned int i = 0; i < numEach; ++i )
+        {
+          int *item = &items[t * numEach + i];
+          *item = static_cast < int > ( i );
+          while ( false == ring.push ( item ) )
+          {
+            std::this_thread::yield();
+          }
+        }
+      } );
+
+      // A consumer.
+      threads.emplace_back ( [ &ring, &numPopped, &sum, &items ] ()
+      {
+        while ( numPopped < items.size() )
+        {
+          int *item = ring.pop();
+          if ( nullptr == item )
+          {
+            std::this_thread::yield();
+            continue;
+          }
+          sum += *item;
+          ++numPopped;
+        }
+      } );
+    }
+
+    for ( auto i = threads.begin(); i != threads.end(); ++i )
+    {
+      i->join();
+    }
+
+    // Every item came out once.
+    const long expected = static_cast < long > ( numThreads ) * ( ( static_cast < long > ( numEach ) * ( numEach - 1 ) ) / 2 );
+    REQUIRE ( ( numThreads * numEach == numPopped ) );
+    REQUIRE ( ( expected == sum ) );
+  }
+}
@@ -0,0 +1,154 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Copyright (c) 2020, Perry L Miller IV
+//  All rights reserved.
+//  MIT License: https://opensource.org/licenses/mit-license.html
+//
+////////////////////////////////////////////////////////////////////////////////
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Test the timer wheel.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "Usul/Jobs/TimerWheel.h"
+
+#include "catch2/catch.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <vector>
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Test the timer wheel.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+TEST_CASE ( "Timer wheel" )
+{
+  typedef Usul::Jobs::TimerWheel < unsigned int > Wheel;
+  typedef Wheel::Tick Tick;
+  typedef Wheel::Items Items;
+
+  SECTION ( "An empty wheel has nothing to do" )
+  {
+    Wheel wheel;
+    REQUIRE ( ( true == wheel.empty() ) );
+    REQUIRE ( ( std::numeric_limits < Tick >::max() == wheel.next() ) );
+
+    Items due;
+    wheel.advance ( 1000000, due );
+    REQUIRE ( ( true == due.empty() ) );
+    REQUIRE ( ( 1000000 == wheel.now() ) );
+  }
+
+  SECTION ( "Items come out at their tick and not before" )
+  {
+    Wheel wheel ( 10 );
+    wheel.add ( 15, 1 );
+    wheel.add ( 100, 2 );
+    wheel.add ( 5000, 3 );
+    wheel.add ( 10, 4 ); // Already due.
+    REQUIRE ( ( 4 == wheel.size() ) );
+
+    Items due;
+    wheel.advance ( 14, due );
+    REQUIRE ( ( 1 == due.size() ) );
+    REQUIRE ( ( 4 == due[0].second ) );
+
+    // The next tick never goes past the soonest item.
+    REQUIRE ( ( wheel.next() <= 15 ) );
+
+    due.clear();
+    wheel.advance ( 99, due );
+    REQUIRE ( ( 1 == due.size() ) );
+    REQUIRE ( ( 1 == due[0].second ) );
+    REQUIRE ( ( 15 == due[0].first ) );
+
+    due.clear();
+    wheel.advance ( 4999, due );
+    REQUIRE ( ( 1 == due.size() ) );
+    REQUIRE ( ( 2 == due[0].second ) );
+
+    due.clear();
+    wheel.advance ( 5000, due );
+    REQUIRE ( ( 1 == due.size() ) );
+    REQUIRE ( ( 3 == due[0].second ) );
+    REQUIRE ( ( true == wheel.empty() ) );
+  }
+
+  SECTION ( "Random ticks come out in order when turned one tick at a time" )
+  {
+    std::mt19937 random ( 42 );
+    std::uniform_int_distribution < Tick > delay ( 1, 20000 );
+
+    Wheel wheel ( 123 );
+    std::vector < Tick > expected;
+    for ( unsigned int i = 0; i < 1000; ++i )
+    {
+      const Tick tick = 123 + delay ( random );
+      wheel.add ( tick, i );
+      expected.push_back ( tick );
+    }
+    std::sort ( expected.begin(), expected.end() );
+
+    Items due;
+    std::vector < Tick > actual;
+    for ( Tick now = 123; now <= 123 + 20000; ++now )
+    {
+      due.clear();
+      wheel.advance ( now, due );
+      for ( auto i = due.begin(); i != due.end(); ++i )
+      {
+        REQUIRE ( ( now == i->first ) );
+        actual.push_back ( i->first );
+      }
+    }
+
+    REQUIRE ( ( expected == actual ) );
+    REQUIRE ( ( true == wheel.empty() ) );
+  }
+
+  SECTION ( "Far away ticks need few turns" )
+  {
+    const Tick start = ( static_cast < Tick > ( 1 ) << 40 ) + 12345;
+    const Tick far = ( static_cast < Tick > ( 1 ) << 62 ) + 7;
+
+    Wheel wheel ( start );
+    wheel.add ( far, 1 );
+    wheel.add ( start + 1, 2 );
+
+    // Jump from one event to the next and count them.
+    Items due;
+    unsigned int numTurns = 0;
+    while ( false == wheel.empty() )
+    {
+      wheel.advance ( wheel.next(), due );
+      ++numTurns;
+    }
+
+    REQUIRE ( ( 2 == due.size() ) );
+    REQUIRE ( ( 2 == due[0].second ) );
+    REQUIRE ( ( far == due[1].first ) );
+    REQUIRE ( ( numTurns < 20 ) );
+  }
+
+  SECTION ( "Clear takes everything out" )
+  {
+    Wheel wheel;
+    wheel.add ( 0, 1 );
+    wheel.add ( 50, 2 );
+    wheel.add ( 500000, 3 );
+
+    Items removed;
+    wheel.clear ( removed );
+    REQUIRE ( ( 3 == removed.size() ) );
+    REQUIRE ( ( true == wheel.empty() ) );
+    REQUIRE ( ( std::numeric_limits < Tick >::max() == wheel.next() ) );
+  }
+}
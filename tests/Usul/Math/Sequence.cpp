@@ -13,6 +13,7 @@
 //
 ////////////////////////////////////////////////////////////////////////////////
 
+#include "Usul/Jobs/Sequence.h"
 #include "Usul/Math/Sequence.h"
 #include "Usul/Math/Constants.h"
 #include "Usul/Math/Matrix44.h"
@@ -20,6 +21,7 @@
 
 #include "catch2/catch.hpp"
 
+#include <algorithm>
 #include <sstream>
 #include <vector>
 
@@ -177,4 +179,46 @@ TEMPLATE_TEST_CASE ( "Functions for a sequence", "", float, double )
     Details::isEqualString ( b[3][1], oneOverSquareRootOfThree );
     Details::isEqualString ( b[3][2], oneOverSquareRootOfThree );
   }
+
+  SECTION ( "Can transform, normalize, and bound a large sequence with the job manager" )
+  {
+    typedef Usul::Math::Box < T > Box;
+
+    Usul::Jobs::Manager manager;
+    manager.setMaxNumThreadsAllowed ( 4 );
+
+    Sequence a;
+    for ( unsigned int i = 0; i < 10000; ++i )
+    {
+      a.push_back ( Vec3 ( SC ( i % 17 ) + SC ( 1 ), SC ( i % 13 ), SC ( i % 11 ) - SC ( 5 ) ) );
+    }
+
+    const Matrix44 m = Usul::Math::rotate ( Matrix44(), Vec3 ( SC ( 1 ), SC ( 0 ), SC ( 0 ) ), SC ( Usul::Math::PI_OVER_2 ) );
+
+    auto same = [] ( const Sequence &s1, const Sequence &s2 )
+    {
+      return std::equal ( s1.begin(), s1.end(), s2.begin(), s2.end(), [] ( const Vec3 &v1, const Vec3 &v2 )
+      {
+        return Usul::Math::equal ( v1, v2 );
+      } );
+    };
+
+    // The answers should be exactly the same as the serial ones.
+    Sequence b1, b2;
+    Usul::Math::transform ( m, a, b1 );
+    Usul::Math::transform ( manager, m, a, b2 );
+    REQUIRE ( same ( b1, b2 ) );
+
+    Usul::Math::normalize ( b1 );
+    Usul::Math::normalize ( manager, b2 );
+    REQUIRE ( same ( b1, b2 ) );
+
+    Box box1, box2;
+    Usul::Math::grow ( box1, a );
+    Usul::Math::grow ( manager, box2, a );
+    REQUIRE ( box1.valid() );
+    REQUIRE ( Usul::Math::equal ( box1, box2 ) );
+    REQUIRE ( Usul::Math::equal ( box1.getMin(), Vec3 ( SC ( 1 ), SC ( 0 ), SC ( -5 ) ) ) );
+    REQUIRE ( Usul::Math::equal ( box1.getMax(), Vec3 ( SC ( 17 ), SC ( 12 ), SC ( 5 ) ) ) );
+  }
 }
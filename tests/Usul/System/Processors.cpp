@@ -0,0 +1,110 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Copyright (c) 2020, Perry L Miller IV
+//  All rights reserved.
+//  MIT License: https://opensource.org/licenses/mit-license.html
+//
+////////////////////////////////////////////////////////////////////////////////
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Test the processor functions.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "Usul/System/Processors.h"
+
+#include "catch2/catch.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Test the processor functions.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+TEST_CASE ( "Processor functions" )
+{
+  typedef Usul::System::Processors Processors;
+
+  SECTION ( "Number available is at least one and not more than the hardware has" )
+  {
+    const unsigned int num = Processors::getNumAvailable();
+    REQUIRE ( num >= 1 );
+
+    const unsigned int has = std::thread::hardware_concurrency();
+    if ( has > 0 )
+    {
+      REQUIRE ( num <= has );
+    }
+  }
+
+  SECTION ( "Every processor of every node is available" )
+  {
+    const Processors::Indices available = Processors::getAvailable();
+    REQUIRE ( ( available.size() >= 1 ) );
+
+    const unsigned int numNodes = Processors::getNumNodes();
+    REQUIRE ( ( numNodes >= 1 ) );
+
+    std::size_t numInNodes = 0;
+    for ( unsigned int node = 0; node < numNodes; ++node )
+    {
+      const Processors::Indices processors = Processors::getNodeProcessors ( node );
+      for ( auto i = processors.begin(); i != processors.end(); ++i )
+      {
+        REQUIRE ( ( available.end() != std::find ( available.begin(), available.end(), *i ) ) );
+      }
+      numInNodes += processors.size();
+    }
+    REQUIRE ( ( available.size() == numInNodes ) );
+  }
+
+  #ifdef __linux__
+
+  SECTION ( "Can pin a thread to a processor" )
+  {
+    const Processors::Indices available = Processors::getAvailable();
+
+    // Do it in another thread so that this one is not changed.
+    Processors::Indices pinned;
+    bool result = false;
+    std::thread thread ( [ &available, &pinned, &result ] ()
+    {
+      result = Processors::setThreadAffinity ( Processors::Indices ( 1, available.back() ) );
+      pinned = Processors::getAvailable();
+    } );
+    thread.join();
+
+    REQUIRE ( ( true == result ) );
+    REQUIRE ( ( Processors::Indices ( 1, available.back() ) == pinned ) );
+    REQUIRE ( ( false == Processors::setThreadAffinity ( Processors::Indices() ) ) );
+  }
+
+  #endif
+
+  SECTION ( "Thread time goes up when computing and not when sleeping" )
+  {
+    const std::uint64_t start = Processors::getThreadTime();
+
+    // Spin for a while.
+    volatile unsigned int sum = 0;
+    const auto until = std::chrono::steady_clock::now() + std::chrono::milliseconds ( 50 );
+    while ( std::chrono::steady_clock::now() < until )
+    {
+      sum = sum + 1;
+    }
+
+    const std::uint64_t spun = Processors::getThreadTime();
+    REQUIRE ( spun > start );
+
+    std::this_thread::sleep_for ( std::chrono::milliseconds ( 100 ) );
+
+    const std::uint64_t slept = Processors::getThreadTime();
+    REQUIRE ( ( slept - spun ) < 50000 );
+  }
+}